@@ -358,6 +358,14 @@ PRODUCT_PACKAGES += \
 PRODUCT_PACKAGES += \
     vendor.qti.hardware.perf@2.2.vendor
 
+PRODUCT_PACKAGES += \
+    konaboostd \
+    konamemd \
+    konatuner
+
+PRODUCT_PACKAGES_DEBUG += \
+    konabootprof
+
 # Permissions
 PRODUCT_COPY_FILES += \
     $(LOCAL_PATH)/configs/permissions/hiddenapi-package-allowlist-product.xml:$(TARGET_COPY_OUT_PRODUCT)/etc/sysconfig/hotword-hiddenapi-package-allowlist.xml \
@@ -433,7 +441,8 @@ PRODUCT_PACKAGES += \
 
 # Touchscreen
 PRODUCT_PACKAGES += \
-    libtinyxml2
+    libtinyxml2 \
+    libxiaomitouch
 
 # USB
 PRODUCT_PACKAGES += \
@@ -454,6 +463,9 @@ PRODUCT_PACKAGES += \
 PRODUCT_PACKAGES += \
     vendor.qti.hardware.vibrator.service.xiaomi_umi
 
+PRODUCT_PACKAGES_DEBUG += \
+    vendor.qti.hardware.vibrator.replay.xiaomi_umi
+
 PRODUCT_COPY_FILES += \
     $(LOCAL_PATH)/vibrator/excluded-input-devices.xml:$(TARGET_COPY_OUT_VENDOR)/etc/excluded-input-devices.xml
 
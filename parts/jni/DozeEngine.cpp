@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "XiaomiParts-Doze"
+
+#include "DozeEngine.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PICKUP_SENSOR_TYPE "xiaomi.sensor.pickup"
+
+// SENSOR_DELAY_NORMAL, what the Java listeners asked for
+#define SAMPLING_PERIOD_US 200000
+// How long an event may wait in the hub FIFO before it has to be delivered
+#define MAX_REPORT_LATENCY_US 250000
+
+#define LOOPER_ID_SENSORS 1
+#define LOOPER_ID_STOP 2
+#define EVENT_BATCH 16
+
+// The clock sensor event timestamps are in
+static int64_t boottimeNs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+DozeEngine::DozeEngine(const std::string& packageName, DozeCallbacks callbacks)
+    : mManager(ASensorManager_getInstanceForPackage(packageName.c_str())),
+      mPickup(nullptr),
+      mProximity(nullptr),
+      mCallbacks(std::move(callbacks)),
+      mWakeups(0),
+      mEvents(0),
+      mGestures(0) {
+    ASensorList sensors;
+    int count = mManager ? ASensorManager_getSensorList(mManager, &sensors) : 0;
+
+    for (int i = 0; i < count; i++) {
+        const char* type = ASensor_getStringType(sensors[i]);
+        if (type && !strcmp(type, PICKUP_SENSOR_TYPE)) {
+            mPickup = sensors[i];
+            break;
+        }
+    }
+
+    if (mManager) {
+        mProximity = ASensorManager_getDefaultSensorEx(mManager, ASENSOR_TYPE_PROXIMITY, false);
+    }
+}
+
+DozeEngine::~DozeEngine() {
+    disable();
+}
+
+// Enabling it again picks up the new @config
+bool DozeEngine::enable(const DozeConfig& config, const std::string& recordPath) {
+    std::lock_guard<std::mutex> lock(mLock);
+    bool pickup = config.pickup && mPickup;
+    bool proximity = (config.handwave || config.pocket) && mProximity;
+
+    stopLocked();
+
+    if (!pickup && !proximity) {
+        LOG(ERROR) << "no doze sensor to enable";
+        return false;
+    }
+
+    mStopFd.reset(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    if (mStopFd.get() < 0) {
+        PLOG(ERROR) << "failed to create stop fd";
+        return false;
+    }
+
+    mRecordFd.reset();
+    if (!recordPath.empty()) {
+        mRecordFd.reset(TEMP_FAILURE_RETRY(
+                open(recordPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600)));
+        if (mRecordFd.get() < 0) {
+            PLOG(ERROR) << "failed to open " << recordPath << ", not recording";
+        }
+    }
+
+    std::promise<bool> registered;
+    std::future<bool> result = registered.get_future();
+
+    mThread = std::thread(&DozeEngine::threadLoop, this, config, std::move(registered));
+    if (!result.get()) {
+        // The thread is on its way out already
+        mThread.join();
+        mRecordFd.reset();
+        return false;
+    }
+
+    return true;
+}
+
+void DozeEngine::disable() {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    stopLocked();
+}
+
+DozeEngine::Stats DozeEngine::getStats() {
+    return {
+            .wakeups = mWakeups.load(std::memory_order_relaxed),
+            .events = mEvents.load(std::memory_order_relaxed),
+            .gestures = mGestures.load(std::memory_order_relaxed),
+    };
+}
+
+void DozeEngine::stopLocked() {
+    uint64_t one = 1;
+
+    if (!mThread.joinable()) {
+        return;
+    }
+
+    if (TEMP_FAILURE_RETRY(write(mStopFd.get(), &one, sizeof(one))) != sizeof(one)) {
+        PLOG(ERROR) << "failed to stop doze thread";
+    }
+    mThread.join();
+    mRecordFd.reset();
+
+    LOG(INFO) << "doze: " << mEvents.load() << " events in " << mWakeups.load() << " wakeups, "
+              << mGestures.load() << " gestures";
+}
+
+void DozeEngine::threadLoop(DozeConfig config, std::promise<bool> registered) {
+    DozeGestures gestures(config);
+    int sensors = 0;
+
+    if (mCallbacks.onThreadStart) {
+        mCallbacks.onThreadStart();
+    }
+
+    ALooper* looper = ALooper_prepare(0);
+    ASensorEventQueue* queue =
+            ASensorManager_createEventQueue(mManager, looper, LOOPER_ID_SENSORS, nullptr, nullptr);
+    if (!queue ||
+        ALooper_addFd(looper, mStopFd.get(), LOOPER_ID_STOP, ALOOPER_EVENT_INPUT, nullptr,
+                      nullptr) != 1) {
+        LOG(ERROR) << "failed to set up doze event loop";
+        registered.set_value(false);
+    } else {
+        if (config.pickup && mPickup) {
+            if (ASensorEventQueue_registerSensor(queue, mPickup, SAMPLING_PERIOD_US,
+                                                 MAX_REPORT_LATENCY_US) < 0) {
+                LOG(ERROR) << "failed to enable pickup sensor";
+            } else {
+                sensors++;
+            }
+        }
+        if ((config.handwave || config.pocket) && mProximity) {
+            if (ASensorEventQueue_registerSensor(queue, mProximity, SAMPLING_PERIOD_US,
+                                                 MAX_REPORT_LATENCY_US) < 0) {
+                LOG(ERROR) << "failed to enable proximity sensor";
+            } else {
+                sensors++;
+            }
+        }
+
+        // enable() waits for this, with nothing registered the caller falls back
+        registered.set_value(sensors > 0);
+
+        gestures.reset(boottimeNs());
+        while (sensors > 0) {
+            int ident = ALooper_pollOnce(-1, nullptr, nullptr, nullptr);
+
+            if (ident == LOOPER_ID_SENSORS) {
+                handleEvents(queue, gestures);
+            } else if (ident == LOOPER_ID_STOP || ident == ALOOPER_POLL_ERROR) {
+                break;
+            }
+        }
+
+        ALooper_removeFd(looper, mStopFd.get());
+    }
+
+    if (queue) {
+        // Also disables the sensors that are still registered
+        ASensorManager_destroyEventQueue(mManager, queue);
+    }
+
+    if (mCallbacks.onThreadExit) {
+        mCallbacks.onThreadExit();
+    }
+}
+
+// Everything the hub handed over in one go counts as a single wakeup
+void DozeEngine::handleEvents(ASensorEventQueue* queue, DozeGestures& gestures) {
+    ASensorEvent events[EVENT_BATCH];
+    ssize_t count;
+    bool delivered = false;
+
+    while ((count = ASensorEventQueue_getEvents(queue, events, EVENT_BATCH)) > 0) {
+        delivered = true;
+        mEvents += count;
+
+        for (ssize_t i = 0; i < count; i++) {
+            const ASensorEvent& event = events[i];
+            DozeGesture gesture;
+
+            record(event);
+            if (event.type == ASENSOR_TYPE_PROXIMITY) {
+                gesture = gestures.onProximity(event.timestamp, event.distance);
+            } else {
+                gesture = gestures.onPickup(event.timestamp, event.data[0]);
+            }
+
+            if (gesture != GESTURE_NONE) {
+                mGestures++;
+                mCallbacks.onGesture(gesture);
+            }
+        }
+    }
+
+    if (delivered) {
+        mWakeups++;
+    }
+}
+
+void DozeEngine::record(const ASensorEvent& event) {
+    if (mRecordFd.get() < 0) {
+        return;
+    }
+
+    bool proximity = event.type == ASENSOR_TYPE_PROXIMITY;
+    android::base::WriteStringToFd(
+            android::base::StringPrintf("%" PRId64 " %s %g\n", event.timestamp,
+                                        proximity ? "proximity" : "pickup",
+                                        proximity ? event.distance : event.data[0]),
+            mRecordFd.get());
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <android/looper.h>
+#include <android/sensor.h>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+#include "DozeGestures.h"
+
+struct DozeCallbacks {
+    // All of them run on the engine thread
+    std::function<void()> onThreadStart;
+    std::function<void(DozeGesture gesture)> onGesture;
+    std::function<void()> onThreadExit;
+};
+
+/*
+ * Runs the doze gestures on a thread of its own while the screen is off.
+ * The sensors are registered with a max report latency, so the hub can hold
+ * their events in its FIFO and hand them over in batches, and the app is
+ * only called when a gesture fires.
+ */
+class DozeEngine {
+  public:
+    struct Stats {
+        // Looper wakeups that delivered events
+        uint64_t wakeups;
+        uint64_t events;
+        uint64_t gestures;
+    };
+
+    DozeEngine(const std::string& packageName, DozeCallbacks callbacks);
+    ~DozeEngine();
+
+    // @recordPath gets every event in the format doze_replay reads, "" for none.
+    // Returns once the sensors are registered, false if none of them could be.
+    bool enable(const DozeConfig& config, const std::string& recordPath);
+    void disable();
+    Stats getStats();
+
+  private:
+    void stopLocked();
+    void threadLoop(DozeConfig config, std::promise<bool> registered);
+    void handleEvents(ASensorEventQueue* queue, DozeGestures& gestures);
+    void record(const ASensorEvent& event);
+
+    ASensorManager* mManager;
+    const ASensor* mPickup;
+    const ASensor* mProximity;
+    DozeCallbacks mCallbacks;
+
+    std::mutex mLock;
+    std::thread mThread;
+    android::base::unique_fd mStopFd;
+    android::base::unique_fd mRecordFd;
+    std::atomic<uint64_t> mWakeups;
+    std::atomic<uint64_t> mEvents;
+    std::atomic<uint64_t> mGestures;
+};
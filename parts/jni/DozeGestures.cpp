@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "DozeGestures.h"
+
+#define NS_PER_MS 1000000LL
+
+// Pickup events closer than this to the last one are dropped
+#define PICKUP_MIN_PULSE_INTERVAL_NS (2500 * NS_PER_MS)
+// Maximum time for the hand to cover the sensor
+#define HANDWAVE_MAX_DELTA_NS (1000 * NS_PER_MS)
+// Minimum time until the device is considered to have been in the pocket
+#define POCKET_MIN_DELTA_NS (2000 * NS_PER_MS)
+
+DozeGestures::DozeGestures(const DozeConfig& config)
+    : mConfig(config), mPickupEntryNs(0), mSawNear(false), mInPocketNs(0) {}
+
+void DozeGestures::reset(int64_t timestampNs) {
+    mPickupEntryNs = timestampNs;
+    mSawNear = false;
+    mInPocketNs = 0;
+}
+
+// Any event past the interval starts a new one, only a pickup pulses
+DozeGesture DozeGestures::onPickup(int64_t timestampNs, float value) {
+    if (!mConfig.pickup || timestampNs - mPickupEntryNs < PICKUP_MIN_PULSE_INTERVAL_NS) {
+        return GESTURE_NONE;
+    }
+
+    mPickupEntryNs = timestampNs;
+    return value == 1 ? GESTURE_PICKUP : GESTURE_NONE;
+}
+
+// Pulses when the sensor uncovers, how long it was covered tells a wave from a pocket
+DozeGesture DozeGestures::onProximity(int64_t timestampNs, float distance) {
+    bool near = distance < mConfig.proximityMaxRange;
+    DozeGesture gesture = GESTURE_NONE;
+
+    if (mSawNear && !near) {
+        int64_t delta = timestampNs - mInPocketNs;
+
+        if (mConfig.handwave && delta < HANDWAVE_MAX_DELTA_NS) {
+            gesture = GESTURE_HANDWAVE;
+        } else if (mConfig.pocket && (mConfig.handwave || delta >= POCKET_MIN_DELTA_NS)) {
+            gesture = GESTURE_POCKET;
+        }
+    } else {
+        mInPocketNs = timestampNs;
+    }
+
+    mSawNear = near;
+    return gesture;
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Mirrored by the GESTURE_* constants of NativeDozeEngine
+enum DozeGesture : int32_t {
+    GESTURE_NONE,
+    GESTURE_PICKUP,
+    GESTURE_HANDWAVE,
+    GESTURE_POCKET,
+};
+
+struct DozeConfig {
+    bool pickup;
+    bool handwave;
+    bool pocket;
+    // Proximity readings below it are near
+    float proximityMaxRange;
+};
+
+/*
+ * The pickup, handwave and pocket state machines of the doze service. They
+ * only look at the event timestamps, never at the time an event arrived, so
+ * batched events decide exactly like ones delivered one by one.
+ */
+class DozeGestures {
+  public:
+    explicit DozeGestures(const DozeConfig& config);
+
+    // When the sensors were enabled, in the clock of the event timestamps
+    void reset(int64_t timestampNs);
+    DozeGesture onPickup(int64_t timestampNs, float value);
+    DozeGesture onProximity(int64_t timestampNs, float distance);
+
+  private:
+    DozeConfig mConfig;
+    int64_t mPickupEntryNs;
+    bool mSawNear;
+    int64_t mInPocketNs;
+};
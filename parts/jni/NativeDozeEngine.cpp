@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "XiaomiParts-JNI"
+
+#include <android-base/logging.h>
+#include <jni.h>
+#include <iterator>
+#include <memory>
+
+#include "DozeEngine.h"
+
+#define NATIVE_DOZE_ENGINE_CLASS "org/lineageos/settings/sensors/NativeDozeEngine"
+
+static JavaVM* sVm;
+static jmethodID sOnGesture;
+
+// The engine thread of the instance, attached to the VM while it runs
+static thread_local JNIEnv* sThreadEnv;
+
+struct NativeDozeEngine {
+    jobject object;
+    std::unique_ptr<DozeEngine> engine;
+};
+
+static std::string toString(JNIEnv* env, jstring string) {
+    const char* chars = string ? env->GetStringUTFChars(string, nullptr) : nullptr;
+    std::string value = chars ? chars : "";
+
+    if (chars) {
+        env->ReleaseStringUTFChars(string, chars);
+    }
+
+    return value;
+}
+
+static void attachThread() {
+    JavaVMAttachArgs args = {JNI_VERSION_1_6, "DozeEngine", nullptr};
+
+    if (sVm->AttachCurrentThread(&sThreadEnv, &args) != JNI_OK) {
+        LOG(ERROR) << "failed to attach doze thread";
+        sThreadEnv = nullptr;
+    }
+}
+
+static void detachThread() {
+    if (sThreadEnv) {
+        sVm->DetachCurrentThread();
+        sThreadEnv = nullptr;
+    }
+}
+
+static jlong NativeDozeEngine_nativeCreate(JNIEnv* env, jobject thiz, jstring packageName) {
+    auto native = new NativeDozeEngine();
+    jobject object = env->NewGlobalRef(thiz);
+
+    native->object = object;
+    native->engine = std::make_unique<DozeEngine>(
+            toString(env, packageName),
+            DozeCallbacks{
+                    .onThreadStart = attachThread,
+                    .onGesture =
+                            [object](DozeGesture gesture) {
+                                if (!sThreadEnv) {
+                                    return;
+                                }
+
+                                sThreadEnv->CallVoidMethod(object, sOnGesture,
+                                                           static_cast<jint>(gesture));
+                                if (sThreadEnv->ExceptionCheck()) {
+                                    LOG(ERROR) << "exception in onGesture()";
+                                    sThreadEnv->ExceptionDescribe();
+                                    sThreadEnv->ExceptionClear();
+                                }
+                            },
+                    .onThreadExit = detachThread,
+            });
+
+    return reinterpret_cast<jlong>(native);
+}
+
+static jboolean NativeDozeEngine_nativeEnable(JNIEnv* env, jclass, jlong handle, jboolean pickup,
+                                              jboolean handwave, jboolean pocket,
+                                              jfloat proximityMaxRange, jstring recordPath) {
+    auto native = reinterpret_cast<NativeDozeEngine*>(handle);
+    DozeConfig config = {
+            .pickup = static_cast<bool>(pickup),
+            .handwave = static_cast<bool>(handwave),
+            .pocket = static_cast<bool>(pocket),
+            .proximityMaxRange = proximityMaxRange,
+    };
+
+    return native->engine->enable(config, toString(env, recordPath));
+}
+
+static void NativeDozeEngine_nativeDisable(JNIEnv*, jclass, jlong handle) {
+    reinterpret_cast<NativeDozeEngine*>(handle)->engine->disable();
+}
+
+// Wakeups, events and gestures since the engine was created
+static jlongArray NativeDozeEngine_nativeGetStats(JNIEnv* env, jclass, jlong handle) {
+    auto stats = reinterpret_cast<NativeDozeEngine*>(handle)->engine->getStats();
+    jlong values[] = {
+            static_cast<jlong>(stats.wakeups),
+            static_cast<jlong>(stats.events),
+            static_cast<jlong>(stats.gestures),
+    };
+    jlongArray result = env->NewLongArray(std::size(values));
+
+    if (result) {
+        env->SetLongArrayRegion(result, 0, std::size(values), values);
+    }
+
+    return result;
+}
+
+static void NativeDozeEngine_nativeDestroy(JNIEnv* env, jclass, jlong handle) {
+    auto native = reinterpret_cast<NativeDozeEngine*>(handle);
+
+    // Joins the thread before the object it calls goes away
+    native->engine.reset();
+    env->DeleteGlobalRef(native->object);
+    delete native;
+}
+
+static const JNINativeMethod kMethods[] = {
+        {"nativeCreate", "(Ljava/lang/String;)J",
+         reinterpret_cast<void*>(NativeDozeEngine_nativeCreate)},
+        {"nativeEnable", "(JZZZFLjava/lang/String;)Z",
+         reinterpret_cast<void*>(NativeDozeEngine_nativeEnable)},
+        {"nativeDisable", "(J)V", reinterpret_cast<void*>(NativeDozeEngine_nativeDisable)},
+        {"nativeGetStats", "(J)[J", reinterpret_cast<void*>(NativeDozeEngine_nativeGetStats)},
+        {"nativeDestroy", "(J)V", reinterpret_cast<void*>(NativeDozeEngine_nativeDestroy)},
+};
+
+int register_NativeDozeEngine(JNIEnv* env, JavaVM* vm) {
+    jclass clazz = env->FindClass(NATIVE_DOZE_ENGINE_CLASS);
+
+    sVm = vm;
+    if (!clazz || !(sOnGesture = env->GetMethodID(clazz, "onGesture", "(I)V")) ||
+        env->RegisterNatives(clazz, kMethods, std::size(kMethods)) < 0) {
+        LOG(ERROR) << "failed to register natives of " << NATIVE_DOZE_ENGINE_CLASS;
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "XiaomiParts-JNI"
+
+#include <Sysfs.h>
+#include <android-base/logging.h>
+#include <jni.h>
+#include <iterator>
+
+#define NATIVE_SYSFS_CLASS "org/lineageos/settings/utils/NativeSysfs"
+
+using xiaomi::Sysfs;
+
+static std::string toString(JNIEnv* env, jstring string) {
+    const char* chars = string ? env->GetStringUTFChars(string, nullptr) : nullptr;
+    std::string value = chars ? chars : "";
+
+    if (chars) {
+        env->ReleaseStringUTFChars(string, chars);
+    }
+
+    return value;
+}
+
+static jstring NativeSysfs_read(JNIEnv* env, jclass, jstring path) {
+    std::string value;
+
+    if (!Sysfs::getInstance().read(toString(env, path), &value)) {
+        return nullptr;
+    }
+
+    return env->NewStringUTF(value.c_str());
+}
+
+static jboolean NativeSysfs_write(JNIEnv* env, jclass, jstring path, jstring value) {
+    return Sysfs::getInstance().write(toString(env, path), toString(env, value));
+}
+
+static const JNINativeMethod kMethods[] = {
+        {"read", "(Ljava/lang/String;)Ljava/lang/String;",
+         reinterpret_cast<void*>(NativeSysfs_read)},
+        {"write", "(Ljava/lang/String;Ljava/lang/String;)Z",
+         reinterpret_cast<void*>(NativeSysfs_write)},
+};
+
+int register_NativeSysfs(JNIEnv* env) {
+    jclass clazz = env->FindClass(NATIVE_SYSFS_CLASS);
+
+    if (!clazz || env->RegisterNatives(clazz, kMethods, std::size(kMethods)) < 0) {
+        LOG(ERROR) << "failed to register natives of " << NATIVE_SYSFS_CLASS;
+        return -1;
+    }
+
+    return 0;
+}
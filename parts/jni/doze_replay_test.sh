@@ -0,0 +1,12 @@
+#!/bin/bash
+#
+# Copyright (C) 2026 The LineageOS Project
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+
+# Replays the recorded session and checks the gestures it decides
+dir="$(dirname "$0")"
+
+exec "$dir/doze_replay" --pickup --handwave --pocket \
+    --expect "$dir/testdata/doze_gestures.expected" "$dir/testdata/doze_gestures.rec"
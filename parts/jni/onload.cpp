@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <jni.h>
+
+int register_NativeSysfs(JNIEnv* env);
+int register_NativeDozeEngine(JNIEnv* env, JavaVM* vm);
+
+jint JNI_OnLoad(JavaVM* vm, void*) {
+    JNIEnv* env;
+
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+
+    if (register_NativeSysfs(env) < 0 || register_NativeDozeEngine(env, vm) < 0) {
+        return JNI_ERR;
+    }
+
+    return JNI_VERSION_1_6;
+}
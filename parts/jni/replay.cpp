@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Feeds a recording of the doze engine through the gesture state machines,
+ * to see what a change to them decides and what it costs per event. With
+ * --expect the decisions must match a file in the format printed here.
+ */
+
+#include <android-base/file.h>
+#include <android-base/parseint.h>
+#include <android-base/strings.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#include "DozeGestures.h"
+
+enum SensorKind { SENSOR_PICKUP, SENSOR_PROXIMITY };
+
+struct RecordedEvent {
+    int64_t timestampNs;
+    SensorKind sensor;
+    float value;
+};
+
+struct Decision {
+    int64_t timestampNs;
+    DozeGesture gesture;
+
+    bool operator==(const Decision& other) const {
+        return timestampNs == other.timestampNs && gesture == other.gesture;
+    }
+};
+
+static const char* const kGestureNames[] = {"none", "pickup", "handwave", "pocket"};
+
+static int64_t nowNs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "usage: %s [--pickup] [--handwave] [--pocket] [--max-range <cm>] [--repeat <n>] "
+            "[--expect <gestures>] <recording>\n",
+            name);
+}
+
+// Lines of "<timestamp ns> pickup|proximity <value>", '#' starts a comment
+static bool parseRecording(const std::string& path, std::vector<RecordedEvent>* events) {
+    std::string content;
+    int lineNumber = 0;
+
+    if (!android::base::ReadFileToString(path, &content)) {
+        fprintf(stderr, "failed to read %s\n", path.c_str());
+        return false;
+    }
+
+    for (const auto& line : android::base::Split(content, "\n")) {
+        auto fields = android::base::Tokenize(line, " \t");
+        RecordedEvent event;
+        char* end;
+
+        lineNumber++;
+        if (fields.empty() || android::base::StartsWith(fields[0], "#")) {
+            continue;
+        }
+
+        if (fields.size() != 3 || !android::base::ParseInt(fields[0], &event.timestampNs)) {
+            fprintf(stderr, "%s:%d: malformed event\n", path.c_str(), lineNumber);
+            return false;
+        }
+
+        if (fields[1] == "pickup") {
+            event.sensor = SENSOR_PICKUP;
+        } else if (fields[1] == "proximity") {
+            event.sensor = SENSOR_PROXIMITY;
+        } else {
+            fprintf(stderr, "%s:%d: unknown sensor %s\n", path.c_str(), lineNumber,
+                    fields[1].c_str());
+            return false;
+        }
+
+        event.value = strtof(fields[2].c_str(), &end);
+        if (*end) {
+            fprintf(stderr, "%s:%d: bad value %s\n", path.c_str(), lineNumber,
+                    fields[2].c_str());
+            return false;
+        }
+
+        events->push_back(event);
+    }
+
+    return true;
+}
+
+// Lines of "<timestamp ns> <gesture>", what replay() prints
+static bool parseExpected(const std::string& path, std::vector<Decision>* decisions) {
+    std::string content;
+    int lineNumber = 0;
+
+    if (!android::base::ReadFileToString(path, &content)) {
+        fprintf(stderr, "failed to read %s\n", path.c_str());
+        return false;
+    }
+
+    for (const auto& line : android::base::Split(content, "\n")) {
+        auto fields = android::base::Tokenize(line, " \t");
+        Decision decision = {0, GESTURE_NONE};
+
+        lineNumber++;
+        if (fields.empty() || android::base::StartsWith(fields[0], "#")) {
+            continue;
+        }
+
+        if (fields.size() == 2) {
+            for (int i = GESTURE_PICKUP; i <= GESTURE_POCKET; i++) {
+                if (fields[1] == kGestureNames[i]) {
+                    decision.gesture = static_cast<DozeGesture>(i);
+                }
+            }
+        }
+
+        if (decision.gesture == GESTURE_NONE ||
+            !android::base::ParseInt(fields[0], &decision.timestampNs)) {
+            fprintf(stderr, "%s:%d: malformed gesture\n", path.c_str(), lineNumber);
+            return false;
+        }
+
+        decisions->push_back(decision);
+    }
+
+    return true;
+}
+
+// Recordings start at enable, the first event stands in for its time
+static int replay(const DozeConfig& config, const std::vector<RecordedEvent>& events,
+                  bool print, std::vector<Decision>* decisions = nullptr) {
+    DozeGestures gestures(config);
+    int count = 0;
+
+    gestures.reset(events.empty() ? 0 : events[0].timestampNs);
+    for (const auto& event : events) {
+        DozeGesture gesture = event.sensor == SENSOR_PROXIMITY
+                                      ? gestures.onProximity(event.timestampNs, event.value)
+                                      : gestures.onPickup(event.timestampNs, event.value);
+
+        if (gesture == GESTURE_NONE) {
+            continue;
+        }
+
+        count++;
+        if (print) {
+            printf("%" PRId64 " %s\n", event.timestampNs, kGestureNames[gesture]);
+        }
+        if (decisions) {
+            decisions->push_back({event.timestampNs, gesture});
+        }
+    }
+
+    return count;
+}
+
+int main(int argc, char** argv) {
+    static const struct option kOptions[] = {
+            {"pickup", no_argument, nullptr, 'p'},
+            {"handwave", no_argument, nullptr, 'w'},
+            {"pocket", no_argument, nullptr, 'k'},
+            {"max-range", required_argument, nullptr, 'r'},
+            {"repeat", required_argument, nullptr, 'n'},
+            {"expect", required_argument, nullptr, 'e'},
+            {nullptr, 0, nullptr, 0},
+    };
+    DozeConfig config = {false, false, false, 5.0f};
+    std::vector<RecordedEvent> events;
+    std::vector<Decision> decisions;
+    std::vector<Decision> expected;
+    const char* expectPath = nullptr;
+    int repeat = 1;
+    int gestures = 0;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "", kOptions, nullptr)) != -1) {
+        switch (opt) {
+            case 'p':
+                config.pickup = true;
+                break;
+            case 'w':
+                config.handwave = true;
+                break;
+            case 'k':
+                config.pocket = true;
+                break;
+            case 'r': {
+                char* end;
+                config.proximityMaxRange = strtof(optarg, &end);
+                if (*end || config.proximityMaxRange <= 0) {
+                    usage(argv[0]);
+                    return 2;
+                }
+                break;
+            }
+            case 'n':
+                if (!android::base::ParseInt(optarg, &repeat, 1)) {
+                    usage(argv[0]);
+                    return 2;
+                }
+                break;
+            case 'e':
+                expectPath = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (!parseRecording(argv[optind], &events) ||
+        (expectPath && !parseExpected(expectPath, &expected))) {
+        return 1;
+    }
+
+    gestures = replay(config, events, true, &decisions);
+
+    // Timed apart from the printing pass
+    int64_t startNs = nowNs();
+    for (int i = 0; i < repeat; i++) {
+        replay(config, events, false);
+    }
+    int64_t elapsedNs = nowNs() - startNs;
+    size_t total = events.size() * repeat;
+
+    printf("%zu events, %d gestures, %.1f ns/event\n", events.size(), gestures,
+           total ? static_cast<double>(elapsedNs) / total : 0.0);
+
+    if (expectPath && decisions != expected) {
+        fprintf(stderr, "gestures differ from %s, %zu expected\n", expectPath,
+                expected.size());
+        return 1;
+    }
+
+    return 0;
+}
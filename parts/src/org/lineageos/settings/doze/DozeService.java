@@ -25,6 +25,7 @@ import android.content.IntentFilter;
 import android.os.IBinder;
 import android.util.Log;
 
+import org.lineageos.settings.sensors.NativeDozeEngine;
 import org.lineageos.settings.sensors.PickupSensor;
 import org.lineageos.settings.sensors.ProximitySensor;
 
@@ -32,6 +33,7 @@ public class DozeService extends Service {
     private static final String TAG = "DozeService";
     private static final boolean DEBUG = false;
 
+    private NativeDozeEngine mDozeEngine;
     private ProximitySensor mProximitySensor;
     private PickupSensor mPickupSensor;
     private BroadcastReceiver mScreenStateReceiver = new BroadcastReceiver() {
@@ -48,6 +50,9 @@ public class DozeService extends Service {
     @Override
     public void onCreate() {
         if (DEBUG) Log.d(TAG, "Creating service");
+        if (NativeDozeEngine.isAvailable()) {
+            mDozeEngine = new NativeDozeEngine(this);
+        }
         mProximitySensor = new ProximitySensor(this);
         mPickupSensor = new PickupSensor(this);
 
@@ -68,6 +73,9 @@ public class DozeService extends Service {
         if (DEBUG) Log.d(TAG, "Destroying service");
         super.onDestroy();
         this.unregisterReceiver(mScreenStateReceiver);
+        if (mDozeEngine != null) {
+            mDozeEngine.destroy();
+        }
         mProximitySensor.disable();
         mPickupSensor.disable();
     }
@@ -79,6 +87,9 @@ public class DozeService extends Service {
 
     private void onDisplayOn() {
         if (DEBUG) Log.d(TAG, "Display on");
+        if (mDozeEngine != null) {
+            mDozeEngine.disable();
+        }
         if (DozeUtils.isPickUpEnabled(this)) {
             mPickupSensor.disable();
         }
@@ -90,6 +101,9 @@ public class DozeService extends Service {
 
     private void onDisplayOff() {
         if (DEBUG) Log.d(TAG, "Display off");
+        if (mDozeEngine != null && mDozeEngine.enable()) {
+            return;
+        }
         if (DozeUtils.isPickUpEnabled(this)) {
             mPickupSensor.enable();
         }
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package org.lineageos.settings.sensors;
+
+import android.content.Context;
+import android.hardware.Sensor;
+import android.hardware.SensorManager;
+import android.util.Log;
+
+import org.lineageos.settings.doze.DozeUtils;
+
+import java.io.File;
+
+/**
+ * The pickup, handwave and pocket gestures, run by a native thread with the
+ * sensors batched in the hub FIFO. Only a gesture calls back into Java.
+ */
+public class NativeDozeEngine {
+    private static final String TAG = "NativeDozeEngine";
+
+    // Mirror DozeGesture of DozeGestures.h
+    public static final int GESTURE_PICKUP = 1;
+    public static final int GESTURE_HANDWAVE = 2;
+    public static final int GESTURE_POCKET = 3;
+
+    // Every event is appended to it while debug logging is on, doze_replay reads it
+    private static final String RECORDING = "doze.rec";
+
+    private static final boolean sAvailable;
+
+    static {
+        boolean available = false;
+        try {
+            System.loadLibrary("xiaomiparts_jni");
+            available = true;
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Could not load xiaomiparts_jni, using the Java sensors", e);
+        }
+        sAvailable = available;
+    }
+
+    private Context mContext;
+    private float mProximityMaxRange;
+    private long mHandle;
+
+    public NativeDozeEngine(Context context) {
+        mContext = context;
+        SensorManager sensorManager = context.getSystemService(SensorManager.class);
+        Sensor proximity = sensorManager.getDefaultSensor(Sensor.TYPE_PROXIMITY, false);
+        mProximityMaxRange = proximity != null ? proximity.getMaximumRange() : 0;
+        mHandle = nativeCreate(context.getPackageName());
+    }
+
+    public static boolean isAvailable() {
+        return sAvailable;
+    }
+
+    /**
+     * Starts the gestures enabled in the doze settings, or picks up changes to them
+     *
+     * @return false if none of their sensors could be enabled
+     */
+    public boolean enable() {
+        String recording = Log.isLoggable(TAG, Log.DEBUG) ?
+                new File(mContext.getFilesDir(), RECORDING).getPath() : "";
+
+        return nativeEnable(mHandle, DozeUtils.isPickUpEnabled(mContext),
+                DozeUtils.isHandwaveGestureEnabled(mContext),
+                DozeUtils.isPocketGestureEnabled(mContext), mProximityMaxRange, recording);
+    }
+
+    public void disable() {
+        nativeDisable(mHandle);
+        if (Log.isLoggable(TAG, Log.DEBUG)) {
+            long[] stats = nativeGetStats(mHandle);
+            Log.d(TAG, stats[1] + " events in " + stats[0] + " wakeups, " +
+                    stats[2] + " gestures");
+        }
+    }
+
+    public void destroy() {
+        if (mHandle != 0) {
+            nativeDestroy(mHandle);
+            mHandle = 0;
+        }
+    }
+
+    // Called on the engine thread
+    private void onGesture(int gesture) {
+        DozeUtils.launchDozePulse(mContext);
+    }
+
+    private native long nativeCreate(String packageName);
+
+    private static native boolean nativeEnable(long handle, boolean pickup, boolean handwave,
+            boolean pocket, float proximityMaxRange, String recordPath);
+
+    private static native void nativeDisable(long handle);
+
+    private static native long[] nativeGetStats(long handle);
+
+    private static native void nativeDestroy(long handle);
+}
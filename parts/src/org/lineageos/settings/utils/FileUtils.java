@@ -28,6 +28,7 @@ import java.io.IOException;
 
 public final class FileUtils {
     private static final String TAG = "FileUtils";
+    private static final String SYSFS_PREFIX = "/sys/";
 
     private FileUtils() {
         // This class is not supposed to be instantiated
@@ -44,6 +45,16 @@ public final class FileUtils {
         String line = null;
         BufferedReader reader = null;
 
+        if (isSysfsNode(fileName)) {
+            line = NativeSysfs.read(fileName);
+            if (line == null) {
+                Log.e(TAG, "Could not read from file " + fileName);
+                return null;
+            }
+            int newline = line.indexOf('\n');
+            return newline < 0 ? line : line.substring(0, newline);
+        }
+
         try {
             reader = new BufferedReader(new FileReader(fileName), 512);
             line = reader.readLine();
@@ -72,6 +83,14 @@ public final class FileUtils {
     public static boolean writeLine(String fileName, String value) {
         BufferedWriter writer = null;
 
+        if (isSysfsNode(fileName)) {
+            if (!NativeSysfs.write(fileName, value)) {
+                Log.e(TAG, "Could not write to file " + fileName);
+                return false;
+            }
+            return true;
+        }
+
         try {
             writer = new BufferedWriter(new FileWriter(fileName));
             writer.write(value);
@@ -94,6 +113,14 @@ public final class FileUtils {
         return true;
     }
 
+    /**
+     * Sysfs nodes go through the fds NativeSysfs keeps open instead of being
+     * opened and closed on every access
+     */
+    private static boolean isSysfsNode(String fileName) {
+        return fileName.startsWith(SYSFS_PREFIX) && NativeSysfs.isAvailable();
+    }
+
     /**
      * Checks whether the given file exists
      *
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+package org.lineageos.settings.utils;
+
+import android.util.Log;
+
+/**
+ * Sysfs access through libxiaomisysfs, which keeps the fds of the nodes it
+ * touched open and reads and writes them with pread() and pwrite().
+ */
+public final class NativeSysfs {
+    private static final String TAG = "NativeSysfs";
+
+    private static final boolean sAvailable;
+
+    static {
+        boolean available = false;
+        try {
+            System.loadLibrary("xiaomiparts_jni");
+            available = true;
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Could not load xiaomiparts_jni, using plain file I/O", e);
+        }
+        sAvailable = available;
+    }
+
+    private NativeSysfs() {
+        // This class is not supposed to be instantiated
+    }
+
+    public static boolean isAvailable() {
+        return sAvailable;
+    }
+
+    /**
+     * @return the value with trailing whitespace stripped, or null on failure
+     */
+    public static native String read(String path);
+
+    public static native boolean write(String path, String value);
+}
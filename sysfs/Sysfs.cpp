@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "libxiaomisysfs"
+
+#include "Sysfs.h"
+
+#include <android-base/logging.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+// sysfs hands out at most a page per attribute
+#define SYSFS_BUF_SIZE 4096
+#define MAX_EVENTS 8
+#define STOP_ID UINT32_MAX
+
+namespace xiaomi {
+
+static int64_t nowNs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// pread() rewinds and reads in one go, and re-arms sysfs_notify() for the fd
+static bool readValue(int fd, std::string* value) {
+    char buf[SYSFS_BUF_SIZE];
+    ssize_t len = TEMP_FAILURE_RETRY(pread(fd, buf, sizeof(buf), 0));
+
+    if (len < 0) {
+        return false;
+    }
+
+    while (len > 0 && isspace(static_cast<unsigned char>(buf[len - 1]))) {
+        len--;
+    }
+    value->assign(buf, len);
+    return true;
+}
+
+Sysfs& Sysfs::getInstance() {
+    static Sysfs instance;
+
+    return instance;
+}
+
+Sysfs::Sysfs()
+    : mNextWatch(0), mReads{}, mWrites{}, mFailed(0), mOpens(0), mNotifications(0) {}
+
+Sysfs::~Sysfs() {
+    uint64_t one = 1;
+
+    if (!mWatchThread.joinable()) {
+        return;
+    }
+
+    if (TEMP_FAILURE_RETRY(::write(mStopFd.get(), &one, sizeof(one))) != sizeof(one)) {
+        PLOG(ERROR) << "failed to stop watch thread";
+        mWatchThread.detach();
+        return;
+    }
+    mWatchThread.join();
+}
+
+bool Sysfs::read(const std::string& path, std::string* value) {
+    std::shared_ptr<Node> node;
+    int64_t start = nowNs();
+    int fd = nodeFd(path, false, &node);
+    bool ok = fd >= 0 && readValue(fd, value);
+
+    if (!ok) {
+        if (fd >= 0) {
+            PLOG(ERROR) << "failed to read " << path;
+        }
+        fail(path);
+        value->clear();
+    }
+
+    record(mReads, start);
+    return ok;
+}
+
+bool Sysfs::write(const std::string& path, const std::string& value) {
+    std::shared_ptr<Node> node;
+    int64_t start = nowNs();
+    int fd = nodeFd(path, true, &node);
+    bool ok = fd >= 0 &&
+              TEMP_FAILURE_RETRY(pwrite(fd, value.data(), value.size(), 0)) ==
+                      static_cast<ssize_t>(value.size());
+
+    if (!ok) {
+        if (fd >= 0) {
+            PLOG(ERROR) << "failed to write " << value << " to " << path;
+        }
+        fail(path);
+    }
+
+    record(mWrites, start);
+    return ok;
+}
+
+void Sysfs::forget(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    mNodes.erase(path);
+}
+
+/*
+ * Every watch opens a fd of its own, the cached ones may be read by anyone
+ * and each read would consume the notification. unwatch() waits for a
+ * callback that is already running, so the callback may use state that is
+ * torn down right after.
+ */
+int Sysfs::watch(const std::string& path, Callback callback) {
+    auto watch = std::make_shared<Watch>();
+    std::string value;
+
+    watch->path = path;
+    watch->callback = std::move(callback);
+    watch->fd.reset(TEMP_FAILURE_RETRY(open(path.c_str(), O_RDONLY | O_CLOEXEC)));
+    if (watch->fd.get() < 0) {
+        PLOG(ERROR) << "failed to open " << path;
+        return -1;
+    }
+    mOpens++;
+
+    // sysfs_notify() only wakes up fds that read the node before
+    if (!readValue(watch->fd.get(), &value)) {
+        PLOG(ERROR) << "failed to read " << path;
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    if (!startWatchThread()) {
+        return -1;
+    }
+
+    int id = mNextWatch++;
+    struct epoll_event ev = {
+            .events = EPOLLPRI | EPOLLERR,
+            .data = {.u32 = static_cast<uint32_t>(id)},
+    };
+    if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, watch->fd.get(), &ev) < 0) {
+        PLOG(ERROR) << "failed to watch " << path;
+        return -1;
+    }
+
+    mWatches[id] = std::move(watch);
+    return id;
+}
+
+void Sysfs::unwatch(int id) {
+    std::shared_ptr<Watch> watch;
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = mWatches.find(id);
+
+        if (it == mWatches.end()) {
+            return;
+        }
+
+        if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_DEL, it->second->fd.get(), nullptr) < 0) {
+            PLOG(ERROR) << "failed to unwatch " << it->second->path;
+        }
+        watch = std::move(it->second);
+        mWatches.erase(it);
+    }
+
+    if (std::this_thread::get_id() != mWatchThread.get_id()) {
+        std::lock_guard<std::mutex> lock(watch->callbackLock);
+        watch->removed = true;
+    }
+}
+
+Sysfs::Stats Sysfs::getStats() {
+    return {
+            .reads = mReads.count.load(std::memory_order_relaxed),
+            .writes = mWrites.count.load(std::memory_order_relaxed),
+            .failed = mFailed.load(std::memory_order_relaxed),
+            .opens = mOpens.load(std::memory_order_relaxed),
+            .notifications = mNotifications.load(std::memory_order_relaxed),
+            .readUs = mReads.totalUs.load(std::memory_order_relaxed),
+            .writeUs = mWrites.totalUs.load(std::memory_order_relaxed),
+            .maxReadUs = mReads.maxUs.load(std::memory_order_relaxed),
+            .maxWriteUs = mWrites.maxUs.load(std::memory_order_relaxed),
+    };
+}
+
+// The node's fd for one direction, opened on first use; @node keeps it open
+int Sysfs::nodeFd(const std::string& path, bool write, std::shared_ptr<Node>* node) {
+    std::lock_guard<std::mutex> lock(mLock);
+    auto& entry = mNodes[path];
+
+    if (!entry) {
+        entry = std::make_shared<Node>();
+    }
+
+    auto& fd = write ? entry->writeFd : entry->readFd;
+    if (fd.get() < 0) {
+        fd.reset(TEMP_FAILURE_RETRY(open(path.c_str(), (write ? O_WRONLY : O_RDONLY) | O_CLOEXEC)));
+        if (fd.get() < 0) {
+            // Absent nodes are probed for, only report real trouble
+            if (errno != ENOENT) {
+                PLOG(ERROR) << "failed to open " << path;
+            }
+            return -1;
+        }
+        mOpens++;
+    }
+
+    *node = entry;
+    return fd.get();
+}
+
+// A node whose device went away is opened again on the next access
+void Sysfs::fail(const std::string& path) {
+    mFailed++;
+    if (errno == ENODEV) {
+        forget(path);
+    }
+}
+
+void Sysfs::record(Counter& counter, int64_t startNs) {
+    uint64_t us = (nowNs() - startNs) / 1000;
+    uint64_t max = counter.maxUs.load(std::memory_order_relaxed);
+
+    counter.count.fetch_add(1, std::memory_order_relaxed);
+    counter.totalUs.fetch_add(us, std::memory_order_relaxed);
+    while (us > max && !counter.maxUs.compare_exchange_weak(max, us, std::memory_order_relaxed))
+        ;
+}
+
+// Called with mLock held
+bool Sysfs::startWatchThread() {
+    struct epoll_event ev = {
+            .events = EPOLLIN,
+            .data = {.u32 = STOP_ID},
+    };
+
+    if (mWatchThread.joinable()) {
+        return true;
+    }
+
+    mEpollFd.reset(epoll_create1(EPOLL_CLOEXEC));
+    mStopFd.reset(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    if (mEpollFd.get() < 0 || mStopFd.get() < 0) {
+        PLOG(ERROR) << "failed to create watch fds";
+        return false;
+    }
+
+    if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, mStopFd.get(), &ev) < 0) {
+        PLOG(ERROR) << "failed to watch stop fd";
+        return false;
+    }
+
+    mWatchThread = std::thread(&Sysfs::watchLoop, this);
+    return true;
+}
+
+void Sysfs::watchLoop() {
+    struct epoll_event events[MAX_EVENTS];
+
+    while (true) {
+        int count = TEMP_FAILURE_RETRY(epoll_wait(mEpollFd.get(), events, MAX_EVENTS, -1));
+        if (count < 0) {
+            PLOG(ERROR) << "failed to wait for sysfs events";
+            return;
+        }
+
+        for (int i = 0; i < count; i++) {
+            std::shared_ptr<Watch> watch;
+            std::string value;
+
+            if (events[i].data.u32 == STOP_ID) {
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mLock);
+                auto it = mWatches.find(events[i].data.u32);
+                if (it == mWatches.end()) {
+                    continue;
+                }
+                watch = it->second;
+            }
+
+            if (!readValue(watch->fd.get(), &value)) {
+                PLOG(ERROR) << "failed to read " << watch->path << ", no longer watching it";
+                mFailed++;
+                // A node that went away would keep reporting EPOLLERR
+                unwatch(events[i].data.u32);
+                continue;
+            }
+
+            mNotifications++;
+            std::lock_guard<std::mutex> lock(watch->callbackLock);
+            if (!watch->removed) {
+                watch->callback(value);
+            }
+        }
+    }
+}
+
+}  // namespace xiaomi
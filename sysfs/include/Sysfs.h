@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace xiaomi {
+
+/*
+ * Sysfs access for the whole process. Every node keeps the fds it was
+ * opened with, and reads and writes go through pread() and pwrite() at
+ * offset 0, so a hot node costs a single syscall. Call forget() when a node
+ * may have gone away with its device, the next access opens it again.
+ */
+class Sysfs {
+  public:
+    // Run on the shared watch thread with the value the node changed to
+    using Callback = std::function<void(const std::string& value)>;
+
+    struct Stats {
+        uint64_t reads;
+        uint64_t writes;
+        uint64_t failed;
+        uint64_t opens;
+        uint64_t notifications;
+        uint64_t readUs;
+        uint64_t writeUs;
+        uint64_t maxReadUs;
+        uint64_t maxWriteUs;
+    };
+
+    static Sysfs& getInstance();
+
+    ~Sysfs();
+
+    // Trailing whitespace is stripped
+    bool read(const std::string& path, std::string* value);
+    bool write(const std::string& path, const std::string& value);
+    void forget(const std::string& path);
+
+    // For nodes the driver calls sysfs_notify() on, returns -1 on failure
+    int watch(const std::string& path, Callback callback);
+    // No callback for @id runs once it returns, unless called from that callback
+    void unwatch(int id);
+
+    Stats getStats();
+
+  private:
+    struct Node {
+        android::base::unique_fd readFd;
+        android::base::unique_fd writeFd;
+    };
+
+    struct Watch {
+        std::string path;
+        android::base::unique_fd fd;
+        Callback callback;
+        // Held while the callback runs, so unwatch() can wait for it
+        std::mutex callbackLock;
+        bool removed = false;
+    };
+
+    struct Counter {
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> totalUs;
+        std::atomic<uint64_t> maxUs;
+    };
+
+    Sysfs();
+
+    int nodeFd(const std::string& path, bool write, std::shared_ptr<Node>* node);
+    void fail(const std::string& path);
+    void record(Counter& counter, int64_t startNs);
+    bool startWatchThread();
+    void watchLoop();
+
+    std::mutex mLock;
+    std::unordered_map<std::string, std::shared_ptr<Node>> mNodes;
+    std::unordered_map<int, std::shared_ptr<Watch>> mWatches;
+    int mNextWatch;
+    android::base::unique_fd mEpollFd;
+    android::base::unique_fd mStopFd;
+    std::thread mWatchThread;
+    Counter mReads;
+    Counter mWrites;
+    std::atomic<uint64_t> mFailed;
+    std::atomic<uint64_t> mOpens;
+    std::atomic<uint64_t> mNotifications;
+};
+
+}  // namespace xiaomi
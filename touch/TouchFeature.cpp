@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "libxiaomitouch"
+
+#include "TouchFeature.h"
+
+#include <Sysfs.h>
+#include <android-base/logging.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+// Prefixed to the node, the udfps host harness points it at a fake one
+#ifndef FS_ROOT
+#define FS_ROOT ""
+#endif
+
+#define TOUCH_DEV_PATH FS_ROOT "/dev/xiaomi-touch"
+// Notified with 1 on suspend and 0 on resume
+#define TOUCH_SUSPEND_PATH FS_ROOT "/sys/devices/virtual/touch/touch_dev/touch_suspend_notify"
+#define TOUCH_MAGIC 0x5400
+#define TOUCH_IOC_SETMODE TOUCH_MAGIC + 0
+
+namespace xiaomi {
+
+TouchFeature& TouchFeature::getInstance() {
+    static TouchFeature instance;
+
+    return instance;
+}
+
+// The firmware comes out of a resume with its defaults, the mirror can't vouch for it
+TouchFeature::TouchFeature() : mSuspendWatch(-1), mStats{} {
+    if (access(TOUCH_SUSPEND_PATH, F_OK) < 0) {
+        LOG(INFO) << "no " << TOUCH_SUSPEND_PATH << ", touch modes are kept across resume";
+        return;
+    }
+
+    mSuspendWatch = Sysfs::getInstance().watch(TOUCH_SUSPEND_PATH,
+                                               [this](const std::string& value) {
+                                                   if (value == "0") {
+                                                       invalidate();
+                                                   }
+                                               });
+}
+
+TouchFeature::~TouchFeature() {
+    if (mSuspendWatch >= 0) {
+        Sysfs::getInstance().unwatch(mSuspendWatch);
+    }
+}
+
+bool TouchFeature::setMode(int mode, int value, bool* issued) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    return setModeLocked(mode, value, issued);
+}
+
+/*
+ * Applies @modes in order under a single lock, so no other client can
+ * interleave its own changes. A mode listed more than once only gets its
+ * last value. Every mode is attempted even if an earlier one failed.
+ */
+bool TouchFeature::setModes(const std::vector<std::pair<int, int>>& modes) {
+    std::lock_guard<std::mutex> lock(mLock);
+    bool ok = true;
+
+    for (size_t i = 0; i < modes.size(); i++) {
+        bool superseded = false;
+
+        for (size_t j = i + 1; j < modes.size(); j++) {
+            if (modes[j].first == modes[i].first) {
+                superseded = true;
+                break;
+            }
+        }
+
+        if (superseded) {
+            mStats.skipped++;
+            continue;
+        }
+
+        ok &= setModeLocked(modes[i].first, modes[i].second, nullptr);
+    }
+
+    return ok;
+}
+
+// The value last written to @mode, none if it was never written or the write failed
+std::optional<int> TouchFeature::getMode(int mode) {
+    std::lock_guard<std::mutex> lock(mLock);
+    auto it = mModes.find(mode);
+
+    if (it == mModes.end()) {
+        return std::nullopt;
+    }
+
+    return it->second;
+}
+
+void TouchFeature::invalidate() {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    mModes.clear();
+}
+
+TouchFeature::Stats TouchFeature::getStats() {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    return mStats;
+}
+
+bool TouchFeature::setModeLocked(int mode, int value, bool* issued) {
+    int arg[2] = {mode, value};
+    auto it = mModes.find(mode);
+
+    if (issued) {
+        *issued = false;
+    }
+
+    if (it != mModes.end() && it->second == value) {
+        mStats.skipped++;
+        return true;
+    }
+
+    // The node shows up late during boot, keep trying on later writes
+    if (mFd.get() < 0) {
+        mFd.reset(open(TOUCH_DEV_PATH, O_RDWR | O_CLOEXEC));
+        if (mFd.get() < 0) {
+            PLOG(ERROR) << "failed to open " << TOUCH_DEV_PATH;
+            mStats.failed++;
+            return false;
+        }
+        // A new open may be a new driver instance
+        mModes.clear();
+    }
+
+    mStats.issued++;
+    if (issued) {
+        *issued = true;
+    }
+    if (ioctl(mFd.get(), TOUCH_IOC_SETMODE, &arg) < 0) {
+        PLOG(ERROR) << "failed to set touch mode " << mode << " to " << value;
+        // The firmware state is unknown now, don't skip the next write
+        mModes.erase(mode);
+        mStats.failed++;
+        // The driver went away with its device, reopen it on the next write
+        if (errno == ENODEV) {
+            mFd.reset();
+        }
+        return false;
+    }
+
+    mModes[mode] = value;
+    return true;
+}
+
+}  // namespace xiaomi
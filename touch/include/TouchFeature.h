@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <mutex>
+#include <optional>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xiaomi {
+
+// Touch modes of the xiaomi-touch driver used by native clients
+#define TOUCH_MODE_FOD_ENABLE 10
+
+/*
+ * Owns /dev/xiaomi-touch for the whole process. The value last written to
+ * each mode is mirrored, so writing it again doesn't reach the touch
+ * firmware. Only writes made through here are mirrored, call invalidate()
+ * when something else may have changed a mode behind our back. The mirror
+ * is dropped on its own when the node is reopened or the panel resumes.
+ */
+class TouchFeature {
+  public:
+    struct Stats {
+        uint64_t issued;
+        uint64_t skipped;
+        uint64_t failed;
+    };
+
+    static TouchFeature& getInstance();
+
+    ~TouchFeature();
+
+    // @issued tells whether the write went out to the driver or was skipped
+    bool setMode(int mode, int value, bool* issued = nullptr);
+    bool setModes(const std::vector<std::pair<int, int>>& modes);
+    std::optional<int> getMode(int mode);
+    void invalidate();
+    Stats getStats();
+
+  private:
+    TouchFeature();
+
+    bool setModeLocked(int mode, int value, bool* issued);
+
+    std::mutex mLock;
+    android::base::unique_fd mFd;
+    int mSuspendWatch;
+    std::unordered_map<int, int> mModes;
+    Stats mStats;
+};
+
+}  // namespace xiaomi
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "konaboostd"
+
+#include "BoostArbiter.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/strings.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iterator>
+
+// Stands for the hispeed_freq konatuner gave the knob's cpufreq policy
+#define FLOOR_HISPEED UINT64_MAX
+
+static const char* kKnobPaths[KNOB_COUNT] = {
+        "/sys/devices/system/cpu/cpufreq/policy0/scaling_min_freq",
+        "/sys/devices/system/cpu/cpufreq/policy4/scaling_min_freq",
+        "/sys/devices/system/cpu/cpufreq/policy7/scaling_min_freq",
+        "/sys/class/devfreq/soc:qcom,cpu0-cpu-l3-lat/min_freq",
+        "/sys/class/devfreq/soc:qcom,cpu-llcc-ddr-bw/min_freq",
+};
+
+static const char* kKindNames[BOOST_KIND_COUNT] = {"touch", "fling", "wake", "auth"};
+
+static const struct {
+    int durationMs;
+    uint64_t floors[KNOB_COUNT];
+} kBoosts[BOOST_KIND_COUNT] = {
+        // silver kHz, gold kHz, prime kHz, L3 Hz, DDR MBps
+        // BOOST_TOUCH, what cpu_boost's input boost did before
+        {120, {1324800, 0, 0, 0, 0}},
+        // BOOST_FLING, scrolling and fling animations after the finger lifts
+        {250, {1324800, FLOOR_HISPEED, 0, 1017600000, 0}},
+        // BOOST_WAKE, unblanking brings the lockscreen and launcher back at once
+        {1000, {FLOOR_HISPEED, FLOOR_HISPEED, FLOOR_HISPEED, 1017600000, 5931}},
+        // BOOST_AUTH, the fingerprint HAL while the matcher runs, 5931 MBps is in
+        // the mbps_zones of both the LPDDR4X and LPDDR5 variants
+        {1000, {FLOOR_HISPEED, FLOOR_HISPEED, FLOOR_HISPEED, 0, 5931}},
+};
+
+static int64_t nowMs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+static bool readNumber(const std::string& path, uint64_t* value) {
+    std::string content;
+
+    if (!android::base::ReadFileToString(path, &content)) {
+        return false;
+    }
+
+    *value = strtoull(android::base::Trim(content).c_str(), nullptr, 10);
+    return true;
+}
+
+BoostArbiter::BoostArbiter(const std::string& root) : mRoot(root) {}
+
+bool BoostArbiter::init() {
+    struct stat st;
+    int available = 0;
+
+    for (uint32_t i = 0; i < KNOB_COUNT; i++) {
+        Knob& knob = mKnobs[i];
+
+        knob.path = mRoot + kKnobPaths[i];
+        if (!readNumber(knob.path, &knob.baseline)) {
+            LOG(WARNING) << "no " << kKnobPaths[i] << ", not boosting it";
+            knob.path.clear();
+            continue;
+        }
+
+        knob.fd.reset(TEMP_FAILURE_RETRY(open(knob.path.c_str(), O_RDWR | O_CLOEXEC)));
+        if (knob.fd.get() < 0) {
+            PLOG(ERROR) << "failed to open " << knob.path;
+            knob.path.clear();
+            continue;
+        }
+
+        knob.regular = fstat(knob.fd.get(), &st) == 0 && S_ISREG(st.st_mode);
+        knob.current = knob.baseline;
+        available++;
+    }
+
+    for (uint32_t kind = 0; kind < BOOST_KIND_COUNT; kind++) {
+        for (uint32_t i = 0; i < KNOB_COUNT; i++) {
+            uint64_t floor = kBoosts[kind].floors[i];
+            std::string policy = kKnobPaths[i];
+
+            if (floor == FLOOR_HISPEED) {
+                policy = policy.substr(0, policy.rfind('/')) + "/schedutil/hispeed_freq";
+                if (!readNumber(mRoot + policy, &floor)) {
+                    floor = 0;
+                }
+            }
+            mFloors[kind][i] = floor;
+        }
+    }
+
+    mTimerFd.reset(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC));
+    if (mTimerFd.get() < 0) {
+        PLOG(ERROR) << "failed to create boost timer";
+        return false;
+    }
+
+    return available > 0;
+}
+
+/* Starts a boost of @kind or extends the running one */
+void BoostArbiter::request(BoostKind kind) {
+    int64_t now = nowMs();
+    bool raises = false;
+
+    for (uint32_t i = 0; i < KNOB_COUNT; i++) {
+        if (!mKnobs[i].path.empty() && mFloors[kind][i] > mKnobs[i].current) {
+            raises = true;
+        }
+    }
+
+    mStats.kinds[kind].requests++;
+    if (raises) {
+        mStats.kinds[kind].raised++;
+    }
+
+    mExpiryMs[kind] = std::max(mExpiryMs[kind], now + kBoosts[kind].durationMs);
+    update(now);
+}
+
+void BoostArbiter::cancel(BoostKind kind) {
+    mExpiryMs[kind] = 0;
+    update(nowMs());
+}
+
+void BoostArbiter::cancelAll() {
+    std::fill(std::begin(mExpiryMs), std::end(mExpiryMs), 0);
+    update(nowMs());
+}
+
+void BoostArbiter::onTimer() {
+    uint64_t expirations;
+
+    if (read(mTimerFd.get(), &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+        PLOG(ERROR) << "failed to read boost timer";
+    }
+
+    update(nowMs());
+}
+
+void BoostArbiter::logStats() {
+    uint64_t boostedMs = mStats.boostedMs + (mBoostStartMs ? nowMs() - mBoostStartMs : 0);
+
+    for (uint32_t kind = 0; kind < BOOST_KIND_COUNT; kind++) {
+        const KindStats& stats = mStats.kinds[kind];
+
+        LOG(INFO) << kKindNames[kind] << ": requests=" << stats.requests
+                  << " raised=" << stats.raised << " ("
+                  << (stats.requests ? stats.raised * 100 / stats.requests : 0) << "%)";
+    }
+    LOG(INFO) << "boosted for " << boostedMs << "ms";
+}
+
+/*
+ * Applies the highest floor of the requests still active on every knob,
+ * falling back to its baseline, and arms the timer for the next expiry.
+ */
+void BoostArbiter::update(int64_t now) {
+    struct itimerspec spec = {};
+    int64_t next = 0;
+    bool boosted = false;
+
+    for (uint32_t kind = 0; kind < BOOST_KIND_COUNT; kind++) {
+        if (mExpiryMs[kind] <= now) {
+            mExpiryMs[kind] = 0;
+        } else if (!next || mExpiryMs[kind] < next) {
+            next = mExpiryMs[kind];
+        }
+    }
+
+    for (uint32_t i = 0; i < KNOB_COUNT; i++) {
+        Knob& knob = mKnobs[i];
+        uint64_t target = knob.baseline;
+
+        if (knob.path.empty()) {
+            continue;
+        }
+
+        for (uint32_t kind = 0; kind < BOOST_KIND_COUNT; kind++) {
+            if (mExpiryMs[kind]) {
+                target = std::max(target, mFloors[kind][i]);
+            }
+        }
+
+        if (target != knob.current) {
+            writeKnob(knob, target);
+        }
+        boosted |= knob.current != knob.baseline;
+    }
+
+    if (boosted && !mBoostStartMs) {
+        mBoostStartMs = now;
+    } else if (!boosted && mBoostStartMs) {
+        mStats.boostedMs += now - mBoostStartMs;
+        mBoostStartMs = 0;
+    }
+
+    if (next) {
+        spec.it_value.tv_sec = (next - now) / 1000;
+        spec.it_value.tv_nsec = (next - now) % 1000 * 1000000L;
+    }
+    if (timerfd_settime(mTimerFd.get(), 0, &spec, nullptr) < 0) {
+        PLOG(ERROR) << "failed to arm boost timer";
+    }
+}
+
+/*
+ * Someone else may have moved the floor since it was last written, their
+ * value becomes the baseline then. The node is re-read before every write
+ * and never set below that baseline, so the highest floor always wins.
+ */
+bool BoostArbiter::writeKnob(Knob& knob, uint64_t value) {
+    char buf[32] = {};
+    uint64_t actual;
+    std::string str;
+
+    if (TEMP_FAILURE_RETRY(pread(knob.fd.get(), buf, sizeof(buf) - 1, 0)) > 0) {
+        actual = strtoull(buf, nullptr, 10);
+        if (actual != knob.current) {
+            LOG(INFO) << knob.path << " changed to " << actual << " behind our back";
+            knob.baseline = actual;
+            knob.current = actual;
+        }
+    }
+
+    value = std::max(value, knob.baseline);
+    if (value == knob.current) {
+        return true;
+    }
+
+    str = std::to_string(value);
+    if (TEMP_FAILURE_RETRY(pwrite(knob.fd.get(), str.data(), str.size(), 0)) !=
+                static_cast<ssize_t>(str.size()) ||
+        (knob.regular && ftruncate(knob.fd.get(), str.size()) < 0)) {
+        PLOG(ERROR) << "failed to write " << str << " to " << knob.path;
+        return false;
+    }
+
+    knob.current = value;
+    return true;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <stdint.h>
+#include <string>
+
+enum BoostKnob : uint32_t {
+    KNOB_CPU_SILVER,
+    KNOB_CPU_GOLD,
+    KNOB_CPU_PRIME,
+    KNOB_L3,
+    KNOB_DDR,
+    KNOB_COUNT,
+};
+
+enum BoostKind : uint32_t {
+    BOOST_TOUCH,
+    BOOST_FLING,
+    BOOST_WAKE,
+    BOOST_AUTH,
+    BOOST_KIND_COUNT,
+};
+
+/*
+ * Merges boost requests into cpufreq and devfreq floors. Every kind of
+ * request asks for a floor on some knobs for a while, the highest floor of
+ * all active requests wins and a timerfd drops requests as they expire.
+ */
+class BoostArbiter {
+  public:
+    struct KindStats {
+        uint64_t requests;
+        // Requests that had to raise a floor, the rest were already covered
+        uint64_t raised;
+    };
+
+    struct Stats {
+        KindStats kinds[BOOST_KIND_COUNT];
+        uint64_t boostedMs;
+    };
+
+    explicit BoostArbiter(const std::string& root);
+
+    bool init();
+    void request(BoostKind kind);
+    void cancel(BoostKind kind);
+    void cancelAll();
+    void onTimer();
+    int timerFd() const { return mTimerFd.get(); }
+    void logStats();
+
+  private:
+    struct Knob {
+        std::string path;
+        android::base::unique_fd fd;
+        // A fake tree on a host, which unlike sysfs keeps stale trailing bytes
+        bool regular;
+        uint64_t baseline;
+        uint64_t current;
+    };
+
+    void update(int64_t now);
+    bool writeKnob(Knob& knob, uint64_t value);
+
+    std::string mRoot;
+    android::base::unique_fd mTimerFd;
+    Knob mKnobs[KNOB_COUNT];
+    uint64_t mFloors[BOOST_KIND_COUNT][KNOB_COUNT];
+    int64_t mExpiryMs[BOOST_KIND_COUNT] = {};
+    int64_t mBoostStartMs = 0;
+    Stats mStats = {};
+};
@@ -0,0 +1,420 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "konabootprof"
+
+#include "BootProfiler.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <regex>
+
+// Follows the xtrace depth prefix, then the source line and the command
+#define TRACE_MARKER "\x1e" "BP:"
+
+using android::base::StringPrintf;
+
+// Absolute paths below these move into the fake root
+static const char* kRootedPrefixes[] = {
+        "/sys/",  "/proc/",    "/dev/", "/data/",   "/vendor/",
+        "/odm/",  "/system/",  "/mnt/", "/config/", "/persist/",
+};
+
+// Except these, which a fake root can't stand in for
+static const char* kKeptPaths[] = {"/dev/null", "/dev/zero"};
+
+static const char* kWaitCommands[] = {"sleep", "usleep", "wait", "read"};
+
+static const std::regex kFunctionStart(R"(^(function\s+)?([A-Za-z0-9_]+)\s*\(\s*\))");
+static const std::regex kRedirect(R"((^|[^0-9&<>*])>>?\s*([^\s&;|)]+))");
+
+static int64_t nowUs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/*
+ * The shell's own time from schedstat where the kernel keeps it, ticks
+ * otherwise, plus the ticks of the children it reaped.
+ */
+static int64_t processCpuUs(pid_t pid) {
+    static const int64_t tickUs = 1000000 / sysconf(_SC_CLK_TCK);
+    std::string stat, schedstat;
+
+    if (!android::base::ReadFileToString(StringPrintf("/proc/%d/stat", pid), &stat)) {
+        return 0;
+    }
+
+    // utime, stime, cutime and cstime, fields 14 to 17 and 11 to 14 past the name
+    size_t end = stat.rfind(')');
+    auto fields = android::base::Split(end == std::string::npos ? "" : stat.substr(end + 2), " ");
+    if (fields.size() < 15) {
+        return 0;
+    }
+
+    int64_t self = (strtoll(fields[11].c_str(), nullptr, 10) +
+                    strtoll(fields[12].c_str(), nullptr, 10)) * tickUs;
+    int64_t children = (strtoll(fields[13].c_str(), nullptr, 10) +
+                        strtoll(fields[14].c_str(), nullptr, 10)) * tickUs;
+
+    if (android::base::ReadFileToString(StringPrintf("/proc/%d/schedstat", pid), &schedstat)) {
+        self = strtoll(schedstat.c_str(), nullptr, 10) / 1000;
+    }
+
+    return self + children;
+}
+
+static bool hasPrefix(const std::string& line, size_t pos, const char* prefix) {
+    return !line.compare(pos, strlen(prefix), prefix);
+}
+
+static std::string rootPaths(const std::string& line, const std::string& root) {
+    std::string out;
+
+    for (size_t i = 0; i < line.size(); i++) {
+        bool boundary = i == 0 || strchr(" \t\"'=<>(`:;|&", line[i - 1]);
+        auto matches = [&](const char* prefix) { return hasPrefix(line, i, prefix); };
+
+        if (line[i] == '/' && boundary &&
+            std::any_of(std::begin(kRootedPrefixes), std::end(kRootedPrefixes), matches) &&
+            std::none_of(std::begin(kKeptPaths), std::end(kKeptPaths), matches)) {
+            out += root;
+        }
+        out += line[i];
+    }
+
+    return out;
+}
+
+// Redirects into anything but /dev/null, comments aside
+static bool isWrite(const std::string& line) {
+    std::string code = line.substr(0, line.find(" #"));
+    std::smatch match;
+
+    if (android::base::StartsWith(android::base::Trim(code), "#")) {
+        return false;
+    }
+
+    for (auto it = code.cbegin(); std::regex_search(it, code.cend(), match, kRedirect);
+         it = match[0].second) {
+        if (match[2] != "/dev/null") {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+ScriptProfiler::ScriptProfiler(const ProfileOptions& options)
+    : mOptions(options), mStageStartUs(0), mLastCpuUs(0), mOpen(false) {}
+
+bool ScriptProfiler::parse(const std::string& path, Source* source, TraceStage* stage) {
+    std::string data;
+    uint16_t function = TRACE_NO_NAME;
+
+    if (!android::base::ReadFileToString(path, &data)) {
+        PLOG(ERROR) << "failed to read " << path;
+        return false;
+    }
+
+    source->lines = android::base::Split(data, "\n");
+    for (auto& line : source->lines) {
+        std::smatch match;
+
+        // Definitions start at the first column and end at the first closing brace there
+        if (std::regex_search(line, match, kFunctionStart) && stage->names.size() < TRACE_NO_NAME) {
+            function = stage->names.size();
+            source->callees[match[2]] = function;
+            stage->names.push_back(match[2]);
+        } else if (!line.empty() && line[0] == '}') {
+            source->functions.push_back(function);
+            source->writes.push_back(false);
+            function = TRACE_NO_NAME;
+            continue;
+        }
+
+        source->functions.push_back(function);
+        source->writes.push_back(isWrite(line));
+    }
+
+    return true;
+}
+
+/*
+ * A copy with xtrace turned on in its first line, which only ever holds the
+ * shebang or shares it, so the line numbers stay those of the original.
+ */
+bool ScriptProfiler::writeTraced(const Source& source, std::string* tracedPath) {
+    std::string traced = "PS4='+" TRACE_MARKER "${LINENO}:'; set -x";
+    std::string pathTemplate = mOptions.tmpDir + "/konabootprof.XXXXXX";
+
+    for (size_t i = 0; i < source.lines.size(); i++) {
+        const std::string& line = source.lines[i];
+
+        if (i == 0 && android::base::StartsWith(line, "#!")) {
+            continue;
+        }
+        traced += i == 0 ? "; " : "\n";
+        traced += mOptions.root.empty() ? line : rootPaths(line, mOptions.root);
+    }
+    if (source.lines.size() <= 1) {
+        traced += "\n";
+    }
+
+    android::base::unique_fd fd(mkstemp(pathTemplate.data()));
+    if (fd.get() < 0) {
+        PLOG(ERROR) << "failed to create " << pathTemplate;
+        return false;
+    }
+
+    *tracedPath = pathTemplate;
+    if (!android::base::WriteStringToFd(traced, fd.get())) {
+        PLOG(ERROR) << "failed to write " << pathTemplate;
+        unlink(pathTemplate.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool ScriptProfiler::run(const std::string& path, TraceStage* stage) {
+    std::string tracedPath;
+    struct rusage usage;
+    int fds[2];
+    int status;
+
+    *stage = {};
+    stage->path = path;
+
+    Source source;
+    if (!parse(path, &source, stage) || !writeTraced(source, &tracedPath)) {
+        return false;
+    }
+
+    if (pipe2(fds, O_CLOEXEC) < 0) {
+        PLOG(ERROR) << "failed to create trace pipe";
+        unlink(tracedPath.c_str());
+        return false;
+    }
+    android::base::unique_fd readFd(fds[0]);
+    android::base::unique_fd writeFd(fds[1]);
+
+    mStageStartUs = nowUs();
+    mLastCpuUs = 0;
+    mOpen = false;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        PLOG(ERROR) << "failed to fork";
+        unlink(tracedPath.c_str());
+        return false;
+    }
+
+    if (pid == 0) {
+        // A group of its own, so a timeout takes down whatever it started
+        setpgid(0, 0);
+        dup2(writeFd.get(), STDERR_FILENO);
+        if (!mOptions.root.empty()) {
+            const char* path = getenv("PATH");
+            std::string rooted = mOptions.root + "/vendor/bin:" + mOptions.root + "/system/bin";
+            setenv("PATH", (rooted + ":" + (path ? path : "")).c_str(), 1);
+        }
+        execl(mOptions.shell.c_str(), mOptions.shell.c_str(), tracedPath.c_str(), nullptr);
+        _exit(127);
+    }
+
+    writeFd.reset();
+    collect(readFd.get(), pid, source, stage);
+
+    if (TEMP_FAILURE_RETRY(wait4(pid, &status, 0, &usage)) < 0) {
+        PLOG(ERROR) << "failed to wait for " << path;
+        status = -1;
+    }
+
+    stage->wallUs = nowUs() - mStageStartUs;
+    stage->cpuUs = usage.ru_utime.tv_sec * 1000000LL + usage.ru_utime.tv_usec +
+                   usage.ru_stime.tv_sec * 1000000LL + usage.ru_stime.tv_usec;
+    stage->status = status;
+    unlink(tracedPath.c_str());
+
+    return true;
+}
+
+// Until the shell and all it started closed the pipe, or the timeout hit
+void ScriptProfiler::collect(int fd, pid_t pid, const Source& source, TraceStage* stage) {
+    int64_t deadlineUs = mOptions.timeoutS > 0 ? mStageStartUs + mOptions.timeoutS * 1000000LL : 0;
+    std::string pending;
+    char buf[4096];
+
+    while (true) {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN, .revents = 0};
+        int timeoutMs = deadlineUs ? std::max<int64_t>(0, (deadlineUs - nowUs()) / 1000) : -1;
+
+        int ret = TEMP_FAILURE_RETRY(poll(&pfd, 1, timeoutMs));
+        if (ret < 0) {
+            PLOG(ERROR) << "failed to poll trace pipe";
+            break;
+        }
+        if (ret == 0) {
+            LOG(WARNING) << stage->path << " timed out after " << mOptions.timeoutS << "s";
+            kill(-pid, SIGKILL);
+            deadlineUs = 0;
+            continue;
+        }
+
+        ssize_t len = TEMP_FAILURE_RETRY(read(fd, buf, sizeof(buf)));
+        if (len <= 0) {
+            break;
+        }
+
+        // Lines of one read all arrived together, they share its timestamp
+        int64_t now = nowUs();
+        size_t start = 0, end;
+        pending.append(buf, len);
+        while ((end = pending.find('\n', start)) != std::string::npos) {
+            addEvent(pid, source, pending.substr(start, end - start), now, stage);
+            start = end + 1;
+        }
+        pending.erase(0, start);
+    }
+
+    if (!pending.empty()) {
+        addEvent(pid, source, pending, nowUs(), stage);
+    }
+    finishEvent(pid, nowUs(), stage);
+}
+
+void ScriptProfiler::addEvent(pid_t pid, const Source& source, const std::string& line,
+                              int64_t timeUs, TraceStage* stage) {
+    size_t marker = line.find(TRACE_MARKER);
+    size_t depth = marker;
+    char* end;
+
+    // Whatever the script itself printed to stderr
+    if (marker == std::string::npos) {
+        android::base::WriteStringToFd(line + "\n", STDERR_FILENO);
+        return;
+    }
+
+    // bash repeats the first character of PS4 once per nesting level
+    while (depth > 0 && line[depth - 1] == '+') {
+        depth--;
+    }
+    if (depth > 0) {
+        android::base::WriteStringToFd(line.substr(0, depth) + "\n", STDERR_FILENO);
+    }
+
+    uint32_t lineNo = strtoul(line.c_str() + marker + strlen(TRACE_MARKER), &end, 10);
+    if (*end != ':') {
+        return;
+    }
+
+    std::string command = end + 1;
+    std::string first = command.substr(0, command.find(' '));
+    first.erase(std::remove(first.begin(), first.end(), '\''), first.end());
+
+    finishEvent(pid, timeUs, stage);
+
+    TraceEvent event = {};
+    event.line = lineNo;
+    event.depth = std::min<size_t>(marker - depth - 1, UINT8_MAX);
+    event.startUs = timeUs - mStageStartUs;
+
+    auto callee = source.callees.find(first);
+    bool known = lineNo > 0 && lineNo <= source.lines.size();
+    if (callee != source.callees.end()) {
+        event.kind = TRACE_CALL;
+        event.name = callee->second;
+    } else {
+        event.name = known ? source.functions[lineNo - 1] : TRACE_NO_NAME;
+        if (known && source.writes[lineNo - 1]) {
+            event.kind = TRACE_WRITE;
+        } else if (std::find_if(std::begin(kWaitCommands), std::end(kWaitCommands),
+                                [&](const char* wait) { return first == wait; }) !=
+                   std::end(kWaitCommands)) {
+            event.kind = TRACE_WAIT;
+        } else {
+            event.kind = TRACE_CMD;
+        }
+    }
+
+    stage->events.push_back(event);
+    mOpen = true;
+}
+
+// A command ends when the next one starts
+void ScriptProfiler::finishEvent(pid_t pid, int64_t timeUs, TraceStage* stage) {
+    int64_t cpuUs = processCpuUs(pid);
+
+    if (mOpen) {
+        TraceEvent& event = stage->events.back();
+
+        event.wallUs = std::min<int64_t>(timeUs - mStageStartUs - event.startUs, UINT32_MAX);
+        event.cpuUs = std::clamp<int64_t>(cpuUs - mLastCpuUs, 0, UINT32_MAX);
+        if (event.kind == TRACE_CMD && event.wallUs >= mOptions.slowUs) {
+            event.kind = TRACE_WAIT;
+        }
+        mOpen = false;
+    }
+
+    mLastCpuUs = std::max(mLastCpuUs, cpuUs);
+}
+
+bool profileServices(const std::string& path, TraceStage* stage) {
+    std::string data;
+
+    *stage = {};
+    stage->path = path;
+
+    if (!android::base::ReadFileToString(path, &data)) {
+        PLOG(ERROR) << "failed to read " << path;
+        return false;
+    }
+
+    auto lines = android::base::Split(data, "\n");
+    for (size_t i = 0; i < lines.size() && stage->names.size() < TRACE_NO_NAME; i++) {
+        auto words = android::base::Tokenize(lines[i], " \t");
+        if (words.size() < 2 || words[0] != "service") {
+            continue;
+        }
+
+        TraceEvent event = {};
+        event.line = i + 1;
+        event.kind = TRACE_SERVICE;
+        event.name = stage->names.size();
+        stage->names.push_back(words[1]);
+
+        // In ns since boot, and only there once init started it
+        uint64_t startNs = android::base::GetUintProperty<uint64_t>("ro.boottime." + words[1], 0);
+        event.startUs = std::min<uint64_t>(startNs / 1000, UINT32_MAX);
+
+        // Debuggable builds also publish the pid of what still runs
+        pid_t pid = android::base::GetIntProperty("init.svc_debug_pid." + words[1], 0);
+        if (event.startUs && pid > 0) {
+            event.cpuUs = std::min<int64_t>(processCpuUs(pid), UINT32_MAX);
+        }
+
+        stage->events.push_back(event);
+    }
+
+    return true;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "BootTrace.h"
+
+struct ProfileOptions {
+    // Absolute paths the script touches are moved below it, "" on a device
+    std::string root;
+    std::string shell;
+    std::string tmpDir;
+    int timeoutS;
+    int64_t slowUs;
+};
+
+/*
+ * Runs a script under xtrace with the source line in PS4 and timestamps
+ * every traced command as it arrives. A command lasts until the next one
+ * starts, and its cpu time is what the shell and its reaped children spent
+ * in between, so the time goes to the source line and its function.
+ */
+class ScriptProfiler {
+  public:
+    explicit ScriptProfiler(const ProfileOptions& options);
+
+    bool run(const std::string& path, TraceStage* stage);
+
+  private:
+    struct Source {
+        std::vector<std::string> lines;
+        // Per line, the index of the enclosing function or TRACE_NO_NAME
+        std::vector<uint16_t> functions;
+        std::vector<bool> writes;
+        std::map<std::string, uint16_t> callees;
+    };
+
+    bool parse(const std::string& path, Source* source, TraceStage* stage);
+    bool writeTraced(const Source& source, std::string* tracedPath);
+    void collect(int fd, pid_t pid, const Source& source, TraceStage* stage);
+    void addEvent(pid_t pid, const Source& source, const std::string& line, int64_t timeUs,
+                  TraceStage* stage);
+    void finishEvent(pid_t pid, int64_t timeUs, TraceStage* stage);
+
+    ProfileOptions mOptions;
+    int64_t mStageStartUs;
+    int64_t mLastCpuUs;
+    // The last event still waits for the next one to end it
+    bool mOpen;
+};
+
+// Start times init recorded for the services @path defines
+bool profileServices(const std::string& path, TraceStage* stage);
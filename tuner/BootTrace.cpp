@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "konabootprof"
+
+#include "BootTrace.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <map>
+
+#define TRACE_MAGIC "KBPT"
+#define TRACE_VERSION 1
+
+using android::base::StringPrintf;
+
+template <typename T>
+static void put(std::string* out, const T& value) {
+    out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void putString(std::string* out, const std::string& value) {
+    put<uint32_t>(out, value.size());
+    out->append(value);
+}
+
+class TraceReader {
+  public:
+    explicit TraceReader(const std::string& data) : mData(data), mPos(0) {}
+
+    template <typename T>
+    bool get(T* value) {
+        return getBytes(value, sizeof(*value));
+    }
+
+    bool getString(std::string* value) {
+        uint32_t size;
+
+        if (!get(&size) || mData.size() - mPos < size) {
+            return false;
+        }
+        value->assign(mData, mPos, size);
+        mPos += size;
+        return true;
+    }
+
+    bool getBytes(void* value, size_t size) {
+        if (mData.size() - mPos < size) {
+            return false;
+        }
+        memcpy(value, mData.data() + mPos, size);
+        mPos += size;
+        return true;
+    }
+
+  private:
+    const std::string& mData;
+    size_t mPos;
+};
+
+bool writeTrace(const std::string& path, const std::vector<TraceStage>& stages) {
+    std::string out = TRACE_MAGIC;
+
+    put<uint32_t>(&out, TRACE_VERSION);
+    put<uint32_t>(&out, stages.size());
+    for (auto& stage : stages) {
+        putString(&out, stage.path);
+        put(&out, stage.wallUs);
+        put(&out, stage.cpuUs);
+        put(&out, stage.status);
+        put<uint32_t>(&out, stage.names.size());
+        for (auto& name : stage.names) {
+            putString(&out, name);
+        }
+        put<uint32_t>(&out, stage.events.size());
+        out.append(reinterpret_cast<const char*>(stage.events.data()),
+                   stage.events.size() * sizeof(TraceEvent));
+    }
+
+    if (!android::base::WriteStringToFile(out, path)) {
+        PLOG(ERROR) << "failed to write " << path;
+        return false;
+    }
+
+    return true;
+}
+
+bool readTrace(const std::string& path, std::vector<TraceStage>* stages) {
+    std::string data;
+    char magic[4];
+    uint32_t version, count;
+
+    if (!android::base::ReadFileToString(path, &data)) {
+        PLOG(ERROR) << "failed to read " << path;
+        return false;
+    }
+
+    TraceReader reader(data);
+    if (!reader.getBytes(magic, sizeof(magic)) || memcmp(magic, TRACE_MAGIC, sizeof(magic)) ||
+        !reader.get(&version) || version != TRACE_VERSION || !reader.get(&count)) {
+        LOG(ERROR) << path << " is not a version " << TRACE_VERSION << " boot trace";
+        return false;
+    }
+
+    stages->resize(count);
+    for (auto& stage : *stages) {
+        uint32_t names, events;
+
+        if (!reader.getString(&stage.path) || !reader.get(&stage.wallUs) ||
+            !reader.get(&stage.cpuUs) || !reader.get(&stage.status) || !reader.get(&names)) {
+            LOG(ERROR) << path << " is truncated";
+            return false;
+        }
+
+        stage.names.resize(names);
+        for (auto& name : stage.names) {
+            if (!reader.getString(&name)) {
+                LOG(ERROR) << path << " is truncated";
+                return false;
+            }
+        }
+
+        // Bounded by what is left before allocating
+        if (!reader.get(&events) || events > data.size() / sizeof(TraceEvent)) {
+            LOG(ERROR) << path << " is truncated";
+            return false;
+        }
+        stage.events.resize(events);
+        if (!reader.getBytes(stage.events.data(), events * sizeof(TraceEvent))) {
+            LOG(ERROR) << path << " is truncated";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static std::string formatMs(int64_t us) {
+    return StringPrintf("%.1fms", us / 1000.0);
+}
+
+static std::string formatStatus(int32_t status) {
+    if (WIFSIGNALED(status)) {
+        return StringPrintf("signal=%d", WTERMSIG(status));
+    }
+    return StringPrintf("exit=%d", WEXITSTATUS(status));
+}
+
+struct LineTotal {
+    size_t count;
+    int64_t wallUs;
+    int64_t cpuUs;
+};
+
+static void formatLines(std::string* out, const char* what, const std::map<uint32_t, LineTotal>& lines,
+                        const std::vector<std::string>& source) {
+    LineTotal total = {};
+
+    for (auto& [line, sum] : lines) {
+        total.count += sum.count;
+        total.wallUs += sum.wallUs;
+        total.cpuUs += sum.cpuUs;
+    }
+    *out += StringPrintf("  %ss count=%zu wall=%s cpu=%s\n", what, total.count,
+                         formatMs(total.wallUs).c_str(), formatMs(total.cpuUs).c_str());
+
+    for (auto& [line, sum] : lines) {
+        std::string text = line > 0 && line <= source.size()
+                                   ? android::base::Trim(source[line - 1])
+                                   : "";
+        *out += StringPrintf("    %s L%u x%zu wall=%s cpu=%s  %s\n", what, line, sum.count,
+                             formatMs(sum.wallUs).c_str(), formatMs(sum.cpuUs).c_str(),
+                             text.c_str());
+    }
+}
+
+static void formatScript(std::string* out, const TraceStage& stage) {
+    std::map<std::string, LineTotal> functions;
+    std::map<uint32_t, LineTotal> writes, waits;
+    std::vector<std::string> source;
+    std::string data;
+
+    if (android::base::ReadFileToString(stage.path, &data)) {
+        source = android::base::Split(data, "\n");
+    }
+
+    for (auto& event : stage.events) {
+        std::string name = event.name < stage.names.size() ? stage.names[event.name] : "<top>";
+
+        if (event.kind == TRACE_CALL) {
+            functions[name].count++;
+            continue;
+        }
+
+        auto& function = functions[name];
+        function.wallUs += event.wallUs;
+        function.cpuUs += event.cpuUs;
+
+        if (event.kind == TRACE_WRITE || event.kind == TRACE_WAIT) {
+            auto& line = (event.kind == TRACE_WRITE ? writes : waits)[event.line];
+            line.count++;
+            line.wallUs += event.wallUs;
+            line.cpuUs += event.cpuUs;
+        }
+    }
+
+    *out += StringPrintf("stage %s %s wall=%s cpu=%s commands=%zu\n", stage.path.c_str(),
+                         formatStatus(stage.status).c_str(), formatMs(stage.wallUs).c_str(),
+                         formatMs(stage.cpuUs).c_str(), stage.events.size());
+
+    // Self time, a function's callees are not part of it
+    for (auto& [name, sum] : functions) {
+        *out += StringPrintf("  function %s calls=%zu wall=%s cpu=%s\n", name.c_str(), sum.count,
+                             formatMs(sum.wallUs).c_str(), formatMs(sum.cpuUs).c_str());
+    }
+
+    formatLines(out, "write", writes, source);
+    formatLines(out, "wait", waits, source);
+}
+
+static void formatServices(std::string* out, const TraceStage& stage) {
+    std::vector<TraceEvent> events = stage.events;
+
+    // Started ones by start time, then the rest by line
+    std::stable_sort(events.begin(), events.end(), [](auto& a, auto& b) {
+        if (!a.startUs || !b.startUs) {
+            return a.startUs && !b.startUs;
+        }
+        return a.startUs < b.startUs;
+    });
+
+    *out += StringPrintf("services %s\n", stage.path.c_str());
+    for (auto& event : events) {
+        const char* name =
+                event.name < stage.names.size() ? stage.names[event.name].c_str() : "<unknown>";
+
+        if (!event.startUs) {
+            *out += StringPrintf("  %s L%u not started\n", name, event.line);
+            continue;
+        }
+        *out += StringPrintf("  %s L%u start=%s cpu=%s\n", name, event.line,
+                             formatMs(event.startUs).c_str(), formatMs(event.cpuUs).c_str());
+    }
+}
+
+std::string formatSummary(const std::vector<TraceStage>& stages) {
+    std::string out;
+
+    for (auto& stage : stages) {
+        bool services = std::any_of(stage.events.begin(), stage.events.end(),
+                                    [](auto& event) { return event.kind == TRACE_SERVICE; });
+
+        if (services) {
+            formatServices(&out, stage);
+        } else {
+            formatScript(&out, stage);
+        }
+    }
+
+    return out;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+enum TraceKind : uint8_t {
+    // A command of the script
+    TRACE_CMD,
+    // A call of a function the script defines, named by the event
+    TRACE_CALL,
+    // A command on a source line that redirects into a file
+    TRACE_WRITE,
+    // A sleep, wait or read, or any command slower than the slow threshold
+    TRACE_WAIT,
+    // An init service, started at startUs since boot or not at all if 0
+    TRACE_SERVICE,
+};
+
+#define TRACE_NO_NAME 0xffff
+
+// Fixed size and native endian, traces are read back on the same arch
+struct TraceEvent {
+    uint32_t line;
+    // Into TraceStage::names, the enclosing function unless a call or service
+    uint16_t name;
+    uint8_t kind;
+    // Subshell nesting
+    uint8_t depth;
+    uint32_t startUs;
+    uint32_t wallUs;
+    uint32_t cpuUs;
+};
+
+static_assert(sizeof(TraceEvent) == 20, "TraceEvent is written as is");
+
+// A profiled script or the services of an init rc file
+struct TraceStage {
+    std::string path;
+    int64_t wallUs;
+    int64_t cpuUs;
+    // Exit status as from waitpid, 0 for rc files
+    int32_t status;
+    std::vector<std::string> names;
+    std::vector<TraceEvent> events;
+};
+
+bool writeTrace(const std::string& path, const std::vector<TraceStage>& stages);
+bool readTrace(const std::string& path, std::vector<TraceStage>* stages);
+
+// Ordered by stage and source line so two builds can be diffed line by line
+std::string formatSummary(const std::vector<TraceStage>& stages);
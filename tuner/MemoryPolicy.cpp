@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "konamemd"
+
+#include "MemoryPolicy.h"
+
+#include <algorithm>
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/swap.h>
+#include <unistd.h>
+
+#define ZRAM_DEV "/dev/block/zram0"
+#define ZRAM_SYSFS "/sys/block/zram0"
+#define ZRAM_SWAP_PRIORITY 32758
+
+#define SWAP_PAGE_SIZE 4096
+#define SWAP_SIGNATURE "SWAPSPACE2"
+
+static const MemoryPolicy kPolicies[] = {
+        // maxRamGb zram% zramMaxMb readAheadKb swappiness pressureSwappiness writeback%
+        {2, 75, 4096, 128, 100, 100, 50},
+        {3, 50, 4096, 128, 100, 80, 50},
+        {UINT64_MAX, 50, 4096, 512, 100, 60, 60},
+};
+
+const MemoryPolicy& selectPolicy(uint64_t memTotalKb) {
+    uint64_t ramGb = memTotalKb / (1024 * 1024) + 1;
+
+    for (auto& policy : kPolicies) {
+        if (ramGb <= policy.maxRamGb) {
+            return policy;
+        }
+    }
+
+    return kPolicies[sizeof(kPolicies) / sizeof(kPolicies[0]) - 1];
+}
+
+uint64_t readMemTotalKb(const std::string& root) {
+    std::string meminfo;
+    unsigned long long kb;
+    const char* line;
+
+    if (!android::base::ReadFileToString(root + "/proc/meminfo", &meminfo)) {
+        PLOG(ERROR) << "failed to read meminfo";
+        return 0;
+    }
+
+    line = strstr(meminfo.c_str(), "MemTotal:");
+    if (!line || sscanf(line, "MemTotal: %llu kB", &kb) != 1) {
+        LOG(ERROR) << "no MemTotal in meminfo";
+        return 0;
+    }
+
+    return kb;
+}
+
+bool writeSysfs(const std::string& path, const std::string& value) {
+    if (!android::base::WriteStringToFile(value, path)) {
+        PLOG(ERROR) << "failed to write " << value << " to " << path;
+        return false;
+    }
+
+    return true;
+}
+
+// What mkswap writes: a version 1 header covering the whole device, no bad pages
+static bool writeSwapHeader(const std::string& path) {
+    android::base::unique_fd fd(TEMP_FAILURE_RETRY(open(path.c_str(), O_RDWR | O_CLOEXEC)));
+    uint8_t page[SWAP_PAGE_SIZE] = {};
+    uint32_t version = 1;
+    uint32_t lastPage;
+    off_t size;
+
+    if (fd.get() < 0 || (size = lseek(fd.get(), 0, SEEK_END)) < 0) {
+        PLOG(ERROR) << "failed to open " << path;
+        return false;
+    }
+
+    if (size < 2 * SWAP_PAGE_SIZE) {
+        LOG(ERROR) << path << " is too small for swap";
+        return false;
+    }
+
+    lastPage = size / SWAP_PAGE_SIZE - 1;
+    memcpy(page + 1024, &version, sizeof(version));
+    memcpy(page + 1028, &lastPage, sizeof(lastPage));
+    memcpy(page + SWAP_PAGE_SIZE - strlen(SWAP_SIGNATURE), SWAP_SIGNATURE,
+           strlen(SWAP_SIGNATURE));
+
+    if (TEMP_FAILURE_RETRY(pwrite(fd.get(), page, sizeof(page), 0)) != sizeof(page) ||
+        fsync(fd.get()) < 0) {
+        PLOG(ERROR) << "failed to write swap header to " << path;
+        return false;
+    }
+
+    return true;
+}
+
+static bool setupZram(const std::string& root, const MemoryPolicy& policy, uint64_t memTotalKb,
+                      bool lowRam) {
+    uint64_t ramGb = memTotalKb / (1024 * 1024) + 1;
+    uint64_t sizeMb = std::min(ramGb * 1024 * policy.zramPercent / 100, policy.zramMaxMb);
+    std::string zram = root + ZRAM_SYSFS;
+
+    if (access((zram + "/disksize").c_str(), F_OK) < 0) {
+        LOG(INFO) << "no zram, not setting up swap";
+        return true;
+    }
+
+    if (lowRam) {
+        writeSysfs(zram + "/comp_algorithm", "lz4");
+    }
+    if (access((zram + "/use_dedup").c_str(), F_OK) == 0) {
+        writeSysfs(zram + "/use_dedup", "1");
+    }
+    if (!writeSysfs(zram + "/disksize", std::to_string(sizeMb) + "M")) {
+        return false;
+    }
+
+    // zram may use more memory than it saves with SLAB_STORE_USER debugging
+    for (auto slab : {"/sys/kernel/slab/zs_handle", "/sys/kernel/slab/zspage"}) {
+        if (access((root + slab).c_str(), F_OK) == 0) {
+            writeSysfs(root + slab + "/store_user", "0");
+        }
+    }
+
+    if (!writeSwapHeader(root + ZRAM_DEV)) {
+        return false;
+    }
+
+    if (!root.empty()) {
+        return true;
+    }
+
+    if (swapon(ZRAM_DEV, SWAP_FLAG_PREFER | (ZRAM_SWAP_PRIORITY & SWAP_FLAG_PRIO_MASK)) < 0) {
+        PLOG(ERROR) << "failed to enable swap on " << ZRAM_DEV;
+        return false;
+    }
+
+    LOG(INFO) << "zram swap of " << sizeMb << "MB enabled";
+    return true;
+}
+
+// Same block devices post_boot picked, dm and mmc ones
+static void setupReadAhead(const std::string& root, const MemoryPolicy& policy) {
+    std::string value = std::to_string(policy.readAheadKb);
+    glob_t matches;
+
+    for (auto bdi : {"/sys/block/mmcblk0/bdi", "/sys/block/mmcblk0rpmb/bdi"}) {
+        if (access((root + bdi).c_str(), F_OK) == 0) {
+            writeSysfs(root + bdi + "/read_ahead_kb", value);
+        }
+    }
+
+    if (glob((root + "/sys/block/*/queue/read_ahead_kb").c_str(), 0, nullptr, &matches) != 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < matches.gl_pathc; i++) {
+        std::string path = matches.gl_pathv[i];
+        std::string name = path.substr(root.size() + strlen("/sys/block/"));
+
+        if (name.find("dm") != std::string::npos || name.find("mmc") != std::string::npos) {
+            writeSysfs(path, value);
+        }
+    }
+    globfree(&matches);
+}
+
+bool applyMemoryPolicy(const std::string& root, const MemoryPolicy& policy, uint64_t memTotalKb,
+                       bool lowRam) {
+    bool ok = setupZram(root, policy, memTotalKb, lowRam);
+
+    setupReadAhead(root, policy);
+    ok &= writeSysfs(root + "/proc/sys/vm/page-cluster", "0");
+    ok &= writeSysfs(root + "/proc/sys/vm/swappiness", std::to_string(policy.swappiness));
+
+    return ok;
+}
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+struct MemoryPolicy {
+    // Applies up to this much RAM, rounded up to whole GiB like post_boot did
+    uint64_t maxRamGb;
+    int zramPercent;
+    uint64_t zramMaxMb;
+    int readAheadKb;
+    int swappiness;
+    // While PSI reports memory pressure, see PressureMonitor
+    int pressureSwappiness;
+    // Write idle pages back once zram holds this much of its disk size
+    int writebackPercent;
+};
+
+const MemoryPolicy& selectPolicy(uint64_t memTotalKb);
+
+/*
+ * Sets up zram0 as swap, read-ahead and the VM knobs below @root. Only the
+ * swapon() itself can't be pointed at a fake tree.
+ */
+bool applyMemoryPolicy(const std::string& root, const MemoryPolicy& policy, uint64_t memTotalKb,
+                       bool lowRam);
+
+uint64_t readMemTotalKb(const std::string& root);
+bool writeSysfs(const std::string& path, const std::string& value);
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "konamemd"
+
+#include "PressureMonitor.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/strings.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PSI_MEMORY "/proc/pressure/memory"
+// 150ms of partial stall within a 1s window
+#define PSI_TRIGGER "some 150000 1000000"
+#define PSI_CALM_AVG10 5.0f
+#define PSI_RECHECK_MS 5000
+
+#define ZRAM_SYSFS "/sys/block/zram0"
+
+static int64_t nowMs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+PressureMonitor::PressureMonitor(const std::string& root, const MemoryPolicy& policy)
+    : mRoot(root), mPolicy(policy) {}
+
+bool PressureMonitor::init() {
+    std::string path = mRoot + PSI_MEMORY;
+
+    mPsiFd.reset(TEMP_FAILURE_RETRY(open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC)));
+    if (mPsiFd.get() < 0) {
+        PLOG(ERROR) << "failed to open " << path;
+        return false;
+    }
+
+    // The trailing NUL is part of what the kernel expects
+    if (TEMP_FAILURE_RETRY(write(mPsiFd.get(), PSI_TRIGGER, strlen(PSI_TRIGGER) + 1)) < 0) {
+        PLOG(ERROR) << "failed to register PSI trigger";
+        return false;
+    }
+
+    return true;
+}
+
+void PressureMonitor::run() {
+    struct pollfd pfd = {.fd = mPsiFd.get(), .events = POLLPRI};
+    float avg10;
+
+    while (true) {
+        int ret = TEMP_FAILURE_RETRY(poll(&pfd, 1, mUnderPressure ? PSI_RECHECK_MS : -1));
+        if (ret < 0) {
+            PLOG(ERROR) << "failed to wait for memory pressure";
+            return;
+        }
+
+        if (pfd.revents & POLLERR) {
+            LOG(ERROR) << "PSI trigger went away";
+            return;
+        }
+
+        if (pfd.revents & POLLPRI) {
+            if (!mUnderPressure) {
+                enterPressure();
+            }
+            continue;
+        }
+
+        // The trigger stays quiet while stalls are short, see whether they settled
+        if (mUnderPressure && readSomeAvg10(&avg10) && avg10 < PSI_CALM_AVG10) {
+            leavePressure();
+        }
+    }
+}
+
+// "some avg10=1.23 avg60=..." of the memory pressure file
+bool PressureMonitor::readSomeAvg10(float* avg10) {
+    std::string content;
+
+    if (!android::base::ReadFileToString(mRoot + PSI_MEMORY, &content) ||
+        sscanf(content.c_str(), "some avg10=%f", avg10) != 1) {
+        LOG(ERROR) << "failed to read memory pressure";
+        return false;
+    }
+
+    return true;
+}
+
+void PressureMonitor::enterPressure() {
+    mUnderPressure = true;
+    mPressureStartMs = nowMs();
+    mStats.episodes++;
+    writeSysfs(mRoot + "/proc/sys/vm/swappiness", std::to_string(mPolicy.pressureSwappiness));
+}
+
+void PressureMonitor::leavePressure() {
+    int64_t ms = nowMs() - mPressureStartMs;
+
+    mUnderPressure = false;
+    mStats.pressureMs += ms;
+    writeSysfs(mRoot + "/proc/sys/vm/swappiness", std::to_string(mPolicy.swappiness));
+    writebackIdle();
+
+    LOG(INFO) << "memory pressure over after " << ms << "ms, episodes=" << mStats.episodes
+              << " total=" << mStats.pressureMs << "ms writebacks=" << mStats.writebacks;
+}
+
+/*
+ * Pages marked idle at the end of the previous pressure episode and not
+ * touched since go to the backing device, then everything is marked idle
+ * again for the next round.
+ */
+void PressureMonitor::writebackIdle() {
+    std::string zram = mRoot + ZRAM_SYSFS;
+    std::string value;
+    unsigned long long disksize, origData;
+
+    if (!android::base::ReadFileToString(zram + "/backing_dev", &value) ||
+        android::base::Trim(value) == "none") {
+        return;
+    }
+
+    if (!android::base::ReadFileToString(zram + "/disksize", &value) ||
+        sscanf(value.c_str(), "%llu", &disksize) != 1 || disksize == 0 ||
+        !android::base::ReadFileToString(zram + "/mm_stat", &value) ||
+        sscanf(value.c_str(), "%llu", &origData) != 1) {
+        LOG(ERROR) << "failed to read zram usage";
+        return;
+    }
+
+    if (origData * 100 / disksize < static_cast<unsigned long long>(mPolicy.writebackPercent)) {
+        return;
+    }
+
+    if (writeSysfs(zram + "/writeback", "idle")) {
+        mStats.writebacks++;
+    }
+    writeSysfs(zram + "/idle", "all");
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <stdint.h>
+#include <string>
+
+#include "MemoryPolicy.h"
+
+/*
+ * Waits on a PSI trigger for memory stalls. While memory is under pressure
+ * swappiness drops to the policy's pressure value, so reclaim spends less
+ * CPU on compressing anon pages. Once the stall average settles again the
+ * normal value comes back, and zram pages left idle since the last calm
+ * period are written back if zram has a backing device.
+ */
+class PressureMonitor {
+  public:
+    struct Stats {
+        uint64_t episodes;
+        uint64_t pressureMs;
+        uint64_t writebacks;
+    };
+
+    PressureMonitor(const std::string& root, const MemoryPolicy& policy);
+
+    bool init();
+    void run();
+
+  private:
+    bool readSomeAvg10(float* avg10);
+    void enterPressure();
+    void leavePressure();
+    void writebackIdle();
+
+    std::string mRoot;
+    const MemoryPolicy& mPolicy;
+    android::base::unique_fd mPsiFd;
+    bool mUnderPressure = false;
+    int64_t mPressureStartMs = 0;
+    Stats mStats = {};
+};
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "konatuner"
+
+#include "Profile.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/strings.h>
+#include <algorithm>
+#include <ctype.h>
+
+/*
+ * Splits a profile line into words. A double quoted word may hold spaces,
+ * a # outside quotes starts a comment.
+ */
+static bool splitWords(const std::string& line, std::vector<std::string>* words) {
+    size_t i = 0;
+
+    words->clear();
+    while (i < line.size()) {
+        std::string word;
+
+        if (isspace(line[i])) {
+            i++;
+            continue;
+        }
+        if (line[i] == '#') {
+            break;
+        }
+
+        if (line[i] == '"') {
+            size_t end = line.find('"', i + 1);
+            if (end == std::string::npos) {
+                return false;
+            }
+            word = line.substr(i + 1, end - i - 1);
+            i = end + 1;
+        } else {
+            while (i < line.size() && !isspace(line[i])) {
+                word += line[i++];
+            }
+        }
+
+        words->push_back(word);
+    }
+
+    return true;
+}
+
+// var=a|b or var!=a|b
+static bool parseCondition(const std::string& word, TuneCondition* condition) {
+    size_t eq = word.find('=');
+
+    if (eq == std::string::npos || eq == 0) {
+        return false;
+    }
+
+    condition->negate = word[eq - 1] == '!';
+    condition->var = word.substr(0, condition->negate ? eq - 1 : eq);
+    condition->values = android::base::Split(word.substr(eq + 1), "|");
+    return !condition->var.empty();
+}
+
+/** Reads a tuning profile
+ *
+ *  group <name>
+ *      <path> <value> [if <var>=<a>|<b> ...]
+ *
+ *  Paths may use glob patterns and must be absolute, values holding spaces
+ *  are double quoted and every condition after "if" has to hold.
+ */
+bool parseProfile(const std::string& path, std::vector<TuneGroup>* groups) {
+    std::string content;
+    std::vector<std::string> words;
+    int lineNo = 0;
+
+    if (!android::base::ReadFileToString(path, &content)) {
+        PLOG(ERROR) << "failed to read " << path;
+        return false;
+    }
+
+    groups->clear();
+    for (auto& line : android::base::Split(content, "\n")) {
+        TuneWrite write;
+
+        lineNo++;
+        if (!splitWords(line, &words)) {
+            LOG(ERROR) << path << ":" << lineNo << ": unterminated quote";
+            return false;
+        }
+        if (words.empty()) {
+            continue;
+        }
+
+        if (words[0] == "group") {
+            if (words.size() != 2) {
+                LOG(ERROR) << path << ":" << lineNo << ": group takes a name";
+                return false;
+            }
+            groups->push_back({words[1], {}});
+            continue;
+        }
+
+        if (groups->empty() || words.size() < 2 || words[0][0] != '/' ||
+            (words.size() > 2 && (words[2] != "if" || words.size() == 3))) {
+            LOG(ERROR) << path << ":" << lineNo << ": expected <path> <value> [if <conditions>]";
+            return false;
+        }
+
+        write.path = words[0];
+        write.value = words[1];
+        write.line = lineNo;
+        for (size_t i = 3; i < words.size(); i++) {
+            TuneCondition condition;
+
+            if (!parseCondition(words[i], &condition)) {
+                LOG(ERROR) << path << ":" << lineNo << ": bad condition " << words[i];
+                return false;
+            }
+            write.conditions.push_back(condition);
+        }
+
+        groups->back().writes.push_back(write);
+    }
+
+    return true;
+}
+
+/*
+ * A variable that couldn't be read has the empty value, so its != conditions
+ * still hold, the way post_boot's string tests treat an unreadable node.
+ */
+bool conditionsMet(const TuneWrite& write, const std::map<std::string, std::string>& vars) {
+    static const std::string kUnset;
+
+    for (auto& condition : write.conditions) {
+        auto it = vars.find(condition.var);
+        const std::string& value = it != vars.end() ? it->second : kUnset;
+        bool match;
+
+        match = std::find(condition.values.begin(), condition.values.end(), value) !=
+                condition.values.end();
+        if (match == condition.negate) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct TuneCondition {
+    std::string var;
+    bool negate;
+    std::vector<std::string> values;
+};
+
+struct TuneWrite {
+    // Relative to the root, may hold glob patterns
+    std::string path;
+    std::string value;
+    std::vector<TuneCondition> conditions;
+    int line;
+};
+
+// Writes of a group are applied in order, groups run in parallel
+struct TuneGroup {
+    std::string name;
+    std::vector<TuneWrite> writes;
+};
+
+bool parseProfile(const std::string& path, std::vector<TuneGroup>* groups);
+bool conditionsMet(const TuneWrite& write, const std::map<std::string, std::string>& vars);
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "konatuner"
+
+#include "Tuner.h"
+
+#include <android-base/logging.h>
+#include <android-base/unique_fd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <time.h>
+#include <unistd.h>
+#include <thread>
+#include <unordered_map>
+
+static int64_t nowUs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// A pattern without matches is not an error, the hardware it covers may be absent
+static std::vector<std::string> expandPath(const std::string& path) {
+    std::vector<std::string> paths;
+    glob_t matches;
+
+    if (path.find_first_of("*?[") == std::string::npos) {
+        return {path};
+    }
+
+    if (glob(path.c_str(), GLOB_NOSORT, nullptr, &matches) == 0) {
+        for (size_t i = 0; i < matches.gl_pathc; i++) {
+            paths.push_back(matches.gl_pathv[i]);
+        }
+    }
+    globfree(&matches);
+
+    return paths;
+}
+
+Tuner::Tuner(const std::string& root, const std::map<std::string, std::string>& vars)
+    : mRoot(root), mVars(vars) {}
+
+Tuner::Result Tuner::apply(const std::vector<TuneGroup>& groups) {
+    std::vector<Result> results(groups.size());
+    std::vector<std::thread> threads;
+    Result total = {};
+    int64_t start = nowUs();
+
+    for (size_t i = 0; i < groups.size(); i++) {
+        threads.emplace_back([this, &groups, &results, i] { results[i] = applyGroup(groups[i]); });
+    }
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+        LOG(DEBUG) << "group " << groups[i].name << ": " << results[i].written << " written, "
+                   << results[i].failed << " failed in " << results[i].elapsedUs << "us";
+        total.written += results[i].written;
+        total.skipped += results[i].skipped;
+        total.failed += results[i].failed;
+    }
+
+    total.elapsedUs = nowUs() - start;
+    return total;
+}
+
+Tuner::Result Tuner::applyGroup(const TuneGroup& group) {
+    std::unordered_map<std::string, android::base::unique_fd> fds;
+    Result result = {};
+    int64_t start = nowUs();
+
+    for (auto& write : group.writes) {
+        if (!conditionsMet(write, mVars)) {
+            result.skipped++;
+            continue;
+        }
+
+        for (auto& path : expandPath(mRoot + write.path)) {
+            auto& fd = fds[path];
+
+            if (fd.get() < 0) {
+                fd.reset(TEMP_FAILURE_RETRY(open(path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC)));
+            }
+
+            // sysfs takes a whole value per write from offset 0
+            if (fd.get() < 0 ||
+                TEMP_FAILURE_RETRY(pwrite(fd.get(), write.value.data(), write.value.size(), 0)) !=
+                        static_cast<ssize_t>(write.value.size())) {
+                PLOG(ERROR) << group.name << ": line " << write.line << ": failed to write "
+                            << write.value << " to " << path;
+                result.failed++;
+                continue;
+            }
+
+            result.written++;
+        }
+    }
+
+    result.elapsedUs = nowUs() - start;
+    return result;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Profile.h"
+
+/*
+ * Applies a profile below @root, which is "" on a device and a fake sysfs
+ * tree on a host. Every group gets its own thread and keeps the fds it
+ * opened for the paths it writes more than once.
+ */
+class Tuner {
+  public:
+    struct Result {
+        size_t written;
+        size_t skipped;
+        size_t failed;
+        int64_t elapsedUs;
+    };
+
+    Tuner(const std::string& root, const std::map<std::string, std::string>& vars);
+
+    Result apply(const std::vector<TuneGroup>& groups);
+
+  private:
+    Result applyGroup(const TuneGroup& group);
+
+    std::string mRoot;
+    std::map<std::string, std::string> mVars;
+};
@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "konaboostd"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/unique_fd.h>
+#include <cutils/sockets.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include "BoostArbiter.h"
+#include "BoostRequest.h"
+
+#define INPUT_DIR "/dev/input"
+// Notified with 1 on suspend and 0 on resume, the panel and touch go down together
+#define TOUCH_SUSPEND_PATH "/sys/devices/virtual/touch/touch_dev/touch_suspend_notify"
+#define INPUT_BOOST_MS_PATH "/sys/devices/system/cpu/cpu_boost/input_boost_ms"
+
+// Moving fingers re-request the touch boost at most this often
+#define TOUCH_MOVE_INTERVAL_MS 60
+
+#define MAX_EVENTS 8
+
+#define BITS_PER_LONG (sizeof(long) * 8)
+#define NLONGS(n) (((n) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+
+static bool testBit(const unsigned long* bits, int bit) {
+    return bits[bit / BITS_PER_LONG] & (1UL << (bit % BITS_PER_LONG));
+}
+
+static int64_t nowMs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// A touchscreen reports direct multitouch positions
+static bool isTouchscreen(int fd) {
+    unsigned long props[NLONGS(INPUT_PROP_CNT)] = {};
+    unsigned long abs[NLONGS(ABS_CNT)] = {};
+
+    return ioctl(fd, EVIOCGPROP(sizeof(props)), props) >= 0 &&
+           ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs)), abs) >= 0 &&
+           testBit(props, INPUT_PROP_DIRECT) && testBit(abs, ABS_MT_POSITION_X);
+}
+
+static std::vector<android::base::unique_fd> openTouchscreens(const std::string& root) {
+    std::vector<android::base::unique_fd> fds;
+    std::string dir = root + INPUT_DIR;
+    DIR* input = opendir(dir.c_str());
+    struct dirent* entry;
+
+    if (!input) {
+        PLOG(ERROR) << "failed to open " << dir;
+        return fds;
+    }
+
+    while ((entry = readdir(input))) {
+        if (strncmp(entry->d_name, "event", strlen("event"))) {
+            continue;
+        }
+
+        std::string path = dir + "/" + entry->d_name;
+        android::base::unique_fd fd(
+                TEMP_FAILURE_RETRY(open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC)));
+        if (fd.get() >= 0 && isTouchscreen(fd.get())) {
+            LOG(INFO) << "watching touchscreen " << path;
+            fds.push_back(std::move(fd));
+        }
+    }
+    closedir(input);
+
+    return fds;
+}
+
+class BoostDaemon {
+  public:
+    explicit BoostDaemon(const std::string& root) : mRoot(root), mArbiter(root) {}
+
+    bool init();
+    void run();
+
+  private:
+    bool watch(int fd, uint32_t events);
+    bool listenForClients();
+    void onTouch(int fd);
+    void onTouchSuspend();
+    void onConnect();
+    void onClient(int fd);
+    bool onSignal();
+
+    std::string mRoot;
+    BoostArbiter mArbiter;
+    android::base::unique_fd mEpollFd;
+    android::base::unique_fd mSignalFd;
+    android::base::unique_fd mSuspendFd;
+    android::base::unique_fd mSocketFd;
+    std::vector<android::base::unique_fd> mTouchFds;
+    std::vector<android::base::unique_fd> mClientFds;
+    bool mDisplayOn = true;
+    bool mTouching = false;
+    int64_t mLastMoveMs = 0;
+};
+
+bool BoostDaemon::init() {
+    sigset_t mask;
+
+    if (!mArbiter.init()) {
+        LOG(ERROR) << "nothing to boost";
+        return false;
+    }
+
+    // Touch boosts come from here now, two of them would only stack up
+    if (!android::base::WriteStringToFile("0", mRoot + INPUT_BOOST_MS_PATH) &&
+        errno != ENOENT) {
+        PLOG(WARNING) << "failed to disable the cpu_boost input boost";
+    }
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGTERM);
+    if (sigprocmask(SIG_BLOCK, &mask, nullptr) < 0) {
+        PLOG(ERROR) << "failed to block signals";
+        return false;
+    }
+
+    mEpollFd.reset(epoll_create1(EPOLL_CLOEXEC));
+    mSignalFd.reset(signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC));
+    if (mEpollFd.get() < 0 || mSignalFd.get() < 0) {
+        PLOG(ERROR) << "failed to create event loop fds";
+        return false;
+    }
+
+    if (!watch(mSignalFd.get(), EPOLLIN) || !watch(mArbiter.timerFd(), EPOLLIN)) {
+        return false;
+    }
+
+    mTouchFds = openTouchscreens(mRoot);
+    for (auto& fd : mTouchFds) {
+        watch(fd.get(), EPOLLIN);
+    }
+
+    // sysfs signals a change with POLLPRI | POLLERR once the value was read
+    mSuspendFd.reset(TEMP_FAILURE_RETRY(
+            open((mRoot + TOUCH_SUSPEND_PATH).c_str(), O_RDONLY | O_CLOEXEC)));
+    if (mSuspendFd.get() >= 0 && watch(mSuspendFd.get(), EPOLLPRI | EPOLLERR)) {
+        onTouchSuspend();
+    } else {
+        PLOG(WARNING) << "not watching the display state";
+        mSuspendFd.reset();
+    }
+
+    if (!listenForClients()) {
+        LOG(WARNING) << "not taking boost requests";
+    }
+
+    return true;
+}
+
+/*
+ * init creates the socket for the service. Run by hand against a fake tree
+ * there is none, the socket is then bound inside the tree instead.
+ */
+bool BoostDaemon::listenForClients() {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    std::string path = mRoot + BOOSTD_SOCKET_PATH;
+
+    mSocketFd.reset(android_get_control_socket(BOOSTD_SOCKET));
+    if (mSocketFd.get() < 0 && !mRoot.empty()) {
+        if (path.size() >= sizeof(addr.sun_path)) {
+            LOG(ERROR) << path << " is too long for a socket";
+            return false;
+        }
+        strcpy(addr.sun_path, path.c_str());
+        unlink(path.c_str());
+
+        mSocketFd.reset(socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0));
+        if (mSocketFd.get() < 0 ||
+            bind(mSocketFd.get(), reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+            PLOG(ERROR) << "failed to bind " << path;
+            mSocketFd.reset();
+        }
+    }
+
+    if (mSocketFd.get() < 0) {
+        return false;
+    }
+
+    if (listen(mSocketFd.get(), 4) < 0) {
+        PLOG(ERROR) << "failed to listen on " << BOOSTD_SOCKET;
+        mSocketFd.reset();
+        return false;
+    }
+
+    return watch(mSocketFd.get(), EPOLLIN);
+}
+
+void BoostDaemon::run() {
+    struct epoll_event events[MAX_EVENTS];
+
+    while (true) {
+        int count = TEMP_FAILURE_RETRY(epoll_wait(mEpollFd.get(), events, MAX_EVENTS, -1));
+        if (count < 0) {
+            PLOG(ERROR) << "failed to wait for events";
+            return;
+        }
+
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+
+            if (fd == mSignalFd.get()) {
+                if (!onSignal()) {
+                    return;
+                }
+            } else if (fd == mArbiter.timerFd()) {
+                mArbiter.onTimer();
+            } else if (fd == mSuspendFd.get()) {
+                onTouchSuspend();
+            } else if (fd == mSocketFd.get()) {
+                onConnect();
+            } else if (std::any_of(mClientFds.begin(), mClientFds.end(),
+                                   [fd](const auto& client) { return client.get() == fd; })) {
+                onClient(fd);
+            } else {
+                onTouch(fd);
+            }
+        }
+    }
+}
+
+bool BoostDaemon::watch(int fd, uint32_t events) {
+    struct epoll_event ev = {
+            .events = events,
+            .data = {.fd = fd},
+    };
+
+    if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, fd, &ev) < 0) {
+        PLOG(ERROR) << "failed to watch fd " << fd;
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * A finger going down asks for a touch boost, moving fingers keep it up and
+ * the last finger lifting asks for a fling boost for the animation to come.
+ */
+void BoostDaemon::onTouch(int fd) {
+    struct input_event events[64];
+    ssize_t len;
+
+    while ((len = TEMP_FAILURE_RETRY(read(fd, events, sizeof(events)))) > 0) {
+        for (size_t i = 0; i < len / sizeof(events[0]); i++) {
+            const struct input_event& ev = events[i];
+
+            if (ev.type == EV_KEY && ev.code == BTN_TOUCH) {
+                mTouching = ev.value;
+                mLastMoveMs = nowMs();
+                mArbiter.request(mTouching ? BOOST_TOUCH : BOOST_FLING);
+            } else if (ev.type == EV_ABS && mTouching &&
+                       nowMs() - mLastMoveMs >= TOUCH_MOVE_INTERVAL_MS) {
+                mLastMoveMs = nowMs();
+                mArbiter.request(BOOST_TOUCH);
+            }
+        }
+    }
+
+    if (len < 0 && errno != EAGAIN) {
+        PLOG(ERROR) << "failed to read touch events";
+    }
+}
+
+void BoostDaemon::onTouchSuspend() {
+    char buf[16] = {};
+    bool on;
+
+    if (TEMP_FAILURE_RETRY(pread(mSuspendFd.get(), buf, sizeof(buf) - 1, 0)) <= 0) {
+        PLOG(ERROR) << "failed to read the touch suspend state";
+        return;
+    }
+
+    on = atoi(buf) == 0;
+    if (on == mDisplayOn) {
+        return;
+    }
+
+    mDisplayOn = on;
+    if (on) {
+        mArbiter.request(BOOST_WAKE);
+    } else {
+        mArbiter.cancelAll();
+    }
+}
+
+void BoostDaemon::onConnect() {
+    android::base::unique_fd fd(
+            TEMP_FAILURE_RETRY(accept4(mSocketFd.get(), nullptr, nullptr,
+                                       SOCK_NONBLOCK | SOCK_CLOEXEC)));
+
+    if (fd.get() < 0) {
+        PLOG(ERROR) << "failed to accept a client";
+        return;
+    }
+
+    if (watch(fd.get(), EPOLLIN)) {
+        mClientFds.push_back(std::move(fd));
+    }
+}
+
+/*
+ * Applies the requests a client sent. A client that goes away mid-boost,
+ * e.g. a crashing fingerprint HAL, has its boost dropped with it.
+ */
+void BoostDaemon::onClient(int fd) {
+    uint8_t requests[16];
+    ssize_t len;
+
+    while ((len = TEMP_FAILURE_RETRY(recv(fd, requests, sizeof(requests), 0))) > 0) {
+        for (ssize_t i = 0; i < len; i++) {
+            switch (requests[i]) {
+                case BOOST_REQUEST_AUTH_ACQUIRE:
+                    mArbiter.request(BOOST_AUTH);
+                    break;
+                case BOOST_REQUEST_AUTH_RELEASE:
+                    mArbiter.cancel(BOOST_AUTH);
+                    break;
+                default:
+                    LOG(WARNING) << "unknown boost request " << static_cast<int>(requests[i]);
+                    break;
+            }
+        }
+    }
+
+    if (len < 0 && errno == EAGAIN) {
+        return;
+    }
+    if (len < 0) {
+        PLOG(ERROR) << "failed to read boost requests";
+    }
+
+    // Closing the fd also takes it out of the epoll set
+    mClientFds.erase(std::remove_if(mClientFds.begin(), mClientFds.end(),
+                                    [fd](const auto& client) { return client.get() == fd; }),
+                     mClientFds.end());
+    mArbiter.cancel(BOOST_AUTH);
+}
+
+// SIGUSR1 logs the stats, SIGTERM drops all boosts and ends the loop
+bool BoostDaemon::onSignal() {
+    struct signalfd_siginfo info;
+
+    while (TEMP_FAILURE_RETRY(read(mSignalFd.get(), &info, sizeof(info))) == sizeof(info)) {
+        if (info.ssi_signo == SIGTERM) {
+            mArbiter.cancelAll();
+            mArbiter.logStats();
+            return false;
+        }
+        mArbiter.logStats();
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string root;
+
+    android::base::InitLogging(argv);
+
+    if (argc == 3 && !strcmp(argv[1], "--root")) {
+        root = argv[2];
+    } else if (argc != 1) {
+        LOG(ERROR) << "usage: " << argv[0] << " [--root <dir>]";
+        return 2;
+    }
+
+    BoostDaemon daemon(root);
+    if (!daemon.init()) {
+        return 1;
+    }
+    daemon.run();
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "konabootprof"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/parseint.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "BootProfiler.h"
+#include "BootTrace.h"
+
+#ifdef __ANDROID__
+#define DEFAULT_SHELL "/vendor/bin/sh"
+#define DEFAULT_TMP_DIR "/data/local/tmp"
+#else
+// The scripts use function definitions dash doesn't know
+#define DEFAULT_SHELL "/bin/bash"
+#define DEFAULT_TMP_DIR "/tmp"
+#endif
+
+#define DEFAULT_TIMEOUT_S 60
+#define DEFAULT_SLOW_MS 10
+
+static void usage(const char* argv0) {
+    LOG(ERROR) << "usage: " << argv0
+               << " [--root <dir>] [--shell <sh>] [--timeout <s>] [--slow-ms <ms>]"
+                  " [--trace <file>] [--summary <file>] [--rc <file>]... <script>...";
+    LOG(ERROR) << "       " << argv0 << " --dump <trace> [--summary <file>]";
+}
+
+static bool writeSummary(const std::vector<TraceStage>& stages, const std::string& path) {
+    std::string summary = formatSummary(stages);
+
+    if (path.empty()) {
+        return android::base::WriteStringToFd(summary, STDOUT_FILENO);
+    }
+    if (!android::base::WriteStringToFile(summary, path)) {
+        PLOG(ERROR) << "failed to write " << path;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    ProfileOptions options = {
+            .root = "",
+            .shell = DEFAULT_SHELL,
+            .tmpDir = DEFAULT_TMP_DIR,
+            .timeoutS = DEFAULT_TIMEOUT_S,
+            .slowUs = DEFAULT_SLOW_MS * 1000,
+    };
+    // Scripts and rc files in the order given, the latter flagged
+    std::vector<std::pair<std::string, bool>> inputs;
+    std::vector<TraceStage> stages;
+    std::string tracePath, summaryPath, dumpPath;
+    bool failed = false;
+    int slowMs;
+
+    android::base::InitLogging(argv);
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+
+        if (!strcmp(argv[i], "--root") && hasValue) {
+            options.root = argv[++i];
+        } else if (!strcmp(argv[i], "--shell") && hasValue) {
+            options.shell = argv[++i];
+        } else if (!strcmp(argv[i], "--timeout") && hasValue) {
+            if (!android::base::ParseInt(argv[++i], &options.timeoutS, 0)) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (!strcmp(argv[i], "--slow-ms") && hasValue) {
+            if (!android::base::ParseInt(argv[++i], &slowMs, 0)) {
+                usage(argv[0]);
+                return 2;
+            }
+            options.slowUs = slowMs * 1000LL;
+        } else if (!strcmp(argv[i], "--trace") && hasValue) {
+            tracePath = argv[++i];
+        } else if (!strcmp(argv[i], "--summary") && hasValue) {
+            summaryPath = argv[++i];
+        } else if (!strcmp(argv[i], "--dump") && hasValue) {
+            dumpPath = argv[++i];
+        } else if (!strcmp(argv[i], "--rc") && hasValue) {
+            inputs.emplace_back(argv[++i], true);
+        } else if (argv[i][0] != '-') {
+            inputs.emplace_back(argv[i], false);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (!dumpPath.empty()) {
+        if (!inputs.empty()) {
+            usage(argv[0]);
+            return 2;
+        }
+        return readTrace(dumpPath, &stages) && writeSummary(stages, summaryPath) ? 0 : 2;
+    }
+
+    if (inputs.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    ScriptProfiler profiler(options);
+    for (auto& [path, rc] : inputs) {
+        TraceStage stage;
+
+        if (!(rc ? profileServices(path, &stage) : profiler.run(path, &stage))) {
+            failed = true;
+            continue;
+        }
+
+        if (!rc && (!WIFEXITED(stage.status) || WEXITSTATUS(stage.status))) {
+            LOG(WARNING) << path << " failed with status " << stage.status;
+            failed = true;
+        }
+        stages.push_back(std::move(stage));
+    }
+
+    if (!tracePath.empty() && !writeTrace(tracePath, stages)) {
+        failed = true;
+    }
+    if (!writeSummary(stages, summaryPath)) {
+        failed = true;
+    }
+
+    return failed ? 1 : 0;
+}
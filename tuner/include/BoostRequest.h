@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// The init socket konaboostd takes requests on, a SOCK_SEQPACKET one
+#define BOOSTD_SOCKET "konaboostd"
+#define BOOSTD_SOCKET_PATH "/dev/socket/" BOOSTD_SOCKET
+
+/*
+ * A request is a single byte. An acquired boost lasts until it is released,
+ * the client disconnects or its timeout runs out, acquiring it again while
+ * it runs restarts the timeout.
+ */
+enum BoostRequest : uint8_t {
+    BOOST_REQUEST_AUTH_ACQUIRE = 1,
+    BOOST_REQUEST_AUTH_RELEASE,
+};
@@ -0,0 +1,132 @@
+#
+# Copyright (C) 2026 The LineageOS Project
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# kona branch of init.qcom.post_boot.sh, applied by konatuner. Groups run in
+# parallel, so a path must only ever be written from one of them.
+#
+# Variables: rev is /sys/devices/soc0/revision, ddr the type from
+# /proc/device-tree/memory/ddr_device_type (07 LPDDR4X, 08 LPDDR5). A variable
+# that can't be read is empty, so only its != conditions hold.
+#
+
+group core_ctl
+    # Core control parameters for gold
+    /sys/devices/system/cpu/cpu4/core_ctl/min_cpus 2
+    /sys/devices/system/cpu/cpu4/core_ctl/busy_up_thres 60
+    /sys/devices/system/cpu/cpu4/core_ctl/busy_down_thres 30
+    /sys/devices/system/cpu/cpu4/core_ctl/offline_delay_ms 100
+    /sys/devices/system/cpu/cpu4/core_ctl/task_thres 3
+
+    # Core control parameters for gold+
+    /sys/devices/system/cpu/cpu7/core_ctl/min_cpus 0
+    /sys/devices/system/cpu/cpu7/core_ctl/busy_up_thres 60
+    /sys/devices/system/cpu/cpu7/core_ctl/busy_down_thres 30
+    /sys/devices/system/cpu/cpu7/core_ctl/offline_delay_ms 100
+    /sys/devices/system/cpu/cpu7/core_ctl/task_thres 1
+    # At least 4 tasks eligible to run on gold trigger assistance from gold+
+    /sys/devices/system/cpu/cpu7/core_ctl/nr_prev_assist_thresh 1
+
+    # Disable core control on silver
+    /sys/devices/system/cpu/cpu0/core_ctl/enable 0
+
+group sched
+    # b.L scheduler parameters
+    /proc/sys/kernel/sched_upmigrate "95 95"
+    /proc/sys/kernel/sched_downmigrate "85 85"
+    /proc/sys/kernel/sched_group_upmigrate 100
+    /proc/sys/kernel/sched_group_downmigrate 85
+    /proc/sys/kernel/sched_walt_rotate_big_tasks 1
+    /proc/sys/kernel/sched_coloc_downmigrate_ns 400000000
+
+    # cpuset parameters
+    /dev/cpuset/background/cpus 0-3
+    /dev/cpuset/system-background/cpus 0-3
+
+    # Turn off scheduler boost at the end
+    /proc/sys/kernel/sched_boost 0
+
+group silver
+    /sys/devices/system/cpu/cpufreq/policy0/scaling_governor schedutil
+    /sys/devices/system/cpu/cpufreq/policy0/schedutil/down_rate_limit_us 0
+    /sys/devices/system/cpu/cpufreq/policy0/schedutil/up_rate_limit_us 0
+    /sys/devices/system/cpu/cpufreq/policy0/schedutil/hispeed_freq 1248000 if rev=2.0|2.1
+    /sys/devices/system/cpu/cpufreq/policy0/schedutil/hispeed_freq 1228800 if rev!=2.0|2.1
+    /sys/devices/system/cpu/cpufreq/policy0/scaling_min_freq 691200
+    /sys/devices/system/cpu/cpufreq/policy0/schedutil/pl 1
+
+    # Input boost is left to konaboostd
+
+group gold
+    /sys/devices/system/cpu/cpufreq/policy4/scaling_governor schedutil
+    /sys/devices/system/cpu/cpufreq/policy4/schedutil/down_rate_limit_us 0
+    /sys/devices/system/cpu/cpufreq/policy4/schedutil/up_rate_limit_us 0
+    /sys/devices/system/cpu/cpufreq/policy4/schedutil/hispeed_freq 1574400
+    /sys/devices/system/cpu/cpufreq/policy4/schedutil/pl 1
+
+group gold_plus
+    /sys/devices/system/cpu/cpufreq/policy7/scaling_governor schedutil
+    /sys/devices/system/cpu/cpufreq/policy7/schedutil/down_rate_limit_us 0
+    /sys/devices/system/cpu/cpufreq/policy7/schedutil/up_rate_limit_us 0
+    /sys/devices/system/cpu/cpufreq/policy7/schedutil/hispeed_freq 1632000 if rev=2.0|2.1
+    /sys/devices/system/cpu/cpufreq/policy7/schedutil/hispeed_freq 1612800 if rev!=2.0|2.1
+    /sys/devices/system/cpu/cpufreq/policy7/schedutil/pl 1
+
+group cpu_llcc_bw
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/governor bw_hwmon
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/bw_hwmon/mbps_zones "4577 7110 9155 12298 14236 15258"
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/bw_hwmon/sample_ms 4
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/bw_hwmon/io_percent 50
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/bw_hwmon/hist_memory 20
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/bw_hwmon/hyst_length 10
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/bw_hwmon/down_thres 30
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/bw_hwmon/guard_band_mbps 0
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/bw_hwmon/up_scale 250
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/bw_hwmon/idle_mbps 1600
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/max_freq 14236
+    /sys/devices/platform/soc/*cpu-cpu-llcc-bw/devfreq/*cpu-cpu-llcc-bw/polling_interval 40
+
+group cpu_llcc_ddr_bw
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/governor bw_hwmon
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/bw_hwmon/mbps_zones "1720 2086 2929 3879 5161 5931 6881 7980" if ddr=07
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/bw_hwmon/mbps_zones "1720 2086 2929 3879 5931 6881 7980 10437" if ddr=08
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/bw_hwmon/sample_ms 4
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/bw_hwmon/io_percent 80
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/bw_hwmon/hist_memory 20
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/bw_hwmon/hyst_length 10
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/bw_hwmon/down_thres 30
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/bw_hwmon/guard_band_mbps 0
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/bw_hwmon/up_scale 250
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/bw_hwmon/idle_mbps 1600
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/max_freq 6881
+    /sys/devices/platform/soc/*cpu-llcc-ddr-bw/devfreq/*cpu-llcc-ddr-bw/polling_interval 40
+
+# The NPU has to be powered up while its bandwidth monitors are set up
+group npu_bw
+    /sys/devices/virtual/npu/msm_npu/pwr 1
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/governor bw_hwmon
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/bw_hwmon/mbps_zones "1720 2086 2929 3879 5931 6881 7980" if ddr=07
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/bw_hwmon/mbps_zones "1720 2086 2929 3879 5931 6881 7980 10437" if ddr=08
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/bw_hwmon/sample_ms 4
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/bw_hwmon/io_percent 160
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/bw_hwmon/hist_memory 20
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/bw_hwmon/hyst_length 10
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/bw_hwmon/down_thres 30
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/bw_hwmon/guard_band_mbps 0
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/bw_hwmon/up_scale 250
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/bw_hwmon/idle_mbps 1600
+    /sys/devices/platform/soc/*npu*-ddr-bw/devfreq/*npu*-ddr-bw/polling_interval 40
+
+    /sys/devices/platform/soc/*npu*-llcc-bw/devfreq/*npu*-llcc-bw/governor bw_hwmon
+    /sys/devices/platform/soc/*npu*-llcc-bw/devfreq/*npu*-llcc-bw/bw_hwmon/mbps_zones "4577 7110 9155 12298 14236 15258"
+    /sys/devices/platform/soc/*npu*-llcc-bw/devfreq/*npu*-llcc-bw/bw_hwmon/sample_ms 4
+    /sys/devices/platform/soc/*npu*-llcc-bw/devfreq/*npu*-llcc-bw/bw_hwmon/io_percent 160
+    /sys/devices/platform/soc/*npu*-llcc-bw/devfreq/*npu*-llcc-bw/bw_hwmon/hist_memory 20
+    /sys/devices/platform/soc/*npu*-llcc-bw/devfreq/*npu*-llcc-bw/bw_hwmon/hyst_length 10
+    /sys/devices/platform/soc/*npu*-llcc-bw/devfreq/*npu*-llcc-bw/bw_hwmon/down_thres 30
+    /sys/devices/platform/soc/*npu*-llcc-bw/devfreq/*npu*-llcc-bw/bw_hwmon/guard_band_mbps 0
+    /sys/devices/platform/soc/*npu*-llcc-bw/devfreq/*npu*-llcc-bw/bw_hwmon/up_scale 250
+    /sys/devices/platform/soc/*npu*-llcc-bw/devfreq/*npu*-llcc-bw/bw_hwmon/idle_mbps 1600
+    /sys/devices/platform/soc/*npu*-llcc-bw/devfreq/*npu*-llcc-bw/polling_interval 40
+    /sys/devices/virtual/npu/msm_npu/pwr 0
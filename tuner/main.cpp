@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "konatuner"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <string.h>
+
+#include "Profile.h"
+#include "Tuner.h"
+
+#define SOC_REVISION_PATH "/sys/devices/soc0/revision"
+#define DDR_TYPE_PATH "/proc/device-tree/memory/ddr_device_type"
+
+static std::map<std::string, std::string> readVars(const std::string& root) {
+    std::map<std::string, std::string> vars;
+    std::string value;
+
+    if (android::base::ReadFileToString(root + SOC_REVISION_PATH, &value)) {
+        vars["rev"] = android::base::Trim(value);
+    }
+
+    // A big endian u32, its low byte as the two hex digits post_boot compared
+    if (android::base::ReadFileToString(root + DDR_TYPE_PATH, &value) && !value.empty()) {
+        vars["ddr"] = android::base::StringPrintf("%02x", static_cast<uint8_t>(value.back()));
+    }
+
+    return vars;
+}
+
+static void usage(const char* argv0) {
+    LOG(ERROR) << "usage: " << argv0 << " [--root <dir>] <profile>";
+}
+
+int main(int argc, char** argv) {
+    std::vector<TuneGroup> groups;
+    std::string root;
+    const char* profile = nullptr;
+
+    android::base::InitLogging(argv);
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--root") && i + 1 < argc) {
+            root = argv[++i];
+        } else if (!profile && argv[i][0] != '-') {
+            profile = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (!profile) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (!parseProfile(profile, &groups)) {
+        return 2;
+    }
+
+    auto vars = readVars(root);
+    for (auto& [name, value] : vars) {
+        LOG(DEBUG) << name << "=" << value;
+    }
+
+    auto result = Tuner(root, vars).apply(groups);
+    LOG(INFO) << "applied " << profile << ": " << result.written << " written, "
+              << result.skipped << " skipped, " << result.failed << " failed in "
+              << result.elapsedUs << "us";
+
+    return result.failed ? 1 : 0;
+}
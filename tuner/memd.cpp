@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "konamemd"
+
+#include <android-base/logging.h>
+#include <android-base/properties.h>
+#include <string.h>
+#include <time.h>
+
+#include "MemoryPolicy.h"
+#include "PressureMonitor.h"
+
+static int64_t nowUs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+int main(int argc, char** argv) {
+    std::string root;
+    bool oneshot = false;
+    uint64_t memTotalKb;
+    int64_t start = nowUs();
+    bool ok;
+
+    android::base::InitLogging(argv);
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--root") && i + 1 < argc) {
+            root = argv[++i];
+        } else if (!strcmp(argv[i], "--oneshot")) {
+            oneshot = true;
+        } else {
+            LOG(ERROR) << "usage: " << argv[0] << " [--root <dir>] [--oneshot]";
+            return 2;
+        }
+    }
+
+    memTotalKb = readMemTotalKb(root);
+    if (memTotalKb == 0) {
+        return 1;
+    }
+
+    auto& policy = selectPolicy(memTotalKb);
+    ok = applyMemoryPolicy(root, policy, memTotalKb,
+                           android::base::GetBoolProperty("ro.config.low_ram", false));
+    LOG(INFO) << "memory policy for " << memTotalKb << "kB applied in " << nowUs() - start
+              << "us" << (ok ? "" : " with failures");
+
+    if (oneshot) {
+        return ok ? 0 : 1;
+    }
+
+    PressureMonitor monitor(root, policy);
+    if (!monitor.init()) {
+        return 1;
+    }
+    monitor.run();
+
+    return 1;
+}
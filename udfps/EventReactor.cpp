@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "UdfpsHandler.xiaomi_kona"
+
+#include "EventReactor.h"
+
+#include <android-base/logging.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define MAX_EVENTS 8
+
+EventReactor::EventReactor() {}
+
+EventReactor::~EventReactor() {
+    stop();
+}
+
+bool EventReactor::start(std::function<void()> threadInit) {
+    struct epoll_event ev = {
+            .events = EPOLLIN,
+            .data = {.fd = -1},
+    };
+
+    mEpollFd.reset(epoll_create1(EPOLL_CLOEXEC));
+    mStopFd.reset(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    mTaskFd.reset(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    if (mEpollFd.get() < 0 || mStopFd.get() < 0 || mTaskFd.get() < 0) {
+        PLOG(ERROR) << "failed to create event loop fds";
+        return false;
+    }
+
+    ev.data.fd = mStopFd.get();
+    if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, mStopFd.get(), &ev) < 0) {
+        PLOG(ERROR) << "failed to watch stop fd";
+        return false;
+    }
+
+    ev.data.fd = mTaskFd.get();
+    if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, mTaskFd.get(), &ev) < 0) {
+        PLOG(ERROR) << "failed to watch task fd";
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mRunning = true;
+    }
+    mThread = std::thread(&EventReactor::threadLoop, this, std::move(threadInit));
+    return true;
+}
+
+/* Wake the loop up and wait for it, no callback or task runs once this returns */
+void EventReactor::stop() {
+    uint64_t one = 1;
+
+    if (!mThread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mRunning = false;
+        mTasks.clear();
+    }
+
+    if (TEMP_FAILURE_RETRY(write(mStopFd.get(), &one, sizeof(one))) != sizeof(one)) {
+        PLOG(ERROR) << "failed to stop event loop";
+    }
+    mThread.join();
+}
+
+bool EventReactor::add(int fd, uint32_t events, Callback callback) {
+    std::lock_guard<std::mutex> lock(mLock);
+    struct epoll_event ev = {
+            .events = events,
+            .data = {.fd = fd},
+    };
+
+    if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, fd, &ev) < 0) {
+        PLOG(ERROR) << "failed to watch fd " << fd;
+        return false;
+    }
+
+    mSources[fd] = std::make_shared<Callback>(std::move(callback));
+    return true;
+}
+
+/* Must be called before @fd is closed, pending events for it are dropped */
+void EventReactor::remove(int fd) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (mSources.erase(fd) && epoll_ctl(mEpollFd.get(), EPOLL_CTL_DEL, fd, nullptr) < 0) {
+        PLOG(ERROR) << "failed to unwatch fd " << fd;
+    }
+}
+
+bool EventReactor::post(Task task) {
+    uint64_t one = 1;
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (!mRunning) {
+            return false;
+        }
+        mTasks.push_back(std::move(task));
+    }
+
+    if (TEMP_FAILURE_RETRY(write(mTaskFd.get(), &one, sizeof(one))) != sizeof(one)) {
+        PLOG(ERROR) << "failed to wake event loop";
+    }
+    return true;
+}
+
+/* Tasks posted while these run wake the loop up again */
+void EventReactor::runTasks() {
+    std::deque<Task> tasks;
+    uint64_t count;
+
+    if (read(mTaskFd.get(), &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        PLOG(ERROR) << "failed to read task fd";
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        tasks.swap(mTasks);
+    }
+
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void EventReactor::threadLoop(std::function<void()> threadInit) {
+    struct epoll_event events[MAX_EVENTS];
+
+    if (threadInit) {
+        threadInit();
+    }
+
+    while (true) {
+        int count = TEMP_FAILURE_RETRY(epoll_wait(mEpollFd.get(), events, MAX_EVENTS, -1));
+        if (count < 0) {
+            PLOG(ERROR) << "failed to wait for events";
+            return;
+        }
+
+        for (int i = 0; i < count; i++) {
+            std::shared_ptr<Callback> callback;
+
+            if (events[i].data.fd == mStopFd.get()) {
+                return;
+            }
+
+            if (events[i].data.fd == mTaskFd.get()) {
+                runTasks();
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mLock);
+                auto it = mSources.find(events[i].data.fd);
+                if (it == mSources.end()) {
+                    continue;
+                }
+                callback = it->second;
+            }
+
+            (*callback)(events[i].events);
+        }
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <unordered_map>
+
+/*
+ * Single threaded epoll loop. Sources are plain fds with a callback that gets
+ * the epoll events, added and removed at any time, also from a callback. The
+ * loop blocks until one of them is ready, so it never wakes up on its own.
+ * Tasks posted from other threads run on the loop in the order they came in.
+ */
+class EventReactor {
+  public:
+    using Callback = std::function<void(uint32_t events)>;
+    using Task = std::function<void()>;
+
+    EventReactor();
+    ~EventReactor();
+
+    // @threadInit runs on the loop thread before it waits for the first event
+    bool start(std::function<void()> threadInit = nullptr);
+    void stop();
+    bool add(int fd, uint32_t events, Callback callback);
+    void remove(int fd);
+    // False if the loop isn't running, @task is dropped then
+    bool post(Task task);
+
+  private:
+    void runTasks();
+    void threadLoop(std::function<void()> threadInit);
+
+    android::base::unique_fd mEpollFd;
+    android::base::unique_fd mStopFd;
+    android::base::unique_fd mTaskFd;
+    std::mutex mLock;
+    std::unordered_map<int, std::shared_ptr<Callback>> mSources;
+    std::deque<Task> mTasks;
+    bool mRunning = false;
+    std::thread mThread;
+};
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "UdfpsHandler.xiaomi_kona"
+#define ATRACE_TAG ATRACE_TAG_HAL
+
+#include "UdfpsBoost.h"
+
+#include <BoostRequest.h>
+#include <android-base/logging.h>
+#include <cutils/trace.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+
+#define BOOST_TIMEOUT_MS 1000
+
+// The gold cores and the prime core, cpu7 alone may be isolated by core_ctl
+#define BOOST_CPU_FIRST 4
+#define BOOST_CPU_LAST 7
+
+// Prefixed to the socket, the host harness points it at a fake konaboostd
+#ifndef FS_ROOT
+#define FS_ROOT ""
+#endif
+
+static int64_t nowNs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+bool UdfpsBoost::init(EventReactor& reactor) {
+    mTimerFd.reset(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC));
+    if (mTimerFd.get() < 0) {
+        PLOG(ERROR) << "failed to create boost timer";
+        return false;
+    }
+
+    return reactor.add(mTimerFd.get(), EPOLLIN, [this](uint32_t) { onTimeout(); });
+}
+
+/*
+ * Starts a boost window or extends the running one, konaboostd restarts its
+ * own timeout on every request too.
+ */
+void UdfpsBoost::acquire() {
+    std::lock_guard<std::mutex> lock(mLock);
+    struct itimerspec spec = {};
+
+    if (mTimerFd.get() < 0) {
+        return;
+    }
+
+    sendLocked(BOOST_REQUEST_AUTH_ACQUIRE);
+    if (mStartNs == 0) {
+        mStartNs = nowNs();
+        ATRACE_INT("udfps.boost", 1);
+    }
+
+    spec.it_value.tv_sec = BOOST_TIMEOUT_MS / 1000;
+    spec.it_value.tv_nsec = BOOST_TIMEOUT_MS % 1000 * 1000000L;
+    if (timerfd_settime(mTimerFd.get(), 0, &spec, nullptr) < 0) {
+        PLOG(ERROR) << "failed to arm boost timer";
+    }
+}
+
+void UdfpsBoost::release(UdfpsBoostRelease reason) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    releaseLocked(reason);
+}
+
+UdfpsBoost::Stats UdfpsBoost::getStats() {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    return mStats;
+}
+
+/*
+ * Keeps the event loop off the little cores. Plain affinity needs no
+ * privilege, the fingerprint service runs without CAP_SYS_NICE so the loop
+ * stays SCHED_OTHER.
+ */
+void UdfpsBoost::pinThread() {
+    cpu_set_t cpus;
+
+    CPU_ZERO(&cpus);
+    for (int cpu = BOOST_CPU_FIRST; cpu <= BOOST_CPU_LAST; cpu++) {
+        CPU_SET(cpu, &cpus);
+    }
+
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+        PLOG(ERROR) << "failed to move event loop to the big cores";
+    }
+}
+
+void UdfpsBoost::onTimeout() {
+    std::lock_guard<std::mutex> lock(mLock);
+    uint64_t expirations;
+
+    if (read(mTimerFd.get(), &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+        PLOG(ERROR) << "failed to read boost timer";
+    }
+
+    releaseLocked(BOOST_RELEASE_TIMEOUT);
+}
+
+void UdfpsBoost::releaseLocked(UdfpsBoostRelease reason) {
+    struct itimerspec spec = {};
+    uint64_t ms;
+
+    if (mStartNs == 0) {
+        return;
+    }
+
+    if (timerfd_settime(mTimerFd.get(), 0, &spec, nullptr) < 0) {
+        PLOG(ERROR) << "failed to disarm boost timer";
+    }
+
+    sendLocked(BOOST_REQUEST_AUTH_RELEASE);
+
+    ms = (nowNs() - mStartNs) / 1000000;
+    mStartNs = 0;
+    mStats.windows++;
+    mStats.totalMs += ms;
+    mStats.maxMs = std::max(mStats.maxMs, ms);
+    mStats.released[reason]++;
+    ATRACE_INT("udfps.boost", 0);
+}
+
+/*
+ * Never blocks the caller, a request konaboostd can't take right now is
+ * dropped. A broken connection is re-established once, konaboostd may have
+ * been restarted since the last request.
+ */
+bool UdfpsBoost::sendLocked(uint8_t request) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+
+    strncpy(addr.sun_path, FS_ROOT BOOSTD_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (mSocketFd.get() < 0) {
+            mSocketFd.reset(socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+            if (mSocketFd.get() < 0 ||
+                connect(mSocketFd.get(), reinterpret_cast<struct sockaddr*>(&addr),
+                        sizeof(addr)) < 0) {
+                PLOG(ERROR) << "failed to connect to konaboostd";
+                mSocketFd.reset();
+                return false;
+            }
+        }
+
+        if (TEMP_FAILURE_RETRY(send(mSocketFd.get(), &request, sizeof(request),
+                                    MSG_NOSIGNAL)) == sizeof(request)) {
+            return true;
+        }
+        if (errno == EAGAIN) {
+            PLOG(ERROR) << "konaboostd isn't keeping up, dropped boost request";
+            return false;
+        }
+        mSocketFd.reset();
+    }
+
+    PLOG(ERROR) << "failed to send boost request";
+    return false;
+}
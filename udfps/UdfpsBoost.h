@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <mutex>
+#include <stdint.h>
+
+#include "EventReactor.h"
+
+enum UdfpsBoostRelease : uint32_t {
+    BOOST_RELEASE_GOOD,
+    BOOST_RELEASE_CANCEL,
+    BOOST_RELEASE_TIMEOUT,
+    BOOST_RELEASE_COUNT,
+};
+
+/*
+ * Asks konaboostd for its auth boost while the matcher runs, so an unlock on
+ * an idle device doesn't wait for the governors to ramp up. konaboostd owns
+ * the cpufreq and DDR bandwidth floors and merges this boost with its own,
+ * every boost is bounded by a timeout on the event loop here and there.
+ */
+class UdfpsBoost {
+  public:
+    struct Stats {
+        uint64_t windows;
+        uint64_t totalMs;
+        uint64_t maxMs;
+        uint64_t released[BOOST_RELEASE_COUNT];
+    };
+
+    bool init(EventReactor& reactor);
+    void acquire();
+    void release(UdfpsBoostRelease reason);
+    Stats getStats();
+
+    // Run on the event loop thread
+    static void pinThread();
+
+  private:
+    void onTimeout();
+    void releaseLocked(UdfpsBoostRelease reason);
+    bool sendLocked(uint8_t request);
+
+    std::mutex mLock;
+    android::base::unique_fd mTimerFd;
+    // Connected on first use, konaboostd only starts once boot completed
+    android::base::unique_fd mSocketFd;
+    int64_t mStartNs = 0;
+    Stats mStats = {};
+};
@@ -9,11 +9,22 @@
 #include "UdfpsHandler.h"
 
 #include <android-base/logging.h>
+#include <android-base/properties.h>
 #include <android-base/unique_fd.h>
+#include <Sysfs.h>
+#include <TouchFeature.h>
+#include <errno.h>
 #include <fcntl.h>
-#include <poll.h>
-#include <thread>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
 #include <unistd.h>
+#include <algorithm>
+#include <mutex>
+
+#include "EventReactor.h"
+#include "UdfpsBoost.h"
+#include "UdfpsTrace.h"
 
 #define COMMAND_NIT 10
 #define PARAM_NIT_FOD 1
@@ -22,103 +33,363 @@
 #define FOD_STATUS_ON 1
 #define FOD_STATUS_OFF -1
 
-#define TOUCH_DEV_PATH "/dev/xiaomi-touch"
-#define TOUCH_FOD_ENABLE 10
-#define TOUCH_MAGIC 0x5400
-#define TOUCH_IOC_SETMODE TOUCH_MAGIC + 0
+#define FOD_UI_RETRY_MIN_MS 100
+#define FOD_UI_RETRY_MAX_MS 5000
 
-static const char* kFodUiPaths[] = {
-        "/sys/devices/platform/soc/soc:qcom,dsi-display-primary/fod_ui",
-        "/sys/devices/platform/soc/soc:qcom,dsi-display/fod_ui",
-};
+#define FOD_UI_UNKNOWN -1
+
+#define FAST_NIT_PROP "persist.vendor.sys.fp.fast_nit"
+// How long fod_ui gets to confirm a NIT switch made on finger down
+#define FAST_NIT_CONFIRM_MS 300
 
-static bool readBool(int fd) {
-    char c;
-    int rc;
+// Log the unlock latency summary every this many good acquisitions
+#define TRACE_SUMMARY_INTERVAL 20
 
-    rc = lseek(fd, 0, SEEK_SET);
-    if (rc) {
-        LOG(ERROR) << "failed to seek fd, err: " << rc;
-        return false;
+// Prefixed to the nodes, the host harness points it at a fake tree
+#ifndef FS_ROOT
+#define FS_ROOT ""
+#endif
+
+static int64_t nowNs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void armTimer(int fd, int delayMs) {
+    struct itimerspec spec = {};
+
+    // A zero it_value would disarm the timer, expire right away instead
+    spec.it_value.tv_sec = delayMs / 1000;
+    spec.it_value.tv_nsec = std::max(delayMs % 1000 * 1000000L, 1L);
+    if (timerfd_settime(fd, 0, &spec, nullptr) < 0) {
+        PLOG(ERROR) << "failed to arm timer";
     }
+}
 
-    rc = read(fd, &c, sizeof(char));
-    if (rc != 1) {
-        LOG(ERROR) << "failed to read bool from fd, err: " << rc;
-        return false;
+static void disarmTimer(int fd) {
+    struct itimerspec spec = {};
+
+    if (timerfd_settime(fd, 0, &spec, nullptr) < 0) {
+        PLOG(ERROR) << "failed to disarm timer";
     }
+}
+
+static void drainTimer(int fd) {
+    uint64_t expirations;
 
-    return c != '0';
+    if (read(fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN) {
+        PLOG(ERROR) << "failed to read timer";
+    }
 }
 
+static const char* kFodUiPaths[] = {
+        FS_ROOT "/sys/devices/platform/soc/soc:qcom,dsi-display-primary/fod_ui",
+        FS_ROOT "/sys/devices/platform/soc/soc:qcom,dsi-display/fod_ui",
+};
+
 class XiaomiKonaUdfpsHandler : public UdfpsHandler {
   public:
+    ~XiaomiKonaUdfpsHandler() {
+        // No fod_ui callback may run past this point
+        mReactor.stop();
+        mBoost.release(BOOST_RELEASE_CANCEL);
+        logSummary();
+    }
+
     void init(fingerprint_device_t *device) {
         mDevice = device;
-        touch_fd_ = android::base::unique_fd(open(TOUCH_DEV_PATH, O_RDWR));
-
-        std::thread([this]() {
-            int fd;
-            for (auto& path : kFodUiPaths) {
-                fd = open(path, O_RDONLY);
-                if (fd >= 0) {
-                    break;
-                }
-            }
 
-            if (fd < 0) {
-                LOG(ERROR) << "failed to open fd, err: " << fd;
-                return;
-            }
+        mFastNit = android::base::GetBoolProperty(FAST_NIT_PROP, false);
 
-            struct pollfd fodUiPoll = {
-                    .fd = fd,
-                    .events = POLLERR | POLLPRI,
-                    .revents = 0,
-            };
-
-            while (true) {
-                int rc = poll(&fodUiPoll, 1, -1);
-                if (rc < 0) {
-                    LOG(ERROR) << "failed to poll fd, err: " << rc;
-                    continue;
-                }
-
-                mDevice->extCmd(mDevice, COMMAND_NIT,
-                                readBool(fd) ? PARAM_NIT_FOD : PARAM_NIT_NONE);
-            }
-        }).detach();
+        mRetryFd.reset(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC));
+        mConfirmFd.reset(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC));
+        if (mRetryFd.get() < 0 || mConfirmFd.get() < 0) {
+            PLOG(ERROR) << "failed to create fod_ui timers";
+            return;
+        }
+
+        if (!mReactor.start(UdfpsBoost::pinThread) ||
+            !mReactor.add(mRetryFd.get(), EPOLLIN, [this](uint32_t) { onRetryTimer(); }) ||
+            !mReactor.add(mConfirmFd.get(), EPOLLIN, [this](uint32_t) { onConfirmTimeout(); })) {
+            return;
+        }
+
+        mBoost.init(mReactor);
+
+        // fod_ui is only ever touched from the event loop, open it there too
+        scheduleOpen(0);
     }
 
-    void onFingerDown(uint32_t /*x*/, uint32_t /*y*/, float /*minor*/, float /*major*/) {
-        // nothing
+    /*
+     * With the fast path enabled the panel is switched to the FOD NIT mode
+     * right away instead of once fod_ui flips, which only happens after the
+     * framework has drawn the pressed icon and the display driver has caught
+     * up with it. fod_ui then only confirms the switch or rolls it back.
+     */
+    void onFingerDown(uint32_t x, uint32_t y, float minor, float major) {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        mTrace.record(STAGE_FINGER_DOWN);
+        if (mFastNit) {
+            LOG(DEBUG) << "finger down at " << x << "," << y << " (" << minor << "x" << major
+                       << "), switching to FOD NIT mode";
+            mFingerDownNs = nowNs();
+            mTouchFodBeforeDown = mTouchFodStatus;
+            setTouchFodLocked(FOD_STATUS_ON);
+            if (mFodUiState != 1) {
+                mAwaitingConfirm = true;
+                setNitLocked(PARAM_NIT_FOD);
+                armTimer(mConfirmFd.get(), FAST_NIT_CONFIRM_MS);
+            }
+        }
+
+        // Only once the panel switch is on its way, the boost request must not delay it
+        mBoost.acquire();
     }
 
     void onFingerUp() {
-        // nothing
+        std::lock_guard<std::mutex> lock(mLock);
+
+        mTrace.record(STAGE_FINGER_UP);
+        if (!mFastNit || mFingerDownNs == 0) {
+            return;
+        }
+
+        mFingerDownNs = 0;
+        if (mAwaitingConfirm) {
+            rollBackLocked();
+        }
+        setTouchFodLocked(mTouchFodBeforeDown);
     }
 
     void onAcquired(int32_t result, int32_t vendorCode) {
+        std::lock_guard<std::mutex> lock(mLock);
+
         if (result == FINGERPRINT_ACQUIRED_GOOD) {
-            int arg[2] = {TOUCH_FOD_ENABLE, FOD_STATUS_OFF};
-            ioctl(touch_fd_.get(), TOUCH_IOC_SETMODE, &arg);
+            mTrace.record(STAGE_ACQUIRED_GOOD);
+            mBoost.release(BOOST_RELEASE_GOOD);
+            setTouchFodLocked(FOD_STATUS_OFF);
+            if (++mGoodCount % TRACE_SUMMARY_INTERVAL == 0) {
+                logSummary();
+            }
         } else if (vendorCode == 21 || vendorCode == 23) {
             /*
              * vendorCode = 21 waiting for fingerprint authentication
              * vendorCode = 23 waiting for fingerprint enroll
              */
-            int arg[2] = {TOUCH_FOD_ENABLE, FOD_STATUS_ON};
-            ioctl(touch_fd_.get(), TOUCH_IOC_SETMODE, &arg);
+            mBoost.acquire();
+            setTouchFodLocked(FOD_STATUS_ON);
         }
     }
 
     void cancel() {
-        int arg[2] = {TOUCH_FOD_ENABLE, FOD_STATUS_OFF};
-        ioctl(touch_fd_.get(), TOUCH_IOC_SETMODE, &arg);
+        std::lock_guard<std::mutex> lock(mLock);
+
+        setTouchFodLocked(FOD_STATUS_OFF);
+        mBoost.release(BOOST_RELEASE_CANCEL);
     }
   private:
+    void logSummary() {
+        auto stats = xiaomi::TouchFeature::getInstance().getStats();
+        auto boost = mBoost.getStats();
+        auto sysfs = xiaomi::Sysfs::getInstance().getStats();
+
+        mTrace.summary();
+        LOG(INFO) << "touch modes: issued=" << stats.issued << " skipped=" << stats.skipped
+                  << " failed=" << stats.failed;
+        LOG(INFO) << "boost windows: count=" << boost.windows << " total=" << boost.totalMs
+                  << "ms max=" << boost.maxMs << "ms released by good="
+                  << boost.released[BOOST_RELEASE_GOOD]
+                  << " cancel=" << boost.released[BOOST_RELEASE_CANCEL]
+                  << " timeout=" << boost.released[BOOST_RELEASE_TIMEOUT];
+        LOG(INFO) << "sysfs: reads=" << sysfs.reads << " writes=" << sysfs.writes
+                  << " failed=" << sysfs.failed << " opens=" << sysfs.opens
+                  << " read=" << sysfs.readUs << "us max=" << sysfs.maxReadUs
+                  << "us write=" << sysfs.writeUs << "us max=" << sysfs.maxWriteUs << "us";
+    }
+
+    /*
+     * The panel and touch switches are decided under mLock but issued from the
+     * event loop, in the same order. The fingerprint HAL calls onAcquired() from
+     * its notify thread, which may be what a blocking extCmd() waits for.
+     */
+    void setTouchFodLocked(int status) {
+        mTouchFodStatus = status;
+        if (!mReactor.post([this, status] { applyTouchFod(status); })) {
+            LOG(ERROR) << "event loop down, dropped touch FOD status " << status;
+        }
+    }
+
+    void setNitLocked(int param) {
+        if (param == mNitParam) {
+            return;
+        }
+
+        mNitParam = param;
+        if (!mReactor.post([this, param] { applyNit(param); })) {
+            LOG(ERROR) << "event loop down, dropped NIT param " << param;
+        }
+    }
+
+    // Repeated acquire events keep asking for the same status, the touch layer drops those
+    void applyTouchFod(int status) {
+        int64_t startNs = nowNs();
+        bool issued;
+
+        xiaomi::TouchFeature::getInstance().setMode(TOUCH_MODE_FOD_ENABLE, status, &issued);
+        if (issued) {
+            mTrace.record(STAGE_TOUCH_SETMODE, status, nowNs() - startNs);
+        }
+    }
+
+    void applyNit(int param) {
+        int64_t startNs = nowNs();
+
+        mDevice->extCmd(mDevice, COMMAND_NIT, param);
+        if (param == PARAM_NIT_FOD) {
+            mTrace.record(STAGE_NIT_FOD, param, nowNs() - startNs);
+        }
+    }
+
+    // Undo a fast path NIT switch that fod_ui never confirmed
+    void rollBackLocked() {
+        mAwaitingConfirm = false;
+        disarmTimer(mConfirmFd.get());
+        if (mFodUiState != 1) {
+            setNitLocked(PARAM_NIT_NONE);
+        }
+    }
+
+    void onConfirmTimeout() {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        drainTimer(mConfirmFd.get());
+        if (mAwaitingConfirm) {
+            LOG(WARNING) << "fod_ui didn't confirm FOD NIT mode, rolling back";
+            rollBackLocked();
+        }
+    }
+
+    void scheduleOpen(int delayMs) { armTimer(mRetryFd.get(), delayMs); }
+
+    void onRetryTimer() {
+        drainTimer(mRetryFd.get());
+        openFodUi();
+    }
+
+    /*
+     * Opens the first fod_ui that exists and starts watching it. A device
+     * without fod_ui is left alone, any other failure is retried with an
+     * exponential backoff.
+     */
+    void openFodUi() {
+        int err = ENOENT;
+
+        for (auto& path : kFodUiPaths) {
+            mFodUiFd.reset(open(path, O_RDONLY | O_CLOEXEC));
+            if (mFodUiFd.get() >= 0) {
+                break;
+            }
+            if (errno != ENOENT) {
+                err = errno;
+            }
+        }
+
+        if (mFodUiFd.get() < 0) {
+            if (err == ENOENT && !mFodUiSeen) {
+                LOG(ERROR) << "no fod_ui node, NIT mode is left to the fingerprint HAL";
+                return;
+            }
+            LOG(ERROR) << "failed to open fod_ui, err: " << err << ", retrying in " << mRetryMs
+                       << "ms";
+            scheduleOpen(mRetryMs);
+            mRetryMs = std::min(mRetryMs * 2, FOD_UI_RETRY_MAX_MS);
+            return;
+        }
+
+        // sysfs signals a change with POLLPRI | POLLERR once the value was read
+        if (!mReactor.add(mFodUiFd.get(), EPOLLPRI | EPOLLERR,
+                          [this](uint32_t) { onFodUiChanged(); })) {
+            mFodUiFd.reset();
+            scheduleOpen(mRetryMs);
+            return;
+        }
+
+        mFodUiSeen = true;
+        mRetryMs = FOD_UI_RETRY_MIN_MS;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mFodUiState = FOD_UI_UNKNOWN;
+            mNitParam = FOD_UI_UNKNOWN;
+        }
+        onFodUiChanged();
+    }
+
+    void closeFodUi() {
+        mReactor.remove(mFodUiFd.get());
+        mFodUiFd.reset();
+    }
+
+    void onFodUiChanged() {
+        char c;
+        int state;
+
+        // pread() rewinds and reads in one go, and re-arms the notification
+        if (TEMP_FAILURE_RETRY(pread(mFodUiFd.get(), &c, sizeof(c), 0)) != sizeof(c)) {
+            PLOG(ERROR) << "failed to read fod_ui, reopening";
+            closeFodUi();
+            scheduleOpen(mRetryMs);
+            return;
+        }
+
+        state = c != '0';
+
+        std::lock_guard<std::mutex> lock(mLock);
+        if (state == mFodUiState) {
+            return;
+        }
+
+        mFodUiState = state;
+        if (state) {
+            mTrace.record(STAGE_FOD_UI_ON);
+        }
+        if (state && mAwaitingConfirm) {
+            mAwaitingConfirm = false;
+            disarmTimer(mConfirmFd.get());
+            LOG(DEBUG) << "fod_ui confirmed FOD NIT mode "
+                       << (nowNs() - mFingerDownNs) / 1000 << "us after finger down";
+        }
+
+        // The display driver has the last word, fod_ui going off ends a fast switch too
+        setNitLocked(state ? PARAM_NIT_FOD : PARAM_NIT_NONE);
+    }
+
     fingerprint_device_t *mDevice;
-    android::base::unique_fd touch_fd_;
+    bool mFastNit = false;
+
+    // Owned by the event loop thread once init() returns
+    android::base::unique_fd mFodUiFd;
+    android::base::unique_fd mRetryFd;
+    int mRetryMs = FOD_UI_RETRY_MIN_MS;
+    bool mFodUiSeen = false;
+
+    // Panel and touch state, shared between the binder threads and the event loop
+    std::mutex mLock;
+    android::base::unique_fd mConfirmFd;
+    int mFodUiState = FOD_UI_UNKNOWN;
+    int mNitParam = FOD_UI_UNKNOWN;
+    int mTouchFodStatus = FOD_STATUS_OFF;
+    int mTouchFodBeforeDown = FOD_STATUS_OFF;
+    bool mAwaitingConfirm = false;
+    int64_t mFingerDownNs = 0;
+    uint32_t mGoodCount = 0;
+
+    UdfpsTrace mTrace;
+    // Outlives the event loop, which runs its timeout
+    UdfpsBoost mBoost;
+    EventReactor mReactor;
 };
 
 static UdfpsHandler* create() {
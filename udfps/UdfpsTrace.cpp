@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "UdfpsHandler.xiaomi_kona"
+#define ATRACE_TAG ATRACE_TAG_HAL
+
+#include "UdfpsTrace.h"
+
+#include <algorithm>
+#include <android-base/logging.h>
+#include <cutils/trace.h>
+#include <time.h>
+
+static const char* kStageNames[STAGE_COUNT] = {
+        "finger_down", "fod_ui_on", "nit_fod", "acquired_good", "touch_setmode", "finger_up",
+};
+
+static int64_t nowNs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+template <typename Histogram>
+static void histogramRecord(Histogram& h, int64_t ns) {
+    uint64_t us = ns > 0 ? ns / 1000 : 0;
+    uint64_t max = h.maxUs.load(std::memory_order_relaxed);
+    int bucket = us ? 64 - __builtin_clzll(us) : 0;
+
+    h.buckets[std::min(bucket, UdfpsTrace::kBuckets - 1)].fetch_add(1, std::memory_order_relaxed);
+    h.count.fetch_add(1, std::memory_order_relaxed);
+    h.sumUs.fetch_add(us, std::memory_order_relaxed);
+    while (us > max && !h.maxUs.compare_exchange_weak(max, us, std::memory_order_relaxed))
+        ;
+}
+
+// Upper bound of the power of two bucket holding the percentile, capped by the max
+template <typename Histogram>
+static uint64_t histogramPercentileUs(const Histogram& h, uint64_t count, int percent) {
+    uint64_t target = (count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < UdfpsTrace::kBuckets; i++) {
+        seen += h.buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return std::min<uint64_t>(1ULL << i, h.maxUs.load(std::memory_order_relaxed));
+        }
+    }
+
+    return h.maxUs.load(std::memory_order_relaxed);
+}
+
+template <typename Histogram>
+static void histogramLog(const Histogram& h, const char* what, const char* stage) {
+    uint64_t count = h.count.load(std::memory_order_relaxed);
+
+    if (count == 0) {
+        return;
+    }
+
+    LOG(INFO) << "  " << stage << " " << what << ": count=" << count
+              << " avg=" << h.sumUs.load(std::memory_order_relaxed) / count
+              << "us p50<=" << histogramPercentileUs(h, count, 50)
+              << "us p99<=" << histogramPercentileUs(h, count, 99)
+              << "us max=" << h.maxUs.load(std::memory_order_relaxed) << "us";
+}
+
+UdfpsTrace::UdfpsTrace() : mNext(0), mFingerDownNs(0) {
+    for (auto& rec : mRecords) {
+        rec.seq.store(0, std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < STAGE_COUNT; i++) {
+        for (auto* h : {&mSinceDown[i], &mDuration[i]}) {
+            for (auto& bucket : h->buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            h->count.store(0, std::memory_order_relaxed);
+            h->sumUs.store(0, std::memory_order_relaxed);
+            h->maxUs.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+/*
+ * Safe from any thread. A record is published by its sequence number, which
+ * readers check before and after copying it out.
+ */
+void UdfpsTrace::record(UdfpsStage stage, int32_t arg, int64_t durationNs) {
+    int64_t now = nowNs();
+    uint64_t seq = mNext.fetch_add(1, std::memory_order_relaxed) + 1;
+    Record& rec = mRecords[(seq - 1) % kCapacity];
+    int64_t downNs;
+
+    rec.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    rec.timeNs.store(now, std::memory_order_relaxed);
+    rec.durationNs.store(durationNs, std::memory_order_relaxed);
+    rec.stage.store(stage, std::memory_order_relaxed);
+    rec.arg.store(arg, std::memory_order_relaxed);
+    rec.seq.store(seq, std::memory_order_release);
+
+    if (stage == STAGE_FINGER_DOWN) {
+        mFingerDownNs.store(now, std::memory_order_relaxed);
+        downNs = now;
+    } else {
+        downNs = mFingerDownNs.load(std::memory_order_relaxed);
+    }
+
+    if (durationNs > 0) {
+        histogramRecord(mDuration[stage], durationNs);
+    }
+    if (downNs != 0) {
+        histogramRecord(mSinceDown[stage], now - downNs);
+        ATRACE_INT64(kStageNames[stage], (now - downNs) / 1000);
+    }
+
+    if (stage == STAGE_FINGER_UP) {
+        mFingerDownNs.store(0, std::memory_order_relaxed);
+    }
+}
+
+// The last unlock, from its finger down on
+void UdfpsTrace::logRecent() {
+    uint64_t last = mNext.load(std::memory_order_acquire);
+    uint64_t first = last > kCapacity ? last - kCapacity + 1 : 1;
+    int64_t baseNs = 0;
+
+    for (uint64_t seq = last; seq >= first && seq > 0; seq--) {
+        const Record& rec = mRecords[(seq - 1) % kCapacity];
+        if (rec.seq.load(std::memory_order_acquire) == seq &&
+            rec.stage.load(std::memory_order_relaxed) == STAGE_FINGER_DOWN) {
+            first = seq;
+            baseNs = rec.timeNs.load(std::memory_order_relaxed);
+            break;
+        }
+    }
+
+    if (baseNs == 0) {
+        return;
+    }
+
+    LOG(INFO) << "last unlock:";
+    for (uint64_t seq = first; seq <= last; seq++) {
+        const Record& rec = mRecords[(seq - 1) % kCapacity];
+        if (rec.seq.load(std::memory_order_acquire) != seq) {
+            continue;
+        }
+
+        int64_t timeNs = rec.timeNs.load(std::memory_order_relaxed);
+        int64_t durationNs = rec.durationNs.load(std::memory_order_relaxed);
+        uint32_t stage = rec.stage.load(std::memory_order_relaxed);
+        int32_t arg = rec.arg.load(std::memory_order_relaxed);
+
+        // Overwritten while it was copied
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (rec.seq.load(std::memory_order_acquire) != seq || stage >= STAGE_COUNT) {
+            continue;
+        }
+
+        LOG(INFO) << "  +" << (timeNs - baseNs) / 1000 << "us " << kStageNames[stage]
+                  << " arg=" << arg << " took=" << durationNs / 1000 << "us";
+    }
+}
+
+void UdfpsTrace::summary() {
+    logRecent();
+
+    LOG(INFO) << "stage latency since finger down:";
+    for (uint32_t i = 0; i < STAGE_COUNT; i++) {
+        histogramLog(mSinceDown[i], "since down", kStageNames[i]);
+        histogramLog(mDuration[i], "duration", kStageNames[i]);
+    }
+}
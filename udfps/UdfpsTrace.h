@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+enum UdfpsStage : uint32_t {
+    STAGE_FINGER_DOWN,
+    STAGE_FOD_UI_ON,
+    STAGE_NIT_FOD,
+    STAGE_ACQUIRED_GOOD,
+    STAGE_TOUCH_SETMODE,
+    STAGE_FINGER_UP,
+    STAGE_COUNT,
+};
+
+/*
+ * Timestamps the stages of an unlock into a lock-free ring and mirrors them
+ * as atrace counters. Every stage also lands in a histogram of its latency
+ * since the last finger down, which summary() logs.
+ */
+class UdfpsTrace {
+  public:
+    static constexpr uint32_t kCapacity = 256;
+    static constexpr int kBuckets = 20;
+
+    UdfpsTrace();
+
+    // @durationNs is the time the stage itself took, e.g. an ioctl
+    void record(UdfpsStage stage, int32_t arg = 0, int64_t durationNs = 0);
+    void summary();
+
+  private:
+    // Relaxed atomics so a reader racing a writer sees a torn record, not UB
+    struct Record {
+        std::atomic<uint64_t> seq;
+        std::atomic<int64_t> timeNs;
+        std::atomic<int64_t> durationNs;
+        std::atomic<uint32_t> stage;
+        std::atomic<int32_t> arg;
+    };
+
+    struct Histogram {
+        std::atomic<uint64_t> buckets[kBuckets];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sumUs;
+        std::atomic<uint64_t> maxUs;
+    };
+
+    void logRecent();
+
+    Record mRecords[kCapacity];
+    std::atomic<uint64_t> mNext;
+    std::atomic<int64_t> mFingerDownNs;
+    Histogram mSinceDown[STAGE_COUNT];
+    Histogram mDuration[STAGE_COUNT];
+};
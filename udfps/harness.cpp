@@ -0,0 +1,590 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "udfps_harness"
+
+#include <BoostRequest.h>
+#include <UdfpsHandler.h>
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/properties.h>
+#include <android-base/unique_fd.h>
+#include <errno.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// What the handler sends, see UdfpsHandler.cpp and TouchFeature.cpp
+#define COMMAND_NIT 10
+#define PARAM_NIT_FOD 1
+#define PARAM_NIT_NONE 0
+#define TOUCH_IOC_SETMODE 0x5400
+#define TOUCH_MODE_FOD_ENABLE 10
+#define TOUCH_FOD_ON 1
+#define TOUCH_FOD_OFF -1
+#define VENDOR_WAIT_AUTH 21
+#define FAST_NIT_PROP "persist.vendor.sys.fp.fast_nit"
+
+// Relative to the fake tree, the harness is built with FS_ROOT "."
+#define FOD_UI_NODE "sys/devices/platform/soc/soc:qcom,dsi-display-primary/fod_ui"
+#define TOUCH_NODE "dev/xiaomi-touch"
+#define BOOSTD_NODE "dev/socket/" BOOSTD_SOCKET
+
+#define EVENT_TIMEOUT_MS 1000
+
+extern "C" UdfpsHandlerFactory UDFPS_HANDLER_FACTORY;
+
+static int64_t nowNs() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+enum FakeSource {
+    SOURCE_NIT,
+    SOURCE_TOUCH,
+    SOURCE_BOOST,
+};
+
+struct FakeEvent {
+    FakeSource source;
+    int32_t value;
+    int64_t ns;
+};
+
+/*
+ * The panel, touch and display nodes and konaboostd the handler talks to. The wraps below
+ * reach them through a global, as ioctl() and epoll_ctl() can't carry one.
+ */
+struct Fakes {
+    std::mutex lock;
+    std::condition_variable cond;
+    std::vector<FakeEvent> events;
+
+    dev_t dev = 0;
+    ino_t touchIno = 0;
+    ino_t fodUiIno = 0;
+    // fod_ui fds the handler watches, by fd, with the eventfd standing in for them
+    std::unordered_map<int, int> fodUiWatches;
+
+    // Stands in for konaboostd, its thread runs until stopFd is signalled
+    android::base::unique_fd boostdFd;
+    android::base::unique_fd boostdStopFd;
+    std::thread boostd;
+
+    int64_t nitLatencyUs = 0;
+    int64_t touchLatencyUs = 0;
+    uint64_t nitCommands = 0;
+    uint64_t touchIoctls = 0;
+};
+
+static Fakes sFakes;
+
+static bool isFakeNode(int fd, ino_t ino) {
+    struct stat st;
+
+    return ino != 0 && fstat(fd, &st) == 0 && st.st_dev == sFakes.dev && st.st_ino == ino;
+}
+
+static void recordEvent(FakeSource source, int32_t value) {
+    std::lock_guard<std::mutex> lock(sFakes.lock);
+
+    sFakes.events.push_back({source, value, nowNs()});
+    sFakes.cond.notify_all();
+}
+
+// First @source event with @value at or after @sinceNs, false on timeout
+static bool waitForEvent(FakeSource source, int32_t value, int64_t sinceNs, int64_t* ns) {
+    std::unique_lock<std::mutex> lock(sFakes.lock);
+
+    return sFakes.cond.wait_for(lock, std::chrono::milliseconds(EVENT_TIMEOUT_MS), [&] {
+        for (const auto& event : sFakes.events) {
+            if (event.source == source && event.value == value && event.ns >= sinceNs) {
+                *ns = event.ns;
+                return true;
+            }
+        }
+        return false;
+    });
+}
+
+static bool waitForFodUiWatch() {
+    std::unique_lock<std::mutex> lock(sFakes.lock);
+
+    return sFakes.cond.wait_for(lock, std::chrono::milliseconds(EVENT_TIMEOUT_MS),
+                                [] { return !sFakes.fodUiWatches.empty(); });
+}
+
+static int fakeExtCmd(fingerprint_device_t*, int32_t cmd, int32_t param) {
+    if (sFakes.nitLatencyUs > 0) {
+        usleep(sFakes.nitLatencyUs);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sFakes.lock);
+        sFakes.nitCommands++;
+    }
+    if (cmd == COMMAND_NIT) {
+        recordEvent(SOURCE_NIT, param);
+    }
+
+    return 0;
+}
+
+// Writes fod_ui the way the display driver does, then does its sysfs_notify()
+static void setFodUi(const char* value) {
+    uint64_t one = 1;
+
+    if (!android::base::WriteStringToFile(value, FOD_UI_NODE)) {
+        PLOG(ERROR) << "failed to write " << FOD_UI_NODE;
+    }
+
+    std::lock_guard<std::mutex> lock(sFakes.lock);
+    for (const auto& watch : sFakes.fodUiWatches) {
+        if (TEMP_FAILURE_RETRY(write(watch.second, &one, sizeof(one))) != sizeof(one)) {
+            PLOG(ERROR) << "failed to notify fod_ui";
+        }
+    }
+}
+
+// Records every request a client of the fake konaboostd sends
+static void runFakeBoostd() {
+    std::vector<struct pollfd> fds = {{sFakes.boostdStopFd.get(), POLLIN, 0},
+                                      {sFakes.boostdFd.get(), POLLIN, 0}};
+
+    while (TEMP_FAILURE_RETRY(poll(fds.data(), fds.size(), -1)) > 0) {
+        if (fds[0].revents) {
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            int fd = TEMP_FAILURE_RETRY(accept4(sFakes.boostdFd.get(), nullptr, nullptr,
+                                                SOCK_CLOEXEC));
+            if (fd >= 0) {
+                fds.push_back({fd, POLLIN, 0});
+            }
+        }
+
+        for (size_t i = 2; i < fds.size(); i++) {
+            uint8_t request;
+
+            if (!fds[i].revents) {
+                continue;
+            }
+            if (TEMP_FAILURE_RETRY(recv(fds[i].fd, &request, sizeof(request), 0)) > 0) {
+                recordEvent(SOURCE_BOOST, request);
+            } else {
+                close(fds[i].fd);
+                fds.erase(fds.begin() + i--);
+            }
+        }
+    }
+
+    for (size_t i = 2; i < fds.size(); i++) {
+        close(fds[i].fd);
+    }
+}
+
+static bool startFakeBoostd() {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+
+    strncpy(addr.sun_path, BOOSTD_NODE, sizeof(addr.sun_path) - 1);
+    sFakes.boostdFd.reset(socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0));
+    sFakes.boostdStopFd.reset(eventfd(0, EFD_CLOEXEC));
+    if (sFakes.boostdFd.get() < 0 || sFakes.boostdStopFd.get() < 0 ||
+        bind(sFakes.boostdFd.get(), reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) <
+                0 ||
+        listen(sFakes.boostdFd.get(), 4) < 0) {
+        return false;
+    }
+
+    sFakes.boostd = std::thread(runFakeBoostd);
+    return true;
+}
+
+static void stopFakeBoostd() {
+    uint64_t one = 1;
+
+    if (!sFakes.boostd.joinable()) {
+        return;
+    }
+    if (TEMP_FAILURE_RETRY(write(sFakes.boostdStopFd.get(), &one, sizeof(one))) != sizeof(one)) {
+        PLOG(ERROR) << "failed to stop the fake konaboostd";
+        sFakes.boostd.detach();
+        return;
+    }
+    sFakes.boostd.join();
+}
+
+extern "C" int __real_ioctl(int fd, unsigned long request, ...);
+extern "C" int __real_epoll_ctl(int epfd, int op, int fd, struct epoll_event* event);
+
+// The touch driver answers TOUCH_IOC_SETMODE after the configured latency
+extern "C" int __wrap_ioctl(int fd, unsigned long request, ...) {
+    va_list ap;
+    void* arg;
+
+    va_start(ap, request);
+    arg = va_arg(ap, void*);
+    va_end(ap);
+
+    if (request != TOUCH_IOC_SETMODE || !isFakeNode(fd, sFakes.touchIno)) {
+        return __real_ioctl(fd, request, arg);
+    }
+
+    int* modes = static_cast<int*>(arg);
+    if (sFakes.touchLatencyUs > 0) {
+        usleep(sFakes.touchLatencyUs);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sFakes.lock);
+        sFakes.touchIoctls++;
+    }
+    if (modes[0] == TOUCH_MODE_FOD_ENABLE) {
+        recordEvent(SOURCE_TOUCH, modes[1]);
+    }
+
+    return 0;
+}
+
+/*
+ * A regular file never reports EPOLLPRI, so the fake fod_ui is watched through
+ * an eventfd that setFodUi() signals. Edge triggered, as the handler only
+ * reads the node itself.
+ */
+extern "C" int __wrap_epoll_ctl(int epfd, int op, int fd, struct epoll_event* event) {
+    if (op == EPOLL_CTL_MOD || !isFakeNode(fd, sFakes.fodUiIno)) {
+        return __real_epoll_ctl(epfd, op, fd, event);
+    }
+
+    std::lock_guard<std::mutex> lock(sFakes.lock);
+    if (op == EPOLL_CTL_DEL) {
+        auto it = sFakes.fodUiWatches.find(fd);
+        if (it == sFakes.fodUiWatches.end()) {
+            errno = ENOENT;
+            return -1;
+        }
+        __real_epoll_ctl(epfd, EPOLL_CTL_DEL, it->second, nullptr);
+        close(it->second);
+        sFakes.fodUiWatches.erase(it);
+        return 0;
+    }
+
+    int notifyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event ev = {
+            .events = EPOLLIN | EPOLLET,
+            .data = event->data,
+    };
+    if (notifyFd < 0 || __real_epoll_ctl(epfd, EPOLL_CTL_ADD, notifyFd, &ev) < 0) {
+        int err = errno;
+        if (notifyFd >= 0) {
+            close(notifyFd);
+        }
+        errno = err;
+        return -1;
+    }
+
+    sFakes.fodUiWatches[fd] = notifyFd;
+    sFakes.cond.notify_all();
+    return 0;
+}
+
+static bool makeDirs(const std::string& path) {
+    for (size_t pos = path.find('/'); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+        if (mkdir(path.substr(0, pos).c_str(), 0755) < 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+static bool makeNode(const std::string& path, const std::string& value) {
+    size_t slash = path.rfind('/');
+
+    return (slash == std::string::npos || makeDirs(path.substr(0, slash))) &&
+           android::base::WriteStringToFile(value, path);
+}
+
+static bool createTree() {
+    struct stat st;
+    std::string boostd = BOOSTD_NODE;
+
+    if (!makeNode(FOD_UI_NODE, "0") || !makeNode(TOUCH_NODE, "") ||
+        !makeDirs(boostd.substr(0, boostd.rfind('/')))) {
+        return false;
+    }
+
+    if (stat(TOUCH_NODE, &st) < 0) {
+        return false;
+    }
+    sFakes.dev = st.st_dev;
+    sFakes.touchIno = st.st_ino;
+
+    if (stat(FOD_UI_NODE, &st) < 0) {
+        return false;
+    }
+    sFakes.fodUiIno = st.st_ino;
+    return true;
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return remove(path);
+}
+
+// Exact latencies of one stage, in ns
+struct Stage {
+    const char* name;
+    std::vector<int64_t> ns;
+};
+
+enum StageId {
+    STAGE_AUTH_WAIT_CALL,
+    STAGE_TOUCH_FOD_ON,
+    STAGE_FINGER_DOWN_CALL,
+    STAGE_DOWN_TO_NIT,
+    STAGE_FOD_UI_TO_NIT,
+    STAGE_ACQUIRED_GOOD_CALL,
+    STAGE_TOUCH_FOD_OFF,
+    STAGE_FINGER_UP_CALL,
+    STAGE_FOD_UI_OFF_TO_NIT,
+    STAGE_IDS,
+};
+
+static Stage sStages[STAGE_IDS] = {
+        {"auth_wait_call", {}},   {"touch_fod_on", {}},       {"finger_down_call", {}},
+        {"down_to_nit", {}},      {"fod_ui_to_nit", {}},      {"acquired_good_call", {}},
+        {"touch_fod_off", {}},    {"finger_up_call", {}},     {"fod_ui_off_to_nit", {}},
+};
+
+static int64_t percentileNs(const std::vector<int64_t>& sorted, int percent) {
+    return sorted[std::min(sorted.size() - 1, (sorted.size() * percent + 99) / 100 - 1)];
+}
+
+static void report() {
+    printf("%-20s %6s %9s %9s %9s\n", "stage", "count", "p50(us)", "p99(us)", "max(us)");
+    for (auto& stage : sStages) {
+        if (stage.ns.empty()) {
+            printf("%-20s %6d\n", stage.name, 0);
+            continue;
+        }
+
+        std::sort(stage.ns.begin(), stage.ns.end());
+        printf("%-20s %6zu %9.1f %9.1f %9.1f\n", stage.name, stage.ns.size(),
+               percentileNs(stage.ns, 50) / 1000.0, percentileNs(stage.ns, 99) / 1000.0,
+               stage.ns.back() / 1000.0);
+    }
+}
+
+// Time @call and record it as @id
+template <typename Call>
+static int64_t timeCall(StageId id, Call call) {
+    int64_t startNs = nowNs();
+
+    call();
+    sStages[id].ns.push_back(nowNs() - startNs);
+    return startNs;
+}
+
+// Record the time from @sinceNs to the first matching event as @id
+static bool timeEvent(StageId id, FakeSource source, int32_t value, int64_t sinceNs) {
+    int64_t ns;
+
+    if (!waitForEvent(source, value, sinceNs, &ns)) {
+        return false;
+    }
+
+    sStages[id].ns.push_back(ns - sinceNs);
+    return true;
+}
+
+/*
+ * One unlock the way the fingerprint HAL and the display drive it: the
+ * sensor starts waiting for a finger, the finger lands, the display shows
+ * the pressed icon, the matcher succeeds and the finger lifts.
+ */
+static uint64_t runUnlock(UdfpsHandler* handler, bool fastNit, int fodUiDelayMs, int matchMs) {
+    uint64_t failures = 0;
+    int64_t startNs;
+    int64_t ns;
+
+    startNs = timeCall(STAGE_AUTH_WAIT_CALL, [&] {
+        handler->onAcquired(FINGERPRINT_ACQUIRED_VENDOR, VENDOR_WAIT_AUTH);
+    });
+    // Skipped by the touch layer while FOD is still enabled from the last unlock
+    timeEvent(STAGE_TOUCH_FOD_ON, SOURCE_TOUCH, TOUCH_FOD_ON, startNs);
+
+    startNs = timeCall(STAGE_FINGER_DOWN_CALL, [&] { handler->onFingerDown(540, 1900, 5, 5); });
+    if (!waitForEvent(SOURCE_BOOST, BOOST_REQUEST_AUTH_ACQUIRE, startNs, &ns)) {
+        LOG(ERROR) << "finger down didn't boost";
+        failures++;
+    }
+    if (fastNit && !timeEvent(STAGE_DOWN_TO_NIT, SOURCE_NIT, PARAM_NIT_FOD, startNs)) {
+        LOG(ERROR) << "no fast NIT switch on finger down";
+        failures++;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(fodUiDelayMs));
+    int64_t fodUiNs = nowNs();
+    setFodUi("1");
+    if (!fastNit) {
+        if (!timeEvent(STAGE_FOD_UI_TO_NIT, SOURCE_NIT, PARAM_NIT_FOD, fodUiNs)) {
+            LOG(ERROR) << "fod_ui didn't switch NIT mode";
+            failures++;
+        } else {
+            sStages[STAGE_DOWN_TO_NIT].ns.push_back(sStages[STAGE_FOD_UI_TO_NIT].ns.back() +
+                                                    fodUiNs - startNs);
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(matchMs));
+    startNs = timeCall(STAGE_ACQUIRED_GOOD_CALL,
+                       [&] { handler->onAcquired(FINGERPRINT_ACQUIRED_GOOD, 0); });
+    if (!timeEvent(STAGE_TOUCH_FOD_OFF, SOURCE_TOUCH, TOUCH_FOD_OFF, startNs)) {
+        LOG(ERROR) << "touch FOD wasn't disabled";
+        failures++;
+    }
+    if (!waitForEvent(SOURCE_BOOST, BOOST_REQUEST_AUTH_RELEASE, startNs, &ns)) {
+        LOG(ERROR) << "boost wasn't released";
+        failures++;
+    }
+
+    timeCall(STAGE_FINGER_UP_CALL, [&] { handler->onFingerUp(); });
+    fodUiNs = nowNs();
+    setFodUi("0");
+    if (!timeEvent(STAGE_FOD_UI_OFF_TO_NIT, SOURCE_NIT, PARAM_NIT_NONE, fodUiNs)) {
+        LOG(ERROR) << "fod_ui off didn't leave NIT mode";
+        failures++;
+    }
+
+    return failures;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [-n unlocks] [-f] [-u fod_ui_ms] [-m match_ms] [-c nit_us] [-t touch_us] "
+            "[-k]\n"
+            "  -n  unlocks to run (default 200)\n"
+            "  -f  enable the fast NIT path\n"
+            "  -u  delay from finger down to fod_ui (default 20)\n"
+            "  -m  matcher time from fod_ui to a good acquisition (default 10)\n"
+            "  -c  latency of the panel NIT command in us (default 1000)\n"
+            "  -t  latency of the touch ioctl in us (default 200)\n"
+            "  -k  keep the fake tree\n",
+            prog);
+}
+
+/*
+ * Runs libudfpshandler on the host against a fake fingerprint device, a fake
+ * fod_ui, a fake konaboostd and a fake touch node, and reports the latency of
+ * every stage of an unlock. The handler's own summary is logged on exit.
+ */
+int main(int argc, char** argv) {
+    char root[] = "/tmp/udfps_harness.XXXXXX";
+    fingerprint_device_t device = {};
+    uint64_t failures = 0;
+    int unlocks = 200;
+    int fodUiDelayMs = 20;
+    int matchMs = 10;
+    bool fastNit = false;
+    bool keep = false;
+    int opt;
+
+    sFakes.nitLatencyUs = 1000;
+    sFakes.touchLatencyUs = 200;
+    while ((opt = getopt(argc, argv, "n:fu:m:c:t:k")) != -1) {
+        switch (opt) {
+            case 'n':
+                unlocks = atoi(optarg);
+                break;
+            case 'f':
+                fastNit = true;
+                break;
+            case 'u':
+                fodUiDelayMs = atoi(optarg);
+                break;
+            case 'm':
+                matchMs = atoi(optarg);
+                break;
+            case 'c':
+                sFakes.nitLatencyUs = atoll(optarg);
+                break;
+            case 't':
+                sFakes.touchLatencyUs = atoll(optarg);
+                break;
+            case 'k':
+                keep = true;
+                break;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind != argc || unlocks <= 0 || fodUiDelayMs < 0 || matchMs < 0 ||
+        sFakes.nitLatencyUs < 0 || sFakes.touchLatencyUs < 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (mkdtemp(root) == nullptr || chdir(root) < 0 || !createTree() || !startFakeBoostd()) {
+        PLOG(ERROR) << "failed to create the fake tree";
+        return EXIT_FAILURE;
+    }
+
+    android::base::SetProperty(FAST_NIT_PROP, fastNit ? "1" : "0");
+    device.extCmd = fakeExtCmd;
+
+    UdfpsHandler* handler = UDFPS_HANDLER_FACTORY.create();
+    handler->init(&device);
+    if (!waitForFodUiWatch()) {
+        LOG(ERROR) << "the handler never watched fod_ui";
+        failures++;
+    } else {
+        for (int i = 0; i < unlocks; i++) {
+            failures += runUnlock(handler, fastNit, fodUiDelayMs, matchMs);
+        }
+    }
+
+    printf("%d unlocks in %s, fast NIT %s, %" PRIu64 " NIT commands, %" PRIu64
+           " touch ioctls, %" PRIu64 " failures\n",
+           unlocks, root, fastNit ? "on" : "off", sFakes.nitCommands, sFakes.touchIoctls,
+           failures);
+    report();
+    fflush(stdout);
+
+    UDFPS_HANDLER_FACTORY.destroy(handler);
+    stopFakeBoostd();
+
+    if (!keep && nftw(root, removeEntry, 16, FTW_DEPTH | FTW_PHYS) < 0) {
+        PLOG(ERROR) << "failed to remove " << root;
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "vendor.qti.vibrator"
+
+#include <inttypes.h>
+#include <log/log.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include "include/CompletionDispatcher.h"
+#include "include/Utils.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+/* Completions delivered later than this past their deadline count as late */
+#define LATE_THRESHOLD_US       2000
+
+CompletionDispatcher::CompletionDispatcher()
+    : mStopping(false),
+      mHasPending(false),
+      mScheduled(0),
+      mFired(0),
+      mSuperseded(0),
+      mLate(0),
+      mMaxLatenessUs(0) {
+    struct epoll_event ev;
+
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    mTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    mEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mEpollFd < 0 || mTimerFd < 0 || mEventFd < 0) {
+        ALOGE("failed to create completion dispatcher fds, errno = %d", -errno);
+        return;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = mTimerFd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mTimerFd, &ev);
+    ev.data.fd = mEventFd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mEventFd, &ev);
+
+    mThread = std::thread(&CompletionDispatcher::threadLoop, this);
+}
+
+CompletionDispatcher::~CompletionDispatcher() {
+    if (mThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mStopping = true;
+        }
+        wake();
+        mThread.join();
+    }
+
+    if (mEpollFd >= 0)
+        close(mEpollFd);
+    if (mTimerFd >= 0)
+        close(mTimerFd);
+    if (mEventFd >= 0)
+        close(mEventFd);
+}
+
+void CompletionDispatcher::wake() {
+    uint64_t one = 1;
+
+    if (TEMP_FAILURE_RETRY(write(mEventFd, &one, sizeof(one))) == -1)
+        ALOGE("failed to wake completion dispatcher, errno = %d", -errno);
+}
+
+void CompletionDispatcher::armTimerLocked(int64_t deadlineNs) {
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = deadlineNs / 1000000000LL;
+    its.it_value.tv_nsec = deadlineNs % 1000000000LL;
+    if (timerfd_settime(mTimerFd, TFD_TIMER_ABSTIME, &its, NULL) == -1)
+        ALOGE("timerfd_settime failed, errno = %d", -errno);
+}
+
+/* Complete the pending callback early because a newer request replaced it */
+void CompletionDispatcher::supersedeLocked() {
+    if (!mHasPending)
+        return;
+
+    mReady.push_back(std::move(mPending.callback));
+    mHasPending = false;
+    mSuperseded++;
+    /* A zero expiry disarms the timer */
+    armTimerLocked(0);
+}
+
+void CompletionDispatcher::schedule(const std::shared_ptr<IVibratorCallback>& callback,
+                                    long delayMs) {
+    bool notify;
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        supersedeLocked();
+        notify = !mReady.empty();
+
+        if (callback != nullptr) {
+            mPending.callback = callback;
+            mPending.deadlineNs = nowNs() + delayMs * 1000000LL;
+            mHasPending = true;
+            mScheduled++;
+            armTimerLocked(mPending.deadlineNs);
+        }
+    }
+
+    if (notify)
+        wake();
+}
+
+void CompletionDispatcher::cancel() {
+    bool notify;
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        supersedeLocked();
+        notify = !mReady.empty();
+    }
+
+    if (notify)
+        wake();
+}
+
+CompletionDispatcher::Stats CompletionDispatcher::getStats() const {
+    Stats stats;
+
+    stats.scheduled = mScheduled.load(std::memory_order_relaxed);
+    stats.fired = mFired.load(std::memory_order_relaxed);
+    stats.superseded = mSuperseded.load(std::memory_order_relaxed);
+    stats.late = mLate.load(std::memory_order_relaxed);
+    stats.maxLatenessUs = mMaxLatenessUs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void CompletionDispatcher::dump(int fd) const {
+    Stats stats = getStats();
+
+    dprintf(fd, "Completions:\n");
+    dprintf(fd, "  scheduled=%" PRIu64 " fired=%" PRIu64 " superseded=%" PRIu64 " late=%" PRIu64
+            " max lateness=%" PRIu64 "us\n", stats.scheduled, stats.fired, stats.superseded,
+            stats.late, stats.maxLatenessUs);
+    mLateness.dump(fd, "lateness");
+}
+
+void CompletionDispatcher::threadLoop() {
+    struct epoll_event events[2];
+    std::vector<std::shared_ptr<IVibratorCallback>> ready;
+    uint64_t counter;
+
+    while (true) {
+        int n = TEMP_FAILURE_RETRY(epoll_wait(mEpollFd, events, 2, -1));
+        if (n < 0) {
+            ALOGE("epoll_wait failed, errno = %d", -errno);
+            usleep(1000);
+            continue;
+        }
+
+        for (int i = 0; i < n; i++) {
+            /* Both fds are non-blocking counters, drain them */
+            if (read(events[i].data.fd, &counter, sizeof(counter)) < 0 && errno != EAGAIN)
+                ALOGE("failed to read dispatcher fd, errno = %d", -errno);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            if (mStopping)
+                break;
+            if (mHasPending) {
+                int64_t now = nowNs();
+                if (now >= mPending.deadlineNs) {
+                    uint64_t latenessUs = (now - mPending.deadlineNs) / 1000;
+                    mLateness.record(now - mPending.deadlineNs);
+                    if (latenessUs > LATE_THRESHOLD_US)
+                        mLate++;
+                    if (latenessUs > mMaxLatenessUs.load(std::memory_order_relaxed))
+                        mMaxLatenessUs.store(latenessUs, std::memory_order_relaxed);
+                    mReady.push_back(std::move(mPending.callback));
+                    mHasPending = false;
+                } else {
+                    armTimerLocked(mPending.deadlineNs);
+                }
+            }
+            ready.swap(mReady);
+        }
+
+        for (auto& callback : ready) {
+            mFired++;
+            if (!callback->onComplete().isOk())
+                ALOGE("Failed to call onComplete");
+        }
+        ready.clear();
+    }
+}
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "vendor.qti.vibrator"
+
+#include <chrono>
+#include <log/log.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/prctl.h>
+
+#include "include/CompositionPlayer.h"
+#include "include/DeviceWorker.h"
+#include "include/Vibrator.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+#define COMPOSE_THREAD_PRIORITY 2
+
+CompositionPlayer::CompositionPlayer(DeviceWorker& worker)
+    : mWorker(worker),
+      mGainDirty(false),
+      mActive(false),
+      mPending(false),
+      mStopping(false),
+      mGeneration(0) {
+    mThread = std::thread(&CompositionPlayer::threadLoop, this);
+}
+
+CompositionPlayer::~CompositionPlayer() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mStopping = true;
+        mGeneration++;
+    }
+    mCond.notify_all();
+    mThread.join();
+}
+
+void CompositionPlayer::play(std::vector<Step> timeline) {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mTimeline = std::move(timeline);
+        mPending = true;
+        mActive = true;
+        mGeneration++;
+    }
+    mCond.notify_all();
+}
+
+/* Abort the running composition, this is a no-op when nothing is playing */
+void CompositionPlayer::stop() {
+    if (mActive) {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mPending = false;
+            mGeneration++;
+        }
+        mCond.notify_all();
+    }
+
+    if (mGainDirty) {
+        mWorker.run([this](InputFFDevice& ff) {
+            if (mGainDirty.exchange(false))
+                ff.restoreGain();
+            return 0;
+        });
+    }
+}
+
+void CompositionPlayer::threadLoop() {
+    struct sched_param param = {.sched_priority = COMPOSE_THREAD_PRIORITY};
+    std::unique_lock<std::mutex> lock(mLock);
+
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+        ALOGW("failed to set SCHED_FIFO for composition thread");
+    /* Keep wakeups as close to the step deadlines as the timer allows */
+    prctl(PR_SET_TIMERSLACK, 1);
+
+    while (true) {
+        mCond.wait(lock, [this] { return mStopping || mPending; });
+        if (mStopping)
+            break;
+
+        std::vector<Step> timeline = std::move(mTimeline);
+        uint64_t generation = mGeneration.load();
+        auto start = std::chrono::steady_clock::now();
+        mPending = false;
+
+        for (const auto& step : timeline) {
+            auto deadline = start + std::chrono::microseconds(step.startUs);
+            if (mCond.wait_until(lock, deadline,
+                                 [&] { return mGeneration.load() != generation; }))
+                break;
+
+            if (step.effectId < 0)
+                continue;
+
+            /* A newer request may have aborted us while the step was queued */
+            lock.unlock();
+            mWorker.run([&](InputFFDevice& ff) {
+                if (mGeneration.load() != generation)
+                    return 0;
+                if (ff.playPrimitive(step.effectId, step.strength, step.gain) != 0)
+                    ALOGE("failed to play composition step effect %d", step.effectId);
+                if (ff.mSupportGain)
+                    mGainDirty = true;
+                return 0;
+            });
+            lock.lock();
+        }
+
+        lock.unlock();
+        mWorker.run([&](InputFFDevice& ff) {
+            if (mGeneration.load() == generation && mGainDirty.exchange(false))
+                ff.restoreGain();
+            return 0;
+        });
+        lock.lock();
+
+        if (!mPending)
+            mActive = false;
+    }
+}
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "vendor.qti.vibrator"
+
+#include <log/log.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+
+#include "include/DeviceWorker.h"
+#include "include/Utils.h"
+#include "include/Vibrator.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+#define DEVICE_THREAD_PRIORITY  2
+
+static thread_local int64_t sDeviceNs;
+
+DeviceWorker::Command::Command(Type t)
+    : type(t),
+      timeoutMs(0),
+      effectId(-1),
+      strength(EffectStrength::STRONG),
+      amplitude(0),
+      playLengthMs(0),
+      deviceNs(0),
+      fn(NULL),
+      result(0),
+      next(NULL),
+      done(false) {}
+
+DeviceWorker::DeviceWorker(InputFFDevice& ff)
+    : mFF(ff),
+      mHead(&mStub),
+      mTail(&mStub),
+      mStub(Command::STUB),
+      mPaused(false),
+      mSleeping(false),
+      mStopping(false),
+      mExecuted(0),
+      mCoalesced(0) {
+    mEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mEventFd < 0)
+        ALOGE("failed to create device worker eventfd, errno = %d", -errno);
+
+    mThread = std::thread(&DeviceWorker::threadLoop, this);
+}
+
+DeviceWorker::~DeviceWorker() {
+    uint64_t one = 1;
+
+    mStopping = true;
+    if (TEMP_FAILURE_RETRY(write(mEventFd, &one, sizeof(one))) == -1)
+        ALOGE("failed to stop device worker, errno = %d", -errno);
+    mThread.join();
+
+    if (mEventFd >= 0)
+        close(mEventFd);
+}
+
+void DeviceWorker::push(Command *cmd) {
+    Command *prev;
+
+    cmd->next.store(NULL, std::memory_order_relaxed);
+    /* seq_cst, it pairs with the mSleeping handshake in submit() and threadLoop() */
+    prev = mHead.exchange(cmd, std::memory_order_seq_cst);
+    prev->next.store(cmd, std::memory_order_release);
+}
+
+/* Only called from the owner thread */
+DeviceWorker::Command *DeviceWorker::pop() {
+    Command *tail = mTail;
+    Command *next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &mStub) {
+        if (next == NULL)
+            return NULL;
+        mTail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next != NULL) {
+        mTail = next;
+        return tail;
+    }
+
+    /* A producer is between the exchange and the link, pick it up next round */
+    if (tail != mHead.load(std::memory_order_acquire))
+        return NULL;
+
+    push(&mStub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != NULL) {
+        mTail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+bool DeviceWorker::empty() const {
+    return mTail == &mStub && mStub.next.load(std::memory_order_seq_cst) == NULL &&
+           mHead.load(std::memory_order_seq_cst) == &mStub;
+}
+
+int DeviceWorker::submit(Command *cmd) {
+    uint64_t one = 1;
+
+    /*
+     * Store-load handshake with threadLoop(): the submitter publishes the
+     * command and then reads mSleeping, the owner publishes mSleeping and then
+     * reads the queue.
+     * Only seq_cst keeps both sides from reordering the load before the store,
+     * which would let the owner sleep on a queued command.
+     */
+    push(cmd);
+    if (mSleeping.exchange(false, std::memory_order_seq_cst) &&
+            TEMP_FAILURE_RETRY(write(mEventFd, &one, sizeof(one))) == -1)
+        ALOGE("failed to wake device worker, errno = %d", -errno);
+
+    std::unique_lock<std::mutex> lock(cmd->lock);
+    cmd->cond.wait(lock, [cmd] { return cmd->done; });
+    sDeviceNs += cmd->deviceNs;
+    return cmd->result;
+}
+
+int64_t DeviceWorker::takeDeviceNs() {
+    int64_t ns = sDeviceNs;
+
+    sDeviceNs = 0;
+    return ns;
+}
+
+/* Notify under the lock, the submitter frees the command as soon as it sees done */
+void DeviceWorker::complete(Command *cmd, int result) {
+    std::lock_guard<std::mutex> lock(cmd->lock);
+
+    cmd->result = result;
+    cmd->done = true;
+    cmd->cond.notify_one();
+}
+
+int DeviceWorker::on(int32_t timeoutMs) {
+    Command cmd(Command::ON);
+
+    cmd.timeoutMs = timeoutMs;
+    return submit(&cmd);
+}
+
+int DeviceWorker::off() {
+    Command cmd(Command::OFF);
+
+    return submit(&cmd);
+}
+
+int DeviceWorker::playEffect(int effectId, EffectStrength es, long *playLengthMs) {
+    Command cmd(Command::PERFORM);
+    int ret;
+
+    cmd.effectId = effectId;
+    cmd.strength = es;
+    ret = submit(&cmd);
+    if (playLengthMs != NULL)
+        *playLengthMs = cmd.playLengthMs;
+
+    return ret;
+}
+
+int DeviceWorker::setAmplitude(uint8_t amplitude) {
+    Command cmd(Command::SET_AMPLITUDE);
+
+    cmd.amplitude = amplitude;
+    return submit(&cmd);
+}
+
+int DeviceWorker::run(const Function& fn) {
+    Command cmd(Command::CALL);
+
+    cmd.fn = &fn;
+    return submit(&cmd);
+}
+
+/** Hand the device over to the calling thread
+ *
+ *  Returns once the owner thread has drained the commands queued before and
+ *  parked itself. Until resume(), the caller may access the InputFFDevice
+ *  directly, e.g. to write to several devices from a single thread.
+ */
+void DeviceWorker::pause() {
+    Command cmd(Command::PAUSE);
+
+    {
+        std::lock_guard<std::mutex> lock(mPauseLock);
+        mPaused = true;
+    }
+    submit(&cmd);
+}
+
+void DeviceWorker::resume() {
+    {
+        std::lock_guard<std::mutex> lock(mPauseLock);
+        mPaused = false;
+    }
+    mPauseCond.notify_one();
+}
+
+void DeviceWorker::execute(Command *cmd) {
+    int64_t startNs = mFF.getSyscallNs();
+    int ret = 0;
+
+    switch (cmd->type) {
+    case Command::ON:
+        ret = mFF.on(cmd->timeoutMs);
+        break;
+    case Command::OFF:
+        ret = mFF.off();
+        break;
+    case Command::PERFORM:
+        ret = mFF.playEffect(cmd->effectId, cmd->strength, &cmd->playLengthMs);
+        break;
+    case Command::SET_AMPLITUDE:
+        ret = mFF.setAmplitude(cmd->amplitude);
+        break;
+    case Command::CALL:
+        ret = (*cmd->fn)(mFF);
+        break;
+    case Command::PAUSE: {
+        std::unique_lock<std::mutex> lock(mPauseLock);
+
+        complete(cmd, 0);
+        mPauseCond.wait(lock, [this] { return !mPaused; });
+        return;
+    }
+    default:
+        break;
+    }
+
+    mExecuted++;
+    cmd->deviceNs = mFF.getSyscallNs() - startNs;
+    complete(cmd, ret);
+}
+
+/** Execute a batch of drained commands in submission order
+ *
+ *  Within a run of consecutive setAmplitude() commands only the last one is
+ *  applied, as the magnitude it sets overrides the earlier ones. The same goes
+ *  for a run of on()/off() commands, where the last one decides the state of
+ *  the actuator. Superseded commands complete successfully without any I/O.
+ */
+void DeviceWorker::processBatch(std::vector<Command*>& batch) {
+    auto isOnOff = [](Command::Type type) {
+        return type == Command::ON || type == Command::OFF;
+    };
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        Command *cmd = batch[i];
+        Command *next = i + 1 < batch.size() ? batch[i + 1] : NULL;
+
+        if (next != NULL &&
+                ((cmd->type == Command::SET_AMPLITUDE && next->type == Command::SET_AMPLITUDE) ||
+                 (isOnOff(cmd->type) && isOnOff(next->type)))) {
+            mCoalesced++;
+            complete(cmd, 0);
+            continue;
+        }
+
+        execute(cmd);
+    }
+
+    batch.clear();
+}
+
+void DeviceWorker::threadLoop() {
+    struct sched_param param = {.sched_priority = DEVICE_THREAD_PRIORITY};
+    struct pollfd pfd = {.fd = mEventFd, .events = POLLIN, .revents = 0};
+    std::vector<Command*> batch;
+    uint64_t counter;
+    Command *cmd;
+
+    /* Composition steps go through this thread, keep its wakeup latency low */
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+        ALOGW("failed to set SCHED_FIFO for device worker");
+
+    while (!mStopping) {
+        while ((cmd = pop()) != NULL)
+            batch.push_back(cmd);
+
+        if (!batch.empty()) {
+            processBatch(batch);
+            continue;
+        }
+
+        /* Rate limited gain updates are flushed once their interval is over */
+        int64_t deadlineNs = mFF.gainDeadlineNs();
+        int64_t waitNs = -1;
+        if (deadlineNs >= 0) {
+            waitNs = deadlineNs - nowNs();
+            if (waitNs <= 0) {
+                mFF.flushPendingGain();
+                continue;
+            }
+        }
+
+        mSleeping.store(true, std::memory_order_seq_cst);
+        if (!empty()) {
+            mSleeping.store(false, std::memory_order_release);
+            continue;
+        }
+
+        struct timespec timeout = {
+            .tv_sec = (time_t)(waitNs / 1000000000LL),
+            .tv_nsec = (long)(waitNs % 1000000000LL),
+        };
+        if (TEMP_FAILURE_RETRY(ppoll(&pfd, 1, waitNs < 0 ? NULL : &timeout, NULL)) < 0)
+            ALOGE("failed to poll device worker eventfd, errno = %d", -errno);
+        mSleeping.store(false, std::memory_order_release);
+        if (read(mEventFd, &counter, sizeof(counter)) < 0 && errno != EAGAIN)
+            ALOGE("failed to read device worker eventfd, errno = %d", -errno);
+    }
+}
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "vendor.qti.vibrator.fake"
+
+#include <chrono>
+#include <dirent.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+#include <log/log.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "include/FakeFFDevice.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+#define UINPUT_PATH             "/dev/uinput"
+#define INPUT_SYSFS_DIR         "/sys/class/input/"
+#define INPUT_DEV_DIR           "/dev/input/"
+#define NODE_WAIT_MS            2000
+#define CUSTOM_DATA_LEN         3
+
+/* Event nodes of the fake devices and the play length they report */
+static std::mutex sRegistryLock;
+static std::vector<std::pair<dev_t, int32_t>> sRegistry;
+
+/* Play length to report for an upload on @fd, or -1 if it isn't a fake device */
+static int32_t fakePlayLengthMs(int fd) {
+    std::lock_guard<std::mutex> lock(sRegistryLock);
+    struct stat st;
+
+    if (sRegistry.empty() || fstat(fd, &st) != 0 || !S_ISCHR(st.st_mode))
+        return -1;
+
+    for (const auto& entry : sRegistry) {
+        if (entry.first == st.st_rdev)
+            return entry.second;
+    }
+
+    return -1;
+}
+
+FakeFFDevice::Config FakeFFDevice::defaultConfig() {
+    return {
+        .name = "qti-haptics",
+        .slots = 16,
+        .ioctlLatencyUs = 0,
+        .playLengthMs = 30,
+        .gain = true,
+    };
+}
+
+FakeFFDevice::FakeFFDevice(const Config& config)
+    : mConfig(config), mFd(-1), mEventFd(-1) {
+    struct stat st;
+
+    memset(&mStats, 0, sizeof(mStats));
+    if (!create())
+        return;
+
+    mEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mEventFd < 0) {
+        ALOGE("failed to create fake device eventfd, errno = %d", -errno);
+        mDevicePath.clear();
+        return;
+    }
+
+    if (stat(mDevicePath.c_str(), &st) == 0) {
+        std::lock_guard<std::mutex> lock(sRegistryLock);
+        sRegistry.push_back({st.st_rdev, mConfig.playLengthMs});
+    }
+
+    mThread = std::thread(&FakeFFDevice::threadLoop, this);
+}
+
+FakeFFDevice::~FakeFFDevice() {
+    uint64_t one = 1;
+    struct stat st;
+
+    if (!mDevicePath.empty() && stat(mDevicePath.c_str(), &st) == 0) {
+        std::lock_guard<std::mutex> lock(sRegistryLock);
+        for (auto it = sRegistry.begin(); it != sRegistry.end(); it++) {
+            if (it->first == st.st_rdev) {
+                sRegistry.erase(it);
+                break;
+            }
+        }
+    }
+
+    if (mThread.joinable()) {
+        if (TEMP_FAILURE_RETRY(write(mEventFd, &one, sizeof(one))) == -1)
+            ALOGE("failed to stop fake device thread, errno = %d", -errno);
+        mThread.join();
+    }
+
+    if (mFd >= 0) {
+        ioctl(mFd, UI_DEV_DESTROY);
+        close(mFd);
+    }
+    if (mEventFd >= 0)
+        close(mEventFd);
+}
+
+bool FakeFFDevice::create() {
+    const int ffBits[] = {FF_CONSTANT, FF_PERIODIC, FF_CUSTOM, FF_SINE};
+    struct uinput_setup setup;
+
+    mFd = TEMP_FAILURE_RETRY(open(UINPUT_PATH, O_RDWR | O_NONBLOCK | O_CLOEXEC));
+    if (mFd < 0) {
+        ALOGE("open %s failed, errno = %d", UINPUT_PATH, errno);
+        return false;
+    }
+
+    if (ioctl(mFd, UI_SET_EVBIT, EV_FF) != 0)
+        goto errout;
+    for (auto bit : ffBits) {
+        if (ioctl(mFd, UI_SET_FFBIT, bit) != 0)
+            goto errout;
+    }
+    if (mConfig.gain && ioctl(mFd, UI_SET_FFBIT, FF_GAIN) != 0)
+        goto errout;
+
+    memset(&setup, 0, sizeof(setup));
+    setup.id.bustype = BUS_VIRTUAL;
+    strncpy(setup.name, mConfig.name.c_str(), sizeof(setup.name) - 1);
+    setup.ff_effects_max = mConfig.slots;
+    if (ioctl(mFd, UI_DEV_SETUP, &setup) != 0 || ioctl(mFd, UI_DEV_CREATE) != 0)
+        goto errout;
+
+    mDevicePath = findEventNode();
+    if (mDevicePath.empty()) {
+        ALOGE("no event node for fake device %s", mConfig.name.c_str());
+        return false;
+    }
+
+    ALOGI("fake device %s at %s, %d slots, %" PRId64 "us ioctl latency",
+          mConfig.name.c_str(), mDevicePath.c_str(), mConfig.slots, mConfig.ioctlLatencyUs);
+    return true;
+
+errout:
+    ALOGE("failed to set up fake device %s, errno = %d", mConfig.name.c_str(), -errno);
+    close(mFd);
+    mFd = -1;
+    return false;
+}
+
+/* The event node shows up with the device, wait for it to become accessible */
+std::string FakeFFDevice::findEventNode() {
+    char sysname[64];
+    struct dirent *dir;
+    std::string node;
+    DIR *dp;
+
+    memset(sysname, 0, sizeof(sysname));
+    if (ioctl(mFd, UI_GET_SYSNAME(sizeof(sysname) - 1), sysname) < 0)
+        return "";
+
+    for (int waitedMs = 0; waitedMs < NODE_WAIT_MS; waitedMs += 10) {
+        dp = opendir((std::string(INPUT_SYSFS_DIR) + sysname).c_str());
+        if (dp != NULL) {
+            while ((dir = readdir(dp)) != NULL) {
+                if (!strncmp(dir->d_name, "event", 5)) {
+                    node = std::string(INPUT_DEV_DIR) + dir->d_name;
+                    break;
+                }
+            }
+            closedir(dp);
+        }
+
+        if (!node.empty() && access(node.c_str(), R_OK | W_OK) == 0)
+            return node;
+        usleep(10000);
+    }
+
+    return "";
+}
+
+void FakeFFDevice::answerUpload(int32_t requestId) {
+    struct uinput_ff_upload upload;
+
+    memset(&upload, 0, sizeof(upload));
+    upload.request_id = requestId;
+    if (ioctl(mFd, UI_BEGIN_FF_UPLOAD, &upload) != 0) {
+        ALOGE("UI_BEGIN_FF_UPLOAD failed, errno = %d", -errno);
+        return;
+    }
+
+    if (mConfig.ioctlLatencyUs > 0)
+        usleep(mConfig.ioctlLatencyUs);
+
+    upload.retval = 0;
+    if (ioctl(mFd, UI_END_FF_UPLOAD, &upload) != 0)
+        ALOGE("UI_END_FF_UPLOAD failed, errno = %d", -errno);
+
+    std::lock_guard<std::mutex> lock(mLock);
+    mStats.uploads++;
+}
+
+void FakeFFDevice::answerErase(int32_t requestId) {
+    struct uinput_ff_erase erase;
+
+    memset(&erase, 0, sizeof(erase));
+    erase.request_id = requestId;
+    if (ioctl(mFd, UI_BEGIN_FF_ERASE, &erase) != 0) {
+        ALOGE("UI_BEGIN_FF_ERASE failed, errno = %d", -errno);
+        return;
+    }
+
+    if (mConfig.ioctlLatencyUs > 0)
+        usleep(mConfig.ioctlLatencyUs);
+
+    erase.retval = 0;
+    if (ioctl(mFd, UI_END_FF_ERASE, &erase) != 0)
+        ALOGE("UI_END_FF_ERASE failed, errno = %d", -errno);
+
+    std::lock_guard<std::mutex> lock(mLock);
+    mStats.erases++;
+}
+
+FakeFFDevice::Stats FakeFFDevice::getStats() {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    return mStats;
+}
+
+bool FakeFFDevice::waitForPlays(uint64_t plays, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mLock);
+
+    return mCond.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                          [&] { return mStats.plays >= plays; });
+}
+
+void FakeFFDevice::threadLoop() {
+    struct pollfd fds[2] = {
+        {.fd = mFd, .events = POLLIN, .revents = 0},
+        {.fd = mEventFd, .events = POLLIN, .revents = 0},
+    };
+    struct input_event ev;
+
+    while (true) {
+        if (TEMP_FAILURE_RETRY(poll(fds, 2, -1)) < 0) {
+            ALOGE("failed to poll fake device, errno = %d", -errno);
+            return;
+        }
+
+        if (fds[1].revents)
+            return;
+
+        while (TEMP_FAILURE_RETRY(read(mFd, &ev, sizeof(ev))) == sizeof(ev)) {
+            if (ev.type == EV_UINPUT && ev.code == UI_FF_UPLOAD) {
+                answerUpload(ev.value);
+            } else if (ev.type == EV_UINPUT && ev.code == UI_FF_ERASE) {
+                answerErase(ev.value);
+            } else if (ev.type == EV_FF) {
+                std::lock_guard<std::mutex> lock(mLock);
+
+                if (ev.code == FF_GAIN) {
+                    mStats.gains++;
+                } else if (ev.value) {
+                    mStats.plays++;
+                    mStats.lastPlayNs = ev.input_event_sec * 1000000000LL +
+                                        ev.input_event_usec * 1000LL;
+                    mCond.notify_all();
+                } else {
+                    mStats.stops++;
+                }
+            }
+        }
+    }
+}
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
+
+using aidl::android::hardware::vibrator::fakePlayLengthMs;
+
+extern "C" int __real_ioctl(int fd, unsigned long request, ...);
+
+/** Emulate the custom effects of the QTI driver on a fake device
+ *
+ *  uinput refuses FF_CUSTOM uploads as it has no way to hand custom_data to
+ *  userspace. Targets built with -Wl,--wrap=ioctl get the upload turned into
+ *  a sine effect for the kernel, and the play length written back into
+ *  custom_data, the way the driver returns it. Every other ioctl is passed on.
+ */
+extern "C" int __wrap_ioctl(int fd, unsigned long request, ...) {
+    struct ff_effect *effect;
+    struct ff_effect sine;
+    int32_t playLengthMs;
+    va_list ap;
+    void *arg;
+    int ret;
+
+    va_start(ap, request);
+    arg = va_arg(ap, void *);
+    va_end(ap);
+
+    effect = static_cast<struct ff_effect *>(arg);
+    if (static_cast<unsigned int>(request) != EVIOCSFF || effect == NULL ||
+            effect->type != FF_PERIODIC || effect->u.periodic.waveform != FF_CUSTOM ||
+            (playLengthMs = fakePlayLengthMs(fd)) < 0)
+        return __real_ioctl(fd, request, arg);
+
+    sine = *effect;
+    sine.u.periodic.waveform = FF_SINE;
+    sine.u.periodic.custom_len = 0;
+    sine.u.periodic.custom_data = NULL;
+    sine.replay.length = playLengthMs;
+
+    ret = __real_ioctl(fd, request, &sine);
+    if (ret != 0)
+        return ret;
+
+    effect->id = sine.id;
+    if (effect->u.periodic.custom_data != NULL &&
+            effect->u.periodic.custom_len >= sizeof(int16_t) * CUSTOM_DATA_LEN) {
+        effect->u.periodic.custom_data[1] = playLengthMs / 1000;
+        effect->u.periodic.custom_data[2] = playLengthMs % 1000;
+    }
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "vendor.qti.vibrator"
+
+#include <Sysfs.h>
+#include <algorithm>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <log/log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "include/HapticsBackend.h"
+#include "include/HapticsDiscovery.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+#define NAME_BUF_SIZE           32
+
+#define QCOM_HV_NAME            "qcom-hv-haptics"
+#define QCOM_HV_FIFO_RATE_HZ    8000
+
+#define AW8697_NAME             "aw8697_haptic"
+#define AW8697_WAVE_ATTR        "/custom_wave"
+#define AW8697_ACTIVATE_ATTR    "/activate"
+#define AW8697_F0_ATTR          "/f0_value"
+#define AW8697_RTP_RATE_HZ      24000
+/* sysfs hands at most a page to the driver per write */
+#define AW8697_RTP_CHUNK_SIZE   4096
+#define AW8697_DEFAULT_F0_HZ    170
+
+HapticsBackend::HapticsBackend(const char *name) : mName(name) {}
+
+/** Pick the backend for the driver behind @devicePath
+ *
+ *  The driver is identified by the input device name, only once when the node
+ *  is opened. Drivers without a backend of their own get the generic one.
+ */
+std::unique_ptr<HapticsBackend> HapticsBackend::probe(const std::string& devicePath) {
+    std::string sysfsDir = HapticsDiscovery::sysfsDir(devicePath);
+    char name[NAME_BUF_SIZE];
+
+    if (sysfsDir.empty() || HapticsDiscovery::readSysfs((sysfsDir + "/name").c_str(),
+                                                        name, sizeof(name)) <= 0)
+        name[0] = '\0';
+
+    /* The chip attributes live on the parent of the input device */
+    return create(name, sysfsDir + "/device");
+}
+
+std::unique_ptr<HapticsBackend> HapticsBackend::create(const std::string& name,
+                                                       const std::string& sysfsDir) {
+    if (name == QCOM_HV_NAME)
+        return std::make_unique<QcomHvBackend>();
+    if (name == AW8697_NAME)
+        return std::make_unique<Aw8697Backend>(sysfsDir);
+
+    return std::make_unique<HapticsBackend>("generic");
+}
+
+void HapticsBackend::dump(int fd) {
+    dprintf(fd, "  backend: %s\n", mName);
+}
+
+QcomHvBackend::QcomHvBackend() : HapticsBackend(QCOM_HV_NAME) {
+    memset(&mFifo, 0, sizeof(mFifo));
+}
+
+int32_t QcomHvBackend::customRateHz() const {
+    return QCOM_HV_FIFO_RATE_HZ;
+}
+
+/* The driver copies the samples in on upload, they needn't outlive the ioctl */
+void QcomHvBackend::customEffect(struct ff_effect *effect, const int8_t *samples,
+                                 size_t count) {
+    mFifo.idx = 0;
+    mFifo.length = count;
+    mFifo.playRateHz = QCOM_HV_FIFO_RATE_HZ;
+    mFifo.data = samples;
+
+    effect->type = FF_PERIODIC;
+    effect->u.periodic.waveform = FF_CUSTOM;
+    effect->u.periodic.custom_data = reinterpret_cast<int16_t *>(&mFifo);
+    effect->u.periodic.custom_len = sizeof(mFifo);
+}
+
+Aw8697Backend::Aw8697Backend(const std::string& sysfsDir)
+    : HapticsBackend(AW8697_NAME),
+      mSysfsDir(sysfsDir),
+      mResonantHz(AW8697_DEFAULT_F0_HZ),
+      mStreams(0),
+      mStreamBytes(0) {
+    std::string path = mSysfsDir + AW8697_WAVE_ATTR;
+    char f0[NAME_BUF_SIZE];
+
+    mWaveFd = TEMP_FAILURE_RETRY(open(path.c_str(), O_WRONLY | O_CLOEXEC));
+    if (mWaveFd < 0)
+        ALOGW("open %s failed, errno = %d, RTP streaming unavailable", path.c_str(), -errno);
+
+    /* The driver keeps the calibrated f0 in units of 0.1 Hz */
+    path = mSysfsDir + AW8697_F0_ATTR;
+    if (HapticsDiscovery::readSysfs(path.c_str(), f0, sizeof(f0)) > 0 && atoi(f0) > 0)
+        mResonantHz = (atoi(f0) + 5) / 10;
+}
+
+Aw8697Backend::~Aw8697Backend() {
+    if (mWaveFd >= 0)
+        close(mWaveFd);
+}
+
+int32_t Aw8697Backend::streamRateHz() const {
+    return AW8697_RTP_RATE_HZ;
+}
+
+/** Hand a waveform to the RTP FIFO of the chip
+ *
+ *  The driver starts playback with the first chunk and queues the following
+ *  ones, so the call returns as soon as the whole waveform is buffered.
+ */
+int Aw8697Backend::stream(const int8_t *samples, size_t count) {
+    size_t done = 0;
+    ssize_t ret;
+
+    if (mWaveFd < 0)
+        return -1;
+
+    ScopedLatency latency(mStreamLatency);
+    while (done < count) {
+        size_t len = std::min<size_t>(count - done, AW8697_RTP_CHUNK_SIZE);
+
+        ret = TEMP_FAILURE_RETRY(pwrite(mWaveFd, samples + done, len, 0));
+        if (ret <= 0) {
+            mErrors.record(errno);
+            ALOGE("write %s failed, errno = %d", AW8697_WAVE_ATTR, -errno);
+            stopStream();
+            return -1;
+        }
+        done += ret;
+    }
+
+    mStreams++;
+    mStreamBytes += count;
+    return 0;
+}
+
+/* activate is written on every stop, its fd stays open in libxiaomisysfs */
+int Aw8697Backend::stopStream() {
+    std::string path = mSysfsDir + AW8697_ACTIVATE_ATTR;
+
+    if (!xiaomi::Sysfs::getInstance().write(path, "0")) {
+        mErrors.record(errno);
+        ALOGE("failed to stop RTP playback, errno = %d", -errno);
+        return -1;
+    }
+    return 0;
+}
+
+void Aw8697Backend::dump(int fd) {
+    dprintf(fd, "  backend: %s (rtp %s, %d Hz, f0 %d Hz)\n", name(),
+            canStream() ? "available" : "unavailable", AW8697_RTP_RATE_HZ, mResonantHz);
+    dprintf(fd, "  rtp streams: %" PRIu64 " bytes: %" PRIu64 "\n", mStreams, mStreamBytes);
+    mStreamLatency.dump(fd, "rtp write");
+    mErrors.dump(fd);
+}
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "vendor.qti.vibrator"
+
+#include <algorithm>
+#include <cutils/properties.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <log/log.h>
+#include <mutex>
+#include <poll.h>
+#include <set>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "include/HapticsDiscovery.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+#define INPUT_DEV_DIR           "/dev/input/"
+#define INPUT_SYSFS_DIR         "/sys/class/input/"
+#define LAST_DEVICE_PROP        "persist.vendor.vibrator.input_device"
+#define NAME_BUF_SIZE           32
+
+static std::mutex sClaimLock;
+static std::set<std::string> sClaimed;
+
+static const char *kHapticsNames[] = {
+    "qcom-hv-haptics",
+    "qti-haptics",
+    "aw8697_haptic",
+};
+
+/* Read a sysfs attribute into @buf, stripping the trailing newline */
+int HapticsDiscovery::readSysfs(const char *path, char *buf, size_t len) {
+    int fd, ret;
+
+    fd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
+    if (fd < 0)
+        return -errno;
+
+    ret = TEMP_FAILURE_RETRY(read(fd, buf, len - 1));
+    close(fd);
+    if (ret < 0)
+        return -errno;
+
+    while (ret > 0 && (buf[ret - 1] == '\n' || buf[ret - 1] == ' '))
+        ret--;
+    buf[ret] = '\0';
+    return ret;
+}
+
+/* sysfs directory of the input device behind an event node, empty for other nodes */
+std::string HapticsDiscovery::sysfsDir(const std::string& devicePath) {
+    size_t pos = devicePath.rfind('/');
+    std::string node = pos == std::string::npos ? devicePath : devicePath.substr(pos + 1);
+
+    if (node.compare(0, 5, "event"))
+        return "";
+
+    return INPUT_SYSFS_DIR + node + "/device";
+}
+
+/* Check the device name through sysfs, so the node itself is never opened */
+bool HapticsDiscovery::isHapticsNode(const std::string& devicePath) {
+    std::string dir = sysfsDir(devicePath);
+    char name[NAME_BUF_SIZE];
+
+    if (dir.empty())
+        return false;
+
+    if (readSysfs((dir + "/name").c_str(), name, sizeof(name)) <= 0)
+        return false;
+
+    for (auto hapticsName : kHapticsNames) {
+        if (!strcmp(name, hapticsName)) {
+            ALOGI("%s is detected at %s", name, devicePath.c_str());
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Every haptics input device node, in event number order */
+std::vector<std::string> HapticsDiscovery::findDevices() {
+    std::vector<std::string> found;
+    struct dirent *dir;
+    DIR *dp;
+
+    dp = opendir(INPUT_SYSFS_DIR);
+    if (!dp) {
+        ALOGE("open %s failed, errno = %d", INPUT_SYSFS_DIR, errno);
+        return found;
+    }
+
+    while ((dir = readdir(dp)) != NULL) {
+        std::string devicePath = std::string(INPUT_DEV_DIR) + dir->d_name;
+
+        if (isHapticsNode(devicePath))
+            found.push_back(devicePath);
+    }
+
+    closedir(dp);
+    std::sort(found.begin(), found.end(), [](const std::string& a, const std::string& b) {
+        return a.size() != b.size() ? a.size() < b.size() : a < b;
+    });
+    return found;
+}
+
+/** Resolve the primary haptics input device node
+ *
+ *  The node found on a previous boot is tried first. Input numbering is not
+ *  stable across boots, so it is verified through sysfs before it is used and
+ *  /sys/class/input is scanned when it no longer matches.
+ */
+std::string HapticsDiscovery::findDevice() {
+    char cached[PROPERTY_VALUE_MAX];
+    std::vector<std::string> found;
+
+    if (property_get(LAST_DEVICE_PROP, cached, "") > 0 && isHapticsNode(cached))
+        return cached;
+
+    found = findDevices();
+    if (found.empty())
+        return "";
+
+    rememberDevice(found[0]);
+    return found[0];
+}
+
+bool HapticsDiscovery::claim(const std::string& devicePath) {
+    std::lock_guard<std::mutex> lock(sClaimLock);
+
+    return sClaimed.insert(devicePath).second;
+}
+
+void HapticsDiscovery::release(const std::string& devicePath) {
+    std::lock_guard<std::mutex> lock(sClaimLock);
+
+    sClaimed.erase(devicePath);
+}
+
+void HapticsDiscovery::rememberDevice(const std::string& devicePath) {
+    char cached[PROPERTY_VALUE_MAX];
+
+    if (property_get(LAST_DEVICE_PROP, cached, "") > 0 && devicePath == cached)
+        return;
+
+    if (property_set(LAST_DEVICE_PROP, devicePath.c_str()) != 0)
+        ALOGW("failed to remember haptics device %s", devicePath.c_str());
+}
+
+HapticsDiscovery::HapticsDiscovery() : mInotifyFd(-1), mEventFd(-1) {}
+
+HapticsDiscovery::~HapticsDiscovery() {
+    uint64_t one = 1;
+
+    if (mThread.joinable()) {
+        if (TEMP_FAILURE_RETRY(write(mEventFd, &one, sizeof(one))) == -1)
+            ALOGE("failed to stop hotplug watcher, errno = %d", -errno);
+        mThread.join();
+    }
+
+    if (mInotifyFd >= 0)
+        close(mInotifyFd);
+    if (mEventFd >= 0)
+        close(mEventFd);
+}
+
+void HapticsDiscovery::startWatching(Callback callback) {
+    mCallback = callback;
+
+    mInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    mEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mInotifyFd < 0 || mEventFd < 0) {
+        ALOGE("failed to create hotplug watcher fds, errno = %d", -errno);
+        return;
+    }
+
+    /* Nodes show up before ueventd fixes their permissions, so watch IN_ATTRIB too */
+    if (inotify_add_watch(mInotifyFd, INPUT_DEV_DIR, IN_CREATE | IN_ATTRIB | IN_DELETE) < 0) {
+        ALOGE("failed to watch %s, errno = %d", INPUT_DEV_DIR, -errno);
+        return;
+    }
+
+    mThread = std::thread(&HapticsDiscovery::threadLoop, this);
+}
+
+void HapticsDiscovery::threadLoop() {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd fds[2] = {
+        {.fd = mInotifyFd, .events = POLLIN, .revents = 0},
+        {.fd = mEventFd, .events = POLLIN, .revents = 0},
+    };
+
+    while (true) {
+        if (TEMP_FAILURE_RETRY(poll(fds, 2, -1)) < 0) {
+            ALOGE("failed to poll hotplug fds, errno = %d", -errno);
+            return;
+        }
+
+        if (fds[1].revents)
+            return;
+
+        ssize_t len = TEMP_FAILURE_RETRY(read(mInotifyFd, buf, sizeof(buf)));
+        if (len <= 0)
+            continue;
+
+        for (char *ptr = buf; ptr < buf + len;) {
+            const struct inotify_event *event = (const struct inotify_event *)ptr;
+
+            ptr += sizeof(struct inotify_event) + event->len;
+            if (event->len == 0)
+                continue;
+
+            mCallback(std::string(INPUT_DEV_DIR) + event->name, !(event->mask & IN_DELETE));
+        }
+    }
+}
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "include/Stats.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+LatencyHistogram::LatencyHistogram() : mCount(0), mSumUs(0), mMaxUs(0) {
+    for (auto& bucket : mBuckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record(int64_t ns) {
+    uint64_t us = ns > 0 ? ns / 1000 : 0;
+    uint64_t max = mMaxUs.load(std::memory_order_relaxed);
+    int bucket = us ? 64 - __builtin_clzll(us) : 0;
+
+    if (bucket >= kBuckets)
+        bucket = kBuckets - 1;
+
+    mBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mSumUs.fetch_add(us, std::memory_order_relaxed);
+    while (us > max && !mMaxUs.compare_exchange_weak(max, us, std::memory_order_relaxed))
+        ;
+}
+
+/* Upper bound of the bucket holding the requested percentile, capped by the max */
+int64_t LatencyHistogram::percentileUs(uint64_t count, int percent) const {
+    int64_t maxUs = mMaxUs.load(std::memory_order_relaxed);
+    uint64_t target = (count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < kBuckets; i++) {
+        seen += mBuckets[i].load(std::memory_order_relaxed);
+        if (seen >= target)
+            return std::min<int64_t>(int64_t{1} << i, maxUs);
+    }
+
+    return maxUs;
+}
+
+void LatencyHistogram::dump(int fd, const char *name) const {
+    uint64_t count = mCount.load(std::memory_order_relaxed);
+
+    if (count == 0) {
+        dprintf(fd, "  %-16s count=0\n", name);
+        return;
+    }
+
+    dprintf(fd, "  %-16s count=%" PRIu64 " avg=%" PRIu64 "us p50<=%" PRId64 "us p99<=%" PRId64
+            "us max=%" PRIu64 "us\n", name, count,
+            mSumUs.load(std::memory_order_relaxed) / count, percentileUs(count, 50),
+            percentileUs(count, 99), mMaxUs.load(std::memory_order_relaxed));
+}
+
+ErrorCounter::ErrorCounter() {
+    for (auto& count : mCounts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+void ErrorCounter::record(int err) {
+    if (err < 0)
+        err = -err;
+    if (err > kMaxErrno)
+        err = 0;
+
+    mCounts[err].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ErrorCounter::dump(int fd) const {
+    bool any = false;
+
+    for (int i = 0; i <= kMaxErrno; i++) {
+        uint32_t count = mCounts[i].load(std::memory_order_relaxed);
+        if (count == 0)
+            continue;
+        dprintf(fd, "  %s: %u\n", i ? strerror(i) : "unknown", count);
+        any = true;
+    }
+
+    if (!any)
+        dprintf(fd, "  none\n");
+}
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "vendor.qti.vibrator"
+
+#include <fcntl.h>
+#include <log/log.h>
+#include <stdio.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "include/DeviceWorker.h"
+#include "include/TraceRecorder.h"
+#include "include/Utils.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+TraceRecorder::TraceRecorder() : mHeader(NULL), mRecords(NULL), mSize(0) {}
+
+TraceRecorder::~TraceRecorder() {
+    if (mHeader != NULL)
+        munmap(mHeader, mSize);
+}
+
+/** Map a fresh trace ring at @path
+ *
+ *  The trace of the previous run is kept next to it with an ".old" suffix, so
+ *  a capture survives one restart of the HAL.
+ */
+bool TraceRecorder::open(const char *path) {
+    std::string old = std::string(path) + ".old";
+    void *addr;
+    int fd;
+
+    if (mHeader != NULL)
+        return true;
+
+    rename(path, old.c_str());
+
+    fd = TEMP_FAILURE_RETRY(::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0640));
+    if (fd < 0) {
+        ALOGE("open %s failed, errno = %d", path, -errno);
+        return false;
+    }
+
+    mSize = sizeof(TraceHeader) + sizeof(TraceRecord) * TRACE_CAPACITY;
+    if (ftruncate(fd, mSize) != 0) {
+        ALOGE("failed to size %s, errno = %d", path, -errno);
+        close(fd);
+        return false;
+    }
+
+    addr = mmap(NULL, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        ALOGE("failed to map %s, errno = %d", path, -errno);
+        return false;
+    }
+
+    mHeader = static_cast<TraceHeader *>(addr);
+    mHeader->magic = TRACE_MAGIC;
+    mHeader->version = TRACE_VERSION;
+    mHeader->capacity = TRACE_CAPACITY;
+    mHeader->recordSize = sizeof(TraceRecord);
+    mHeader->next.store(0);
+    mRecords = reinterpret_cast<TraceRecord *>(mHeader + 1);
+
+    ALOGI("recording HAL calls to %s", path);
+    return true;
+}
+
+void TraceRecorder::record(TraceCall call, int64_t startNs, int64_t durationNs,
+                           int64_t deviceNs, int32_t result, int32_t arg0, int32_t arg1) {
+    TraceRecord *rec;
+    uint64_t seq;
+
+    if (mRecords == NULL)
+        return;
+
+    seq = mHeader->next.fetch_add(1, std::memory_order_relaxed) + 1;
+    rec = &mRecords[(seq - 1) % TRACE_CAPACITY];
+
+    __atomic_store_n(&rec->seq, 0, __ATOMIC_RELAXED);
+    rec->startNs = startNs;
+    rec->durationUs = durationNs / 1000;
+    rec->deviceUs = deviceNs / 1000;
+    rec->call = call;
+    rec->result = result;
+    rec->args[0] = arg0;
+    rec->args[1] = arg1;
+    __atomic_store_n(&rec->seq, seq, __ATOMIC_RELEASE);
+}
+
+uint64_t TraceRecorder::count() const {
+    return mHeader != NULL ? mHeader->next.load(std::memory_order_relaxed) : 0;
+}
+
+ScopedTrace::ScopedTrace(TraceRecorder& recorder, TraceCall call, int32_t arg0, int32_t arg1)
+    : mRecorder(recorder), mCall(call), mArgs{arg0, arg1}, mResult(EX_NONE), mStartNs(0) {
+    if (!mRecorder.enabled())
+        return;
+
+    DeviceWorker::takeDeviceNs();
+    mStartNs = nowNs();
+}
+
+ScopedTrace::~ScopedTrace() {
+    if (!mRecorder.enabled())
+        return;
+
+    mRecorder.record(mCall, mStartNs, nowNs() - mStartNs, DeviceWorker::takeDeviceNs(),
+                     mResult, mArgs[0], mArgs[1]);
+}
+
+ndk::ScopedAStatus ScopedTrace::status(int32_t exception) {
+    mResult = exception;
+    return ndk::ScopedAStatus(AStatus_fromExceptionCode(exception));
+}
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
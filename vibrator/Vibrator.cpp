@@ -29,15 +29,21 @@
 
 #define LOG_TAG "vendor.qti.vibrator"
 
+#include <algorithm>
 #include <cutils/properties.h>
-#include <dirent.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <math.h>
 #include <linux/input.h>
 #include <log/log.h>
 #include <string.h>
 #include <sys/ioctl.h>
-#include <thread>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <Sysfs.h>
 
+#include "include/HapticsDiscovery.h"
+#include "include/Utils.h"
 #include "include/Vibrator.h"
 
 namespace aidl {
@@ -51,6 +57,20 @@ namespace vibrator {
 #define INVALID_VALUE           -1
 #define CUSTOM_DATA_LEN         3
 #define NAME_BUF_SIZE           32
+#define DEFAULT_GAIN_RATE_HZ    250
+
+#define COMPOSE_DELAY_MAX_MS    1000
+#define COMPOSE_SIZE_MAX        256
+/* Compositions of this many primitives are streamed when the chip can */
+#define COMPOSE_STREAM_MIN_SIZE 4
+#define COMPOSE_STREAM_MAX_MS   10000
+/* Synthesized amplitudes are quantized so that repeats hit the waveform cache */
+#define SYNTH_SCALE_STEPS       64
+
+#define TRACE_PATH              "/data/vendor/vibrator/trace"
+
+/* Always-on source of a finger landing on the under-display sensor */
+#define ALWAYS_ON_FOD_ID        0
 
 #define MSM_CPU_LAHAINA         415
 #define APQ_CPU_LAHAINA         439
@@ -61,100 +81,566 @@ namespace vibrator {
 
 #define test_bit(bit, array)    ((array)[(bit)/8] & (1<<((bit)%8)))
 
-InputFFDevice::InputFFDevice()
-{
-    DIR *dp;
-    FILE *fp = NULL;
-    struct dirent *dir;
-    uint8_t ffBitmask[FF_CNT / 8];
-    char devicename[PATH_MAX];
-    const char *INPUT_DIR = "/dev/input/";
-    char name[NAME_BUF_SIZE];
-    int fd, ret;
-    int soc = property_get_int32("ro.vendor.qti.soc_id", -1);
+/* Per-call logging, off by default to keep logd out of the hot path */
+static std::atomic<bool> sDebugLogging(false);
+
+#define DEBUG_LOGD(...) \
+    do { \
+        if (sDebugLogging.load(std::memory_order_relaxed)) \
+            ALOGD(__VA_ARGS__); \
+    } while (0)
 
+/* Effects with a predefined waveform in the driver */
+static const Effect kDriverEffects[] = {
+    Effect::CLICK, Effect::DOUBLE_CLICK, Effect::TICK, Effect::THUD, Effect::POP,
+    Effect::HEAVY_CLICK,
+};
+
+/*
+ * Shape of a synthesized waveform, with frequencies relative to the resonance
+ * of the actuator. A zero duration takes the one of the primitive it renders.
+ */
+struct SynthShape {
+    int32_t durationMs;
+    int32_t attackMs;
+    int32_t decayMs;
+    float startRatio;
+    float endRatio;
+    float startAmp;
+    float endAmp;
+};
+
+/* Primitive shapes for compositions that are streamed as a single waveform */
+static const struct {
+    CompositePrimitive primitive;
+    SynthShape shape;
+} kPrimitiveShapes[] = {
+    {CompositePrimitive::CLICK, {0, 1, 6, 1.0f, 1.0f, 1.0f, 1.0f}},
+    {CompositePrimitive::THUD, {0, 2, 20, 1.0f, 0.7f, 1.0f, 0.6f}},
+    {CompositePrimitive::LIGHT_TICK, {0, 0, 4, 1.0f, 1.0f, 0.6f, 0.6f}},
+};
+
+/* Effects without a driver waveform, synthesized where the chip takes raw waveforms */
+static const struct {
+    Effect effect;
+    SynthShape shape;
+} kSynthEffects[] = {
+    {Effect::TEXTURE_TICK, {8, 0, 4, 1.2f, 1.2f, 0.5f, 0.5f}},
+};
+
+/* Composition primitives backed by a predefined effect of the driver */
+static const struct {
+    CompositePrimitive primitive;
+    Effect effect;
+} kPrimitiveEffects[] = {
+    {CompositePrimitive::CLICK, Effect::CLICK},
+    {CompositePrimitive::THUD, Effect::THUD},
+    {CompositePrimitive::LIGHT_TICK, Effect::TICK},
+};
+
+/* An empty @devicePath picks the primary haptics device */
+InputFFDevice::InputFFDevice(const std::string& path)
+{
     mVibraFd = INVALID_VALUE;
     mSupportGain = false;
     mSupportEffects = false;
     mSupportExternalControl = false;
+    mSupportStreaming = false;
+    mStreaming = false;
     mCurrAppId = INVALID_VALUE;
+    mCurrAppIdResident = false;
     mCurrMagnitude = 0x7fff;
+    mCurrGain = INVALID_VALUE;
+    mLruClock = 0;
+    mMaxResident = INT_MAX;
+    mSyscallNs = 0;
+    mWrittenGain = INVALID_VALUE;
+    mPendingGain = INVALID_VALUE;
+    mLastGainNs = 0;
+    mGainIntervalNs = 0;
+    memset(&mGainStats, 0, sizeof(mGainStats));
+    mDiscoveryUs = 0;
     mInExternalControl = false;
+    mSyncHold = false;
+    mStagedCount = 0;
+
+    int rateHz = property_get_int32("ro.vendor.vibrator.gain_rate_hz", DEFAULT_GAIN_RATE_HZ);
+    if (rateHz > 0)
+        mGainIntervalNs = 1000000000LL / rateHz;
 
-    dp = opendir(INPUT_DIR);
-    if (!dp) {
-        ALOGE("open %s failed, errno = %d", INPUT_DIR, errno);
+    int64_t startNs = nowNs();
+    std::string devicePath = path.empty() ? HapticsDiscovery::findDevice() : path;
+    if (devicePath.empty()) {
+        ALOGE("no haptics input device found");
         return;
     }
 
+    openDevice(devicePath);
+    mDiscoveryUs = (nowNs() - startNs) / 1000;
+    ALOGI("haptics device %s opened in %" PRId64 " us", devicePath.c_str(), mDiscoveryUs);
+}
+
+InputFFDevice::~InputFFDevice() {
+    closeDevice();
+}
+
+bool InputFFDevice::openDevice(const std::string& devicePath) {
+    uint8_t ffBitmask[FF_CNT / 8];
+    char socId[NAME_BUF_SIZE];
+    int soc = property_get_int32("ro.vendor.qti.soc_id", -1);
+    int fd, ret, maxEffects;
+
+    /* Another actuator already drives this node */
+    if (!HapticsDiscovery::claim(devicePath))
+        return false;
+
+    fd = TEMP_FAILURE_RETRY(open(devicePath.c_str(), O_RDWR | O_CLOEXEC));
+    if (fd < 0) {
+        ALOGE("open %s failed, errno = %d", devicePath.c_str(), errno);
+        HapticsDiscovery::release(devicePath);
+        return false;
+    }
+
     memset(ffBitmask, 0, sizeof(ffBitmask));
-    while ((dir = readdir(dp)) != NULL){
-        if (dir->d_name[0] == '.' &&
-            (dir->d_name[1] == '\0' ||
-             (dir->d_name[1] == '.' && dir->d_name[2] == '\0')))
-            continue;
+    ret = TEMP_FAILURE_RETRY(ioctl(fd, EVIOCGBIT(EV_FF, sizeof(ffBitmask)), ffBitmask));
+    if (ret == -1) {
+        ALOGE("ioctl failed, errno = %d", errno);
+        close(fd);
+        HapticsDiscovery::release(devicePath);
+        return false;
+    }
 
-        snprintf(devicename, PATH_MAX, "%s%s", INPUT_DIR, dir->d_name);
-        fd = TEMP_FAILURE_RETRY(open(devicename, O_RDWR));
-        if (fd < 0) {
-            ALOGE("open %s failed, errno = %d", devicename, errno);
-            continue;
+    if (!test_bit(FF_CONSTANT, ffBitmask) && !test_bit(FF_PERIODIC, ffBitmask)) {
+        ALOGE("%s doesn't support constant or periodic effects", devicePath.c_str());
+        close(fd);
+        HapticsDiscovery::release(devicePath);
+        return false;
+    }
+
+    mVibraFd = fd;
+    {
+        std::lock_guard<std::mutex> lock(mPathLock);
+        mDevicePath = devicePath;
+    }
+    mSupportEffects = test_bit(FF_CUSTOM, ffBitmask);
+    mSupportGain = test_bit(FF_GAIN, ffBitmask);
+    mBackend = HapticsBackend::probe(devicePath);
+    mSupportStreaming = mBackend->canStream() || mBackend->customRateHz() > 0;
+
+    /*
+     * qti-haptics and aw8697 latch the pattern at EVIOCSFF and play it for
+     * whichever effect ID gets triggered, so effects only stay resident where
+     * ro.vendor.vibrator.resident_effects says the driver keeps one effect per
+     * slot. Everywhere else each play uploads its own effect.
+     *
+     * Keep one driver slot free for the transient constant effect of on(),
+     * so that neither it nor an on-demand upload has to fail an EVIOCSFF
+     * with ENOSPC before a resident effect gets evicted.
+     */
+    ret = TEMP_FAILURE_RETRY(ioctl(fd, EVIOCGEFFECTS, &maxEffects));
+    if (!property_get_bool("ro.vendor.vibrator.resident_effects", false))
+        mMaxResident = 0;
+    else if (ret == -1 || maxEffects <= 0)
+        mMaxResident = INT_MAX;
+    else
+        mMaxResident = maxEffects - 1;
+
+    if (soc <= 0 && HapticsDiscovery::readSysfs("/sys/devices/soc0/soc_id",
+                                                socId, sizeof(socId)) > 0)
+        soc = atoi(socId);
+    switch (soc) {
+    case MSM_CPU_LAHAINA:
+    case APQ_CPU_LAHAINA:
+    case MSM_CPU_SHIMA:
+    case MSM_CPU_SM8325:
+    case APQ_CPU_SM8325P:
+    case MSM_CPU_YUPIK:
+        mSupportExternalControl = true;
+        break;
+    default:
+        mSupportExternalControl = false;
+        break;
+    }
+
+    return true;
+}
+
+void InputFFDevice::closeDevice() {
+    if (mVibraFd == INVALID_VALUE)
+        return;
+
+    /* The kernel drops every uploaded effect together with the fd */
+    close(mVibraFd);
+    HapticsDiscovery::release(mDevicePath);
+    mVibraFd = INVALID_VALUE;
+    mBackend.reset();
+    mSupportStreaming = false;
+    mStreaming = false;
+    mStagedCount = 0;
+    mWrittenGain = INVALID_VALUE;
+    mPendingGain = INVALID_VALUE;
+    mCurrAppId = INVALID_VALUE;
+    mCurrAppIdResident = false;
+    for (auto& slot : mEffectSlots)
+        slot.id = INVALID_VALUE;
+    for (auto& entry : mAlwaysOnSlots)
+        entry.slot.id = INVALID_VALUE;
+}
+
+std::string InputFFDevice::getDevicePath() const {
+    std::lock_guard<std::mutex> lock(mPathLock);
+
+    return mDevicePath;
+}
+
+/** Handle a node appearing in or disappearing from /dev/input
+ *
+ *  If the haptics node goes away with its driver, the fd is released and the
+ *  HAL keeps acting as a no-op until a node with a haptics name shows up again.
+ *  The effects are then uploaded again so the slot cache is warm right away.
+ */
+void InputFFDevice::onHotplug(const std::string& devicePath, bool added) {
+    if (!added) {
+        if (devicePath == mDevicePath && mVibraFd != INVALID_VALUE) {
+            ALOGW("haptics device %s removed", devicePath.c_str());
+            closeDevice();
         }
+        return;
+    }
 
-        ret = TEMP_FAILURE_RETRY(ioctl(fd, EVIOCGNAME(sizeof(name)), name));
-        if (ret == -1) {
-            ALOGE("get input device name %s failed, errno = %d\n", devicename, errno);
-            close(fd);
-            continue;
+    if (mVibraFd != INVALID_VALUE || !HapticsDiscovery::isHapticsNode(devicePath))
+        return;
+
+    if (openDevice(devicePath)) {
+        ALOGI("haptics device re-acquired at %s", devicePath.c_str());
+        uploadEffects();
+    }
+}
+
+static int16_t strengthToMagnitude(EffectStrength es) {
+    switch (es) {
+    case EffectStrength::LIGHT:
+        return LIGHT_MAGNITUDE;
+    case EffectStrength::MEDIUM:
+        return MEDIUM_MAGNITUDE;
+    case EffectStrength::STRONG:
+        return STRONG_MAGNITUDE;
+    default:
+        return 0;
+    }
+}
+
+/** Upload predefined effects into resident FF slots
+ *
+ *  Every (effect, strength) pair is uploaded once into its own kernel FF slot so
+ *  that playing it later only needs a single write() of the EV_FF play event.
+ *  The play length returned by the driver in custom_data is cached together with
+ *  the slot. If the driver runs out of slots, the remaining pairs stay unloaded
+ *  and are uploaded on demand, evicting the least recently used slot.
+ */
+void InputFFDevice::loadEffects(const std::vector<Effect>& effects) {
+    const EffectStrength strengths[] = {EffectStrength::LIGHT, EffectStrength::MEDIUM,
+                                        EffectStrength::STRONG};
+
+    mEffectSlots.clear();
+    for (auto e : effects) {
+        for (auto es : strengths) {
+            EffectSlot slot = {static_cast<int>(e), es, INVALID_VALUE, 0, 0};
+            mEffectSlots.push_back(slot);
         }
+    }
 
-        if (strcmp(name, "qcom-hv-haptics") && strcmp(name, "qti-haptics")
-            && strcmp(name, "aw8697_haptic")) {
-            ALOGD("not a qcom/qti haptics device\n");
-            close(fd);
-            continue;
+    uploadEffects();
+}
+
+void InputFFDevice::uploadEffects() {
+    int loaded = 0;
+
+    if (mVibraFd == INVALID_VALUE || !mSupportEffects)
+        return;
+
+    /* Upload each effect once for its play length and give the slot back */
+    if (mMaxResident == 0) {
+        for (auto& slot : mEffectSlots) {
+            if (uploadSlot(&slot, false) == 0)
+                releaseSlot(&slot);
         }
+        ALOGI("driver latches effects on upload, %zu effects uploaded per play",
+              mEffectSlots.size());
+        return;
+    }
 
-        ALOGI("%s is detected at %s\n", name, devicename);
-        ret = TEMP_FAILURE_RETRY(ioctl(fd, EVIOCGBIT(EV_FF, sizeof(ffBitmask)), ffBitmask));
-        if (ret == -1) {
-            ALOGE("ioctl failed, errno = %d", errno);
-            close(fd);
+    /* Always-on effects go first so they get their slots back on reopen */
+    for (auto& entry : mAlwaysOnSlots) {
+        if (uploadSlot(&entry.slot, false) == 0)
+            loaded++;
+        else
+            ALOGE("failed to restore always-on effect %d", entry.id);
+    }
+
+    for (auto& slot : mEffectSlots) {
+        if (loaded >= mMaxResident)
+            break;
+        if (uploadSlot(&slot, false) == 0)
+            loaded++;
+        else if (errno == ENOSPC)
+            break;
+    }
+
+    ALOGI("%d of %zu effects resident in driver slots", loaded,
+          mEffectSlots.size() + mAlwaysOnSlots.size());
+}
+
+int InputFFDevice::uploadEffect(struct ff_effect *effect) {
+    ScopedLatency latency(mUploadLatency, &mSyscallNs);
+    int ret;
+
+    ret = TEMP_FAILURE_RETRY(ioctl(mVibraFd, EVIOCSFF, effect));
+    if (ret == -1 && errno != ENOSPC)
+        mErrors.record(errno);
+
+    return ret;
+}
+
+int InputFFDevice::eraseEffect(int16_t id) {
+    ScopedLatency latency(mEraseLatency, &mSyscallNs);
+    int ret;
+
+    ret = TEMP_FAILURE_RETRY(ioctl(mVibraFd, EVIOCRMFF, id));
+    if (ret == -1)
+        mErrors.record(errno);
+
+    return ret;
+}
+
+InputFFDevice::EffectSlot *InputFFDevice::findSlot(int effectId, EffectStrength es) {
+    for (auto& slot : mEffectSlots) {
+        if (slot.effectId == effectId && slot.strength == es)
+            return &slot;
+    }
+
+    return NULL;
+}
+
+int InputFFDevice::residentSlots() {
+    int resident = 0;
+
+    for (const auto& slot : mEffectSlots) {
+        if (slot.id != INVALID_VALUE)
+            resident++;
+    }
+
+    for (const auto& entry : mAlwaysOnSlots) {
+        if (entry.slot.id != INVALID_VALUE)
+            resident++;
+    }
+
+    return resident;
+}
+
+/* Release the least recently used resident effect to free a driver slot */
+bool InputFFDevice::evictLruSlot() {
+    EffectSlot *victim = NULL;
+
+    for (auto& slot : mEffectSlots) {
+        if (slot.id == INVALID_VALUE)
             continue;
+        if (victim == NULL || slot.lastUsed < victim->lastUsed)
+            victim = &slot;
+    }
+
+    if (victim == NULL)
+        return false;
+
+    return releaseSlot(victim) == 0;
+}
+
+/* Erase a resident effect from its driver slot, keeping the slot entry */
+int InputFFDevice::releaseSlot(EffectSlot *slot) {
+    int ret;
+
+    if (slot->id == INVALID_VALUE || mVibraFd == INVALID_VALUE) {
+        slot->id = INVALID_VALUE;
+        return 0;
+    }
+
+    ret = eraseEffect(slot->id);
+    if (ret == -1) {
+        ALOGE("ioctl EVIOCRMFF failed, errno = %d", -errno);
+        return ret;
+    }
+
+    if (mCurrAppId == slot->id) {
+        mCurrAppId = INVALID_VALUE;
+        mCurrAppIdResident = false;
+    }
+    slot->id = INVALID_VALUE;
+    return 0;
+}
+
+int InputFFDevice::uploadSlot(EffectSlot *slot, bool evict) {
+    struct ff_effect effect;
+    int16_t data[CUSTOM_DATA_LEN] = {0, 0, 0};
+    int ret;
+
+    if (evict && residentSlots() >= mMaxResident)
+        evictLruSlot();
+
+    do {
+        memset(&effect, 0, sizeof(effect));
+        data[0] = slot->effectId;
+        effect.type = FF_PERIODIC;
+        effect.id = INVALID_VALUE;
+        effect.u.periodic.waveform = FF_CUSTOM;
+        effect.u.periodic.magnitude = strengthToMagnitude(slot->strength);
+        effect.u.periodic.custom_data = data;
+        effect.u.periodic.custom_len = sizeof(int16_t) * CUSTOM_DATA_LEN;
+
+        ret = uploadEffect(&effect);
+    } while (ret == -1 && errno == ENOSPC && evict && evictLruSlot());
+
+    if (ret == -1) {
+        if (evict || errno != ENOSPC)
+            ALOGE("ioctl EVIOCSFF failed, errno = %d", -errno);
+        return ret;
+    }
+
+    slot->id = effect.id;
+    slot->playLengthMs = data[1] * 1000 + data[2];
+    return 0;
+}
+
+/* Stop the effect that is currently playing, keeping it resident if cached */
+int InputFFDevice::stopCurrent() {
+    struct input_event stop;
+    int ret;
+
+    mStagedCount = 0;
+    ret = stopStream();
+    if (mCurrAppId == INVALID_VALUE)
+        return ret;
+
+    if (mCurrAppIdResident) {
+        memset(&stop, 0, sizeof(stop));
+        stop.type = EV_FF;
+        stop.code = mCurrAppId;
+        stop.value = 0;
+        {
+            ScopedLatency latency(mWriteLatency, &mSyscallNs);
+            ret = TEMP_FAILURE_RETRY(write(mVibraFd, (const void*)&stop, sizeof(stop)));
+        }
+        if (ret == -1) {
+            mErrors.record(errno);
+            ALOGE("write failed, errno = %d\n", -errno);
         }
+    } else {
+        ret = eraseEffect(mCurrAppId);
+        if (ret == -1)
+            ALOGE("ioctl EVIOCRMFF failed, errno = %d", -errno);
+    }
 
-        if (test_bit(FF_CONSTANT, ffBitmask) ||
-                test_bit(FF_PERIODIC, ffBitmask)) {
-            mVibraFd = fd;
-            if (test_bit(FF_CUSTOM, ffBitmask))
-                mSupportEffects = true;
-            if (test_bit(FF_GAIN, ffBitmask))
-                mSupportGain = true;
-
-            if (soc <= 0 && (fp = fopen("/sys/devices/soc0/soc_id", "r")) != NULL) {
-                fscanf(fp, "%u", &soc);
-                fclose(fp);
-            }
-            switch (soc) {
-            case MSM_CPU_LAHAINA:
-            case APQ_CPU_LAHAINA:
-            case MSM_CPU_SHIMA:
-            case MSM_CPU_SM8325:
-            case APQ_CPU_SM8325P:
-            case MSM_CPU_YUPIK:
-                mSupportExternalControl = true;
-                break;
-            default:
-                mSupportExternalControl = false;
-                break;
-            }
-            break;
+    mCurrAppId = INVALID_VALUE;
+    mCurrAppIdResident = false;
+    return ret == -1 ? ret : 0;
+}
+
+/** Play a resident effect
+ *
+ *  The stop event of the previous resident effect and, if @gain is valid or a
+ *  rate limited gain update is still pending, the FF_GAIN event are batched
+ *  with the play event into a single writev().
+ */
+int InputFFDevice::playSlot(EffectSlot *slot, int32_t gain, long *playLengthMs) {
+    int count = 0;
+    int ret;
+
+    stopStream();
+    if (slot->id == INVALID_VALUE) {
+        /* A latching driver would lose the new pattern to a later erase */
+        if (mMaxResident == 0 && mCurrAppId != INVALID_VALUE) {
+            ret = stopCurrent();
+            if (ret != 0)
+                return ret;
         }
+        ret = uploadSlot(slot, true);
+        if (ret != 0)
+            return ret;
+    }
 
-        close(fd);
+    memset(mStaged, 0, sizeof(mStaged));
+    if (mCurrAppId != INVALID_VALUE && mCurrAppId != slot->id) {
+        if (mCurrAppIdResident) {
+            mStaged[count].type = EV_FF;
+            mStaged[count].code = mCurrAppId;
+            mStaged[count].value = 0;
+            count++;
+        } else {
+            ret = stopCurrent();
+            if (ret != 0)
+                return ret;
+        }
     }
 
-    closedir(dp);
+    if (gain != INVALID_VALUE)
+        mPendingGain = gain != mWrittenGain ? gain : INVALID_VALUE;
+
+    mStaged[count].type = EV_FF;
+    mStaged[count].code = slot->id;
+    mStaged[count].value = 1;
+    count++;
+    mStagedCount = count;
+
+    mCurrAppId = slot->id;
+    mCurrAppIdResident = mMaxResident > 0;
+    if (!mCurrAppIdResident)
+        slot->id = INVALID_VALUE;
+    slot->lastUsed = ++mLruClock;
+    if (playLengthMs != NULL)
+        *playLengthMs = slot->playLengthMs;
+
+    return mSyncHold ? 0 : fireStaged();
+}
+
+/* Write the play events prepared by the last play */
+int InputFFDevice::fireStaged() {
+    int ret;
+
+    if (mStagedCount == 0)
+        return 0;
+
+    ret = writeEvents(mStaged, mStagedCount);
+    mStagedCount = 0;
+    if (ret == -1) {
+        ALOGE("write failed, errno = %d\n", -errno);
+        if (!mCurrAppIdResident && eraseEffect(mCurrAppId) == -1)
+            ALOGE("ioctl EVIOCRMFF failed, errno = %d", -errno);
+        mCurrAppId = INVALID_VALUE;
+        mCurrAppIdResident = false;
+        return ret;
+    }
+
+    return 0;
+}
+
+/** Hold back plays for a synced trigger
+ *
+ *  While held, on() and playEffect() do everything up to the final write: the
+ *  effect is uploaded and the stop and play events are staged, so that
+ *  triggerSynced() only has a single writev() left to do.
+ */
+void InputFFDevice::prepareSynced() {
+    mSyncHold = true;
+}
+
+int InputFFDevice::triggerSynced() {
+    mSyncHold = false;
+    return fireStaged();
+}
+
+void InputFFDevice::cancelSynced() {
+    mSyncHold = false;
+    if (mStagedCount != 0)
+        stopCurrent();
 }
 
 /** Play vibration
@@ -177,131 +663,612 @@ InputFFDevice::InputFFDevice()
  */
 int InputFFDevice::play(int effectId, uint32_t timeoutMs, long *playLengthMs) {
     struct ff_effect effect;
-    struct input_event play;
     int16_t data[CUSTOM_DATA_LEN] = {0, 0, 0};
     int ret;
 
-    /* For QMAA compliance, return OK even if vibrator device doesn't exist */
+    /* For QMAA compliance, return OK even if vibrator device doesn't exist */
+    if (mVibraFd == INVALID_VALUE) {
+        if (playLengthMs != NULL)
+            *playLengthMs = 0;
+            return 0;
+    }
+
+    if (timeoutMs != 0) {
+        ret = stopCurrent();
+        if (ret != 0)
+            goto errout;
+
+        memset(&effect, 0, sizeof(effect));
+        if (effectId != INVALID_VALUE) {
+            data[0] = effectId;
+            effect.type = FF_PERIODIC;
+            effect.u.periodic.waveform = FF_CUSTOM;
+            effect.u.periodic.magnitude = mCurrMagnitude;
+            effect.u.periodic.custom_data = data;
+            effect.u.periodic.custom_len = sizeof(int16_t) * CUSTOM_DATA_LEN;
+        } else {
+            effect.type = FF_CONSTANT;
+            effect.u.constant.level = mCurrMagnitude;
+            effect.replay.length = timeoutMs;
+        }
+
+        effect.id = mCurrAppId;
+        effect.replay.delay = 0;
+
+        do {
+            ret = uploadEffect(&effect);
+        } while (ret == -1 && errno == ENOSPC && evictLruSlot());
+        if (ret == -1) {
+            ALOGE("ioctl EVIOCSFF failed, errno = %d", -errno);
+            goto errout;
+        }
+
+        mCurrAppId = effect.id;
+        if (effectId != INVALID_VALUE && playLengthMs != NULL) {
+            *playLengthMs = data[1] * 1000 + data[2];
+        }
+
+        memset(mStaged, 0, sizeof(mStaged));
+        mStaged[0].value = 1;
+        mStaged[0].type = EV_FF;
+        mStaged[0].code = mCurrAppId;
+        mStagedCount = 1;
+        if (!mSyncHold) {
+            ret = fireStaged();
+            if (ret != 0)
+                goto errout;
+        }
+    } else if (mCurrAppId != INVALID_VALUE || mStreaming) {
+        ret = stopCurrent();
+        if (ret != 0)
+            goto errout;
+    }
+    return 0;
+
+errout:
+    mCurrAppId = INVALID_VALUE;
+    mCurrAppIdResident = false;
+    return ret;
+}
+
+int InputFFDevice::on(int32_t timeoutMs) {
+    return play(INVALID_VALUE, timeoutMs, NULL);
+}
+
+int InputFFDevice::off() {
+    return play(INVALID_VALUE, 0, NULL);
+}
+
+/** Write input events, preceded by the pending FF_GAIN event if there is one
+ *
+ *  The gain and the other events go down in one writev() so that a gain update
+ *  held back by the rate limit costs no extra syscall when a play follows.
+ */
+int InputFFDevice::writeEvents(const struct input_event *events, int count) {
+    struct input_event gain;
+    struct iovec iov[2];
+    int n = 0;
+    int ret;
+
+    if (mPendingGain != INVALID_VALUE) {
+        memset(&gain, 0, sizeof(gain));
+        gain.type = EV_FF;
+        gain.code = FF_GAIN;
+        gain.value = mPendingGain;
+        iov[n].iov_base = &gain;
+        iov[n].iov_len = sizeof(gain);
+        n++;
+    }
+
+    if (count > 0) {
+        iov[n].iov_base = (void *)events;
+        iov[n].iov_len = sizeof(events[0]) * count;
+        n++;
+    }
+
+    if (n == 0)
+        return 0;
+
+    {
+        ScopedLatency latency(mWriteLatency, &mSyscallNs);
+        ret = TEMP_FAILURE_RETRY(writev(mVibraFd, iov, n));
+    }
+    if (ret == -1)
+        mErrors.record(errno);
+    if (mPendingGain == INVALID_VALUE)
+        return ret == -1 ? ret : 0;
+
+    /* A failed gain update is dropped rather than retried on every write */
+    if (ret != -1) {
+        mWrittenGain = mPendingGain;
+        mLastGainNs = nowNs();
+        mGainStats.writes++;
+        if (count > 0)
+            mGainStats.batched++;
+    }
+    mPendingGain = INVALID_VALUE;
+
+    return ret == -1 ? ret : 0;
+}
+
+/** Queue an FF_GAIN update
+ *
+ *  Updates that don't change the gain are dropped. Within the minimum interval
+ *  derived from ro.vendor.vibrator.gain_rate_hz the update is only recorded as
+ *  pending, replacing any older pending one, and written by flushPendingGain()
+ *  once the interval has elapsed or together with the next play event.
+ */
+int InputFFDevice::queueGain(int32_t gain) {
+    int ret;
+
+    if (gain == mWrittenGain) {
+        mPendingGain = INVALID_VALUE;
+        mGainStats.deduplicated++;
+        return 0;
+    }
+
+    if (gain == mPendingGain) {
+        mGainStats.deduplicated++;
+        return 0;
+    }
+
+    mPendingGain = gain;
+    if (mGainIntervalNs > 0 && nowNs() - mLastGainNs < mGainIntervalNs) {
+        mGainStats.deferred++;
+        return 0;
+    }
+
+    ret = writeEvents(NULL, 0);
+    if (ret == -1)
+        ALOGE("write FF_GAIN failed, errno = %d", -errno);
+
+    return ret;
+}
+
+/* Returns when the pending gain update is due, or INVALID_VALUE if none */
+int64_t InputFFDevice::gainDeadlineNs() {
+    if (mPendingGain == INVALID_VALUE || mVibraFd == INVALID_VALUE)
+        return INVALID_VALUE;
+
+    return mLastGainNs + mGainIntervalNs;
+}
+
+void InputFFDevice::flushPendingGain() {
+    if (mPendingGain == INVALID_VALUE || mVibraFd == INVALID_VALUE)
+        return;
+
+    if (writeEvents(NULL, 0) == -1)
+        ALOGE("write FF_GAIN failed, errno = %d", -errno);
+}
+
+InputFFDevice::GainStats InputFFDevice::getGainStats() {
+    return mGainStats;
+}
+
+int InputFFDevice::setAmplitude(uint8_t amplitude) {
+    int tmp;
+
+    mGainStats.calls++;
+
+    /* For QMAA compliance, return OK even if vibrator device doesn't exist */
+    if (mVibraFd == INVALID_VALUE)
+        return 0;
+
+    tmp = amplitude * (STRONG_MAGNITUDE - LIGHT_MAGNITUDE) / 255;
+    tmp += LIGHT_MAGNITUDE;
+
+    mCurrMagnitude = tmp;
+    mCurrGain = tmp;
+    return queueGain(tmp);
+}
+
+int InputFFDevice::playEffect(int effectId, EffectStrength es, long *playLengthMs) {
+    EffectSlot *slot;
+
+    switch (es) {
+    case EffectStrength::LIGHT:
+        mCurrMagnitude = LIGHT_MAGNITUDE;
+        break;
+    case EffectStrength::MEDIUM:
+        mCurrMagnitude = MEDIUM_MAGNITUDE;
+        break;
+    case EffectStrength::STRONG:
+        mCurrMagnitude = STRONG_MAGNITUDE;
+        break;
+    default:
+        return -1;
+    }
+
+    slot = findSlot(effectId, es);
+    if (mVibraFd != INVALID_VALUE && slot != NULL)
+        return playSlot(slot, INVALID_VALUE, playLengthMs);
+
+    return play(effectId, INVALID_VALUE, playLengthMs);
+}
+
+/* Play one step of a composition with its own gain applied */
+int InputFFDevice::playPrimitive(int effectId, EffectStrength es, int16_t gain) {
+    EffectSlot *slot;
+
+    if (mVibraFd == INVALID_VALUE)
+        return 0;
+
+    slot = findSlot(effectId, es);
+    if (slot == NULL)
+        return -1;
+
+    return playSlot(slot, mSupportGain ? gain : INVALID_VALUE, NULL);
+}
+
+/** Play a raw waveform through the chip backend
+ *
+ *  @samples are signed 8 bit PCM at getStreamRateHz(). Whatever is playing is
+ *  stopped first, the waveform plays until it ends or the next play or off().
+ *  Chips with a streaming interface get it written there, otherwise it is
+ *  uploaded as a one-shot custom effect and played like any other.
+ */
+int InputFFDevice::streamWaveform(const int8_t *samples, size_t count) {
+    struct ff_effect effect;
+    int ret;
+
+    if (mVibraFd == INVALID_VALUE || !mSupportStreaming)
+        return -1;
+
+    ret = stopCurrent();
+    if (ret != 0)
+        return ret;
+
+    if (mBackend->canStream()) {
+        ret = mBackend->stream(samples, count);
+        mStreaming = ret == 0;
+        return ret;
+    }
+
+    memset(&effect, 0, sizeof(effect));
+    mBackend->customEffect(&effect, samples, count);
+    effect.id = INVALID_VALUE;
+    effect.u.periodic.magnitude = STRONG_MAGNITUDE;
+
+    do {
+        ret = uploadEffect(&effect);
+    } while (ret == -1 && errno == ENOSPC && evictLruSlot());
+    if (ret == -1) {
+        ALOGE("ioctl EVIOCSFF failed, errno = %d", -errno);
+        return ret;
+    }
+
+    mCurrAppId = effect.id;
+    mCurrAppIdResident = false;
+    memset(mStaged, 0, sizeof(mStaged));
+    mStaged[0].type = EV_FF;
+    mStaged[0].code = mCurrAppId;
+    mStaged[0].value = 1;
+    mStagedCount = 1;
+
+    return mSyncHold ? 0 : fireStaged();
+}
+
+int InputFFDevice::stopStream() {
+    if (!mStreaming)
+        return 0;
+
+    mStreaming = false;
+    return mBackend->stopStream();
+}
+
+int32_t InputFFDevice::getStreamRateHz() {
+    if (!mBackend)
+        return 0;
+
+    return mBackend->canStream() ? mBackend->streamRateHz() : mBackend->customRateHz();
+}
+
+int32_t InputFFDevice::getResonantHz() {
+    return mBackend ? mBackend->resonantHz() : 0;
+}
+
+/* Put back the gain set through setAmplitude() after a composition changed it */
+int InputFFDevice::restoreGain() {
+    int32_t gain = mCurrGain != INVALID_VALUE ? mCurrGain : STRONG_MAGNITUDE;
+
+    if (mVibraFd == INVALID_VALUE || !mSupportGain)
+        return 0;
+
+    /* Left pending so it rides along with the next play or the idle flush */
+    mPendingGain = gain != mWrittenGain ? gain : INVALID_VALUE;
+    return 0;
+}
+
+/* Returns the play length the driver reported for an uploaded effect, or -1 */
+long InputFFDevice::getPlayLengthMs(int effectId, EffectStrength es) {
+    EffectSlot *slot = findSlot(effectId, es);
+
+    if (slot == NULL || (slot->id == INVALID_VALUE && slot->playLengthMs <= 0))
+        return INVALID_VALUE;
+
+    return slot->playLengthMs;
+}
+
+InputFFDevice::AlwaysOnSlot *InputFFDevice::findAlwaysOn(int32_t id) {
+    for (auto& entry : mAlwaysOnSlots) {
+        if (entry.id == id)
+            return &entry;
+    }
+
+    return NULL;
+}
+
+/** Pin an effect to an always-on ID
+ *
+ *  The effect gets its own driver slot that LRU eviction never touches, so a
+ *  trigger is a single EV_FF write. Enabling the same effect again is a no-op.
+ *  While the device is gone the entry is only recorded and it is uploaded
+ *  together with the other effects once the device comes back. Drivers that
+ *  latch effects on upload get it uploaded on every trigger instead.
+ */
+int InputFFDevice::alwaysOnEnable(int32_t id, int effectId, EffectStrength es) {
+    AlwaysOnSlot *entry = findAlwaysOn(id);
+    int ret;
+
+    if (strengthToMagnitude(es) == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (entry == NULL) {
+        mAlwaysOnSlots.push_back({id, {effectId, es, INVALID_VALUE, 0, 0}});
+        entry = &mAlwaysOnSlots.back();
+    } else if (entry->slot.effectId != effectId || entry->slot.strength != es) {
+        ret = releaseSlot(&entry->slot);
+        if (ret != 0)
+            return ret;
+        entry->slot.effectId = effectId;
+        entry->slot.strength = es;
+    }
+
+    if (entry->slot.id != INVALID_VALUE || mVibraFd == INVALID_VALUE || !mSupportEffects ||
+            mMaxResident == 0)
+        return 0;
+
+    ret = uploadSlot(&entry->slot, true);
+    if (ret != 0)
+        mAlwaysOnSlots.erase(mAlwaysOnSlots.begin() + (entry - mAlwaysOnSlots.data()));
+
+    return ret;
+}
+
+int InputFFDevice::alwaysOnDisable(int32_t id) {
+    AlwaysOnSlot *entry = findAlwaysOn(id);
+    int ret;
+
+    if (entry == NULL)
+        return 0;
+
+    ret = releaseSlot(&entry->slot);
+    if (ret != 0)
+        return ret;
+
+    mAlwaysOnSlots.erase(mAlwaysOnSlots.begin() + (entry - mAlwaysOnSlots.data()));
+    return 0;
+}
+
+/* Play the effect pinned to an always-on ID, -ENOENT if it isn't enabled */
+int InputFFDevice::alwaysOnTrigger(int32_t id, long *playLengthMs) {
+    AlwaysOnSlot *entry = findAlwaysOn(id);
+
+    if (entry == NULL)
+        return -ENOENT;
+
     if (mVibraFd == INVALID_VALUE) {
         if (playLengthMs != NULL)
             *playLengthMs = 0;
-            return 0;
+        return 0;
     }
 
-    if (timeoutMs != 0) {
-        if (mCurrAppId != INVALID_VALUE) {
-            ret = TEMP_FAILURE_RETRY(ioctl(mVibraFd, EVIOCRMFF, mCurrAppId));
-            if (ret == -1) {
-                ALOGE("ioctl EVIOCRMFF failed, errno = %d", -errno);
-                goto errout;
-            }
-            mCurrAppId = INVALID_VALUE;
-        }
+    mCurrMagnitude = strengthToMagnitude(entry->slot.strength);
+    return playSlot(&entry->slot, INVALID_VALUE, playLengthMs);
+}
 
-        memset(&effect, 0, sizeof(effect));
-        if (effectId != INVALID_VALUE) {
-            data[0] = effectId;
-            effect.type = FF_PERIODIC;
-            effect.u.periodic.waveform = FF_CUSTOM;
-            effect.u.periodic.magnitude = mCurrMagnitude;
-            effect.u.periodic.custom_data = data;
-            effect.u.periodic.custom_len = sizeof(int16_t) * CUSTOM_DATA_LEN;
-        } else {
-            effect.type = FF_CONSTANT;
-            effect.u.constant.level = mCurrMagnitude;
-            effect.replay.length = timeoutMs;
-        }
+/* Only called from the device worker thread */
+void InputFFDevice::dump(int fd) {
+    int resident = residentSlots();
+
+    dprintf(fd, "Device:\n");
+    dprintf(fd, "  path: %s (%s)\n", mDevicePath.empty() ? "none" : mDevicePath.c_str(),
+            mVibraFd == INVALID_VALUE ? "closed" : "open");
+    dprintf(fd, "  gain: %d effects: %d external control: %d (active %d)\n",
+            mSupportGain.load(), mSupportEffects.load(), mSupportExternalControl.load(),
+            mInExternalControl.load());
+    dprintf(fd, "  resident effects: %d/%zu (driver budget %d)\n", resident,
+            mEffectSlots.size(), mMaxResident == INT_MAX ? -1 : mMaxResident);
+    for (const auto& entry : mAlwaysOnSlots)
+        dprintf(fd, "  always-on %d: effect %d strength %d slot %d\n", entry.id,
+                entry.slot.effectId, static_cast<int>(entry.slot.strength), entry.slot.id);
+    dprintf(fd, "  current effect: %d%s magnitude: 0x%x\n", mCurrAppId,
+            mCurrAppIdResident ? " (resident)" : "", mCurrMagnitude);
+    dprintf(fd, "  gain written: %d pending: %d\n", mWrittenGain, mPendingGain);
+    dprintf(fd, "  discovery: %" PRId64 "us\n", mDiscoveryUs);
+    if (mBackend)
+        mBackend->dump(fd);
+    dprintf(fd, "Gain updates:\n");
+    dprintf(fd, "  calls=%" PRIu64 " writes=%" PRIu64 " deduplicated=%" PRIu64 " deferred=%"
+            PRIu64 " batched=%" PRIu64 "\n", mGainStats.calls, mGainStats.writes,
+            mGainStats.deduplicated, mGainStats.deferred, mGainStats.batched);
+    dprintf(fd, "Driver ioctls:\n");
+    mUploadLatency.dump(fd, "EVIOCSFF");
+    mEraseLatency.dump(fd, "EVIOCRMFF");
+    mWriteLatency.dump(fd, "write");
+    dprintf(fd, "Errors:\n");
+    mErrors.dump(fd);
+}
 
-        effect.id = mCurrAppId;
-        effect.replay.delay = 0;
+/* Synthesizer parameters of @shape played for @durationMs at @scale */
+static WaveformParams shapeParams(const SynthShape& shape, int32_t durationMs, float scale,
+                                  int32_t rateHz, int32_t resonantHz) {
+    float amp = roundf(scale * SYNTH_SCALE_STEPS) / SYNTH_SCALE_STEPS;
+
+    return {
+        .rateHz = rateHz,
+        .durationMs = durationMs,
+        .attackMs = std::min(shape.attackMs, durationMs),
+        .decayMs = std::min(shape.decayMs, durationMs),
+        .startHz = shape.startRatio * resonantHz,
+        .endHz = shape.endRatio * resonantHz,
+        .startAmp = shape.startAmp * amp,
+        .endAmp = shape.endAmp * amp,
+    };
+}
 
-        ret = TEMP_FAILURE_RETRY(ioctl(mVibraFd, EVIOCSFF, &effect));
-        if (ret == -1) {
-            ALOGE("ioctl EVIOCSFF failed, errno = %d", -errno);
-            goto errout;
-        }
+static const SynthShape *findPrimitiveShape(CompositePrimitive primitive) {
+    for (const auto& entry : kPrimitiveShapes) {
+        if (entry.primitive == primitive)
+            return &entry.shape;
+    }
 
-        mCurrAppId = effect.id;
-        if (effectId != INVALID_VALUE && playLengthMs != NULL) {
-            *playLengthMs = data[1] * 1000 + data[2];
-        }
+    return NULL;
+}
 
-        play.value = 1;
-        play.type = EV_FF;
-        play.code = mCurrAppId;
-        play.time.tv_sec = 0;
-        play.time.tv_usec = 0;
-        ret = TEMP_FAILURE_RETRY(write(mVibraFd, (const void*)&play, sizeof(play)));
-        if (ret == -1) {
-            ALOGE("write failed, errno = %d\n", -errno);
-            ret = TEMP_FAILURE_RETRY(ioctl(mVibraFd, EVIOCRMFF, mCurrAppId));
-            if (ret == -1)
-                ALOGE("ioctl EVIOCRMFF failed, errno = %d", -errno);
-            goto errout;
-        }
-    } else if (mCurrAppId != INVALID_VALUE) {
-        ret = TEMP_FAILURE_RETRY(ioctl(mVibraFd, EVIOCRMFF, mCurrAppId));
-        if (ret == -1) {
-            ALOGE("ioctl EVIOCRMFF failed, errno = %d", -errno);
-            goto errout;
-        }
-        mCurrAppId = INVALID_VALUE;
+static const SynthShape *findSynthEffect(Effect effect) {
+    for (const auto& entry : kSynthEffects) {
+        if (entry.effect == effect)
+            return &entry.shape;
     }
-    return 0;
 
-errout:
-    mCurrAppId = INVALID_VALUE;
-    return ret;
+    return NULL;
 }
 
-int InputFFDevice::on(int32_t timeoutMs) {
-    return play(INVALID_VALUE, timeoutMs, NULL);
-}
+/* A primitive of a composition that is streamed as a single waveform */
+struct StreamBurst {
+    int64_t startUs;
+    int32_t durationMs;
+    float scale;
+    const SynthShape *shape;
+};
 
-int InputFFDevice::off() {
-    return play(INVALID_VALUE, 0, NULL);
-}
+static const char *kFodUiPaths[] = {
+    "/sys/devices/platform/soc/soc:qcom,dsi-display-primary/fod_ui",
+    "/sys/devices/platform/soc/soc:qcom,dsi-display/fod_ui",
+};
 
-int InputFFDevice::setAmplitude(uint8_t amplitude) {
-    int tmp, ret;
-    struct input_event ie;
+Vibrator::Vibrator() : Vibrator(0, "") {}
 
-    /* For QMAA compliance, return OK even if vibrator device doesn't exist */
-    if (mVibraFd == INVALID_VALUE)
+/** Create the vibrator for one actuator
+ *
+ *  @id 0 is the default vibrator, it picks the primary haptics device when
+ *  @devicePath is empty and owns the trace.
+ */
+Vibrator::Vibrator(int32_t id, const std::string& devicePath)
+    : ff(devicePath),
+      mId(id),
+      mWorker(ff),
+      mComposer(mWorker),
+      mFodWatch(INVALID_VALUE),
+      mFodDown(false),
+      mSyncPrepared(false),
+      mSyncDurationMs(0) {
+    const EffectStrength strengths[] = {EffectStrength::STRONG, EffectStrength::MEDIUM,
+                                        EffectStrength::LIGHT};
+    std::vector<Effect> effects;
+    int64_t startNs = nowNs();
+
+    sDebugLogging = property_get_bool("persist.vendor.vibrator.debug", false);
+    if (mId == 0 && property_get_bool("persist.vendor.vibrator.trace", false))
+        mTrace.open(TRACE_PATH);
+
+    effects.assign(std::begin(kDriverEffects), std::end(kDriverEffects));
+    mWorker.run([&](InputFFDevice& dev) {
+        dev.loadEffects(effects);
         return 0;
+    });
+    mPreloadUs = (nowNs() - startNs) / 1000;
+    ALOGI("vibrator usable after %" PRId64 " us (discovery %" PRId64 " us, preload %" PRId64
+          " us)", ff.mDiscoveryUs + mPreloadUs, ff.mDiscoveryUs, mPreloadUs);
+
+    mDiscovery.startWatching([this](const std::string& devicePath, bool added) {
+        mWorker.run([&](InputFFDevice& dev) {
+            dev.onHotplug(devicePath, added);
+            return 0;
+        });
+    });
 
-    tmp = amplitude * (STRONG_MAGNITUDE - LIGHT_MAGNITUDE) / 255;
-    tmp += LIGHT_MAGNITUDE;
-    ie.type = EV_FF;
-    ie.code = FF_GAIN;
-    ie.value = tmp;
+    if (!ff.mSupportEffects)
+        return;
 
-    ret = TEMP_FAILURE_RETRY(write(mVibraFd, &ie, sizeof(ie)));
-    if (ret == -1) {
-        ALOGE("write FF_GAIN failed, errno = %d", -errno);
-        return ret;
+    if (mId == 0)
+        watchFodUi();
+
+    /* Primitive durations are the play lengths the driver reported on upload */
+    for (const auto& entry : kPrimitiveEffects) {
+        long playLengthMs = INVALID_VALUE;
+
+        for (auto es : strengths) {
+            mWorker.run([&](InputFFDevice& dev) {
+                playLengthMs = dev.getPlayLengthMs(static_cast<int>(entry.effect), es);
+                return 0;
+            });
+            if (playLengthMs >= 0)
+                break;
+        }
+
+        if (playLengthMs < 0) {
+            ALOGW("no play length for primitive %d, not supported",
+                  static_cast<int>(entry.primitive));
+            continue;
+        }
+
+        PrimitiveInfo info = {entry.primitive, static_cast<int>(entry.effect),
+                              static_cast<int32_t>(playLengthMs)};
+        mPrimitives.push_back(info);
     }
+}
 
-    mCurrMagnitude = tmp;
-    return 0;
+Vibrator::~Vibrator() {
+    if (mFodWatch != INVALID_VALUE)
+        xiaomi::Sysfs::getInstance().unwatch(mFodWatch);
 }
 
-int InputFFDevice::playEffect(int effectId, EffectStrength es, long *playLengthMs) {
-    switch (es) {
-    case EffectStrength::LIGHT:
-        mCurrMagnitude = LIGHT_MAGNITUDE;
-        break;
-    case EffectStrength::MEDIUM:
-        mCurrMagnitude = MEDIUM_MAGNITUDE;
-        break;
-    case EffectStrength::STRONG:
-        mCurrMagnitude = STRONG_MAGNITUDE;
-        break;
-    default:
-        return -1;
+/** Trigger the always-on effect of a finger landing on the sensor
+ *
+ *  The display driver notifies fod_ui when it shows the pressed FOD icon,
+ *  which is the first the vendor side learns about a fingerprint touch. The
+ *  effect is played from the sysfs watch thread, without a binder round trip.
+ */
+void Vibrator::watchFodUi() {
+    for (auto path : kFodUiPaths) {
+        if (access(path, R_OK) != 0)
+            continue;
+
+        mFodWatch = xiaomi::Sysfs::getInstance().watch(path, [this](const std::string& value) {
+            bool down = value == "1";
+            int ret;
+
+            if (down && !mFodDown) {
+                ret = triggerAlwaysOn(ALWAYS_ON_FOD_ID);
+                if (ret != 0 && ret != -ENOENT)
+                    ALOGE("failed to trigger always-on %d, ret = %d", ALWAYS_ON_FOD_ID, ret);
+            }
+            mFodDown = down;
+        });
+        if (mFodWatch != INVALID_VALUE)
+            mFodUiPath = path;
+        return;
     }
+}
 
-    return play(effectId, INVALID_VALUE, playLengthMs);
+const Vibrator::PrimitiveInfo *Vibrator::findPrimitive(CompositePrimitive primitive) {
+    for (const auto& info : mPrimitives) {
+        if (info.primitive == primitive)
+            return &info;
+    }
+
+    return NULL;
+}
+
+static int32_t floatBits(float value) {
+    int32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
 }
 
 ndk::ScopedAStatus Vibrator::getCapabilities(int32_t* _aidl_return) {
@@ -311,21 +1278,30 @@ ndk::ScopedAStatus Vibrator::getCapabilities(int32_t* _aidl_return) {
         *_aidl_return |= IVibrator::CAP_AMPLITUDE_CONTROL;
     if (ff.mSupportEffects)
         *_aidl_return |= IVibrator::CAP_PERFORM_CALLBACK;
-    if (ff.mSupportExternalControl)
+    if (ff.mSupportExternalControl && mId == 0)
         *_aidl_return |= IVibrator::CAP_EXTERNAL_CONTROL;
+    if (!mPrimitives.empty())
+        *_aidl_return |= IVibrator::CAP_COMPOSE_EFFECTS;
+    if (mFodWatch != INVALID_VALUE)
+        *_aidl_return |= IVibrator::CAP_ALWAYS_ON_CONTROL;
 
-    ALOGD("QTI Vibrator reporting capabilities: %d", *_aidl_return);
+    DEBUG_LOGD("QTI Vibrator reporting capabilities: %d", *_aidl_return);
     return ndk::ScopedAStatus::ok();
 }
 
 ndk::ScopedAStatus Vibrator::off() {
     int ret;
 
-    ALOGD("QTI Vibrator off");
+    ScopedLatency latency(mOffLatency);
+    ScopedTrace trace(mTrace, TRACE_OFF);
 
-    ret = ff.off();
+    DEBUG_LOGD("QTI Vibrator off");
+
+    mComposer.stop();
+    ret = mWorker.off();
+    mCompletion.cancel();
     if (ret != 0)
-        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_SERVICE_SPECIFIC));
+        return trace.status(EX_SERVICE_SPECIFIC);
 
     return ndk::ScopedAStatus::ok();
 }
@@ -334,59 +1310,83 @@ ndk::ScopedAStatus Vibrator::on(int32_t timeoutMs,
                                 const std::shared_ptr<IVibratorCallback>& callback) {
     int ret;
 
-    ALOGD("Vibrator on for timeoutMs: %d", timeoutMs);
+    ScopedLatency latency(mOnLatency);
+    ScopedTrace trace(mTrace, TRACE_ON, timeoutMs);
 
-    ret = ff.on(timeoutMs);
-    if (ret != 0)
-        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_SERVICE_SPECIFIC));
+    DEBUG_LOGD("Vibrator on for timeoutMs: %d", timeoutMs);
 
-    if (callback != nullptr) {
-        std::thread([=] {
-            ALOGD("Starting on on another thread");
-            usleep(timeoutMs * 1000);
-            ALOGD("Notifying on complete");
-            if (!callback->onComplete().isOk()) {
-                ALOGE("Failed to call onComplete");
-            }
-        }).detach();
+    mComposer.stop();
+    ret = mWorker.on(timeoutMs);
+    if (ret != 0) {
+        mCompletion.cancel();
+        return trace.status(EX_SERVICE_SPECIFIC);
     }
 
+    if (mSyncPrepared)
+        stageSynced(callback, timeoutMs);
+    else
+        mCompletion.schedule(callback, timeoutMs);
+
     return ndk::ScopedAStatus::ok();
 }
 
 ndk::ScopedAStatus Vibrator::perform(Effect effect, EffectStrength es, const std::shared_ptr<IVibratorCallback>& callback, int32_t* _aidl_return) {
+    const SynthShape *shape = NULL;
     long playLengthMs;
     int ret;
 
-    ALOGD("Vibrator perform effect %d", effect);
+    ScopedLatency latency(mPerformLatency);
+    ScopedTrace trace(mTrace, TRACE_PERFORM, static_cast<int32_t>(effect),
+                      static_cast<int32_t>(es));
+
+    DEBUG_LOGD("Vibrator perform effect %d", effect);
 
     if (effect < Effect::CLICK ||
-            effect > Effect::HEAVY_CLICK)
-        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+            effect > Effect::HEAVY_CLICK) {
+        shape = findSynthEffect(effect);
+        if (shape == NULL || !ff.mSupportStreaming)
+            return trace.status(EX_UNSUPPORTED_OPERATION);
+        /* Streamed waveforms can't be held back for a synced trigger */
+        if (mSyncPrepared)
+            return trace.status(EX_ILLEGAL_STATE);
+    }
 
     if (es != EffectStrength::LIGHT && es != EffectStrength::MEDIUM && es != EffectStrength::STRONG)
-        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
-
-    ret = ff.playEffect((static_cast<int>(effect)), es, &playLengthMs);
-    if (ret != 0)
-        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_SERVICE_SPECIFIC));
-
-    if (callback != nullptr) {
-        std::thread([=] {
-            ALOGD("Starting perform on another thread");
-            usleep(playLengthMs * 1000);
-            ALOGD("Notifying perform complete");
-            callback->onComplete();
-        }).detach();
+        return trace.status(EX_UNSUPPORTED_OPERATION);
+
+    mComposer.stop();
+    if (shape != NULL) {
+        playLengthMs = shape->durationMs;
+        ret = mWorker.run([&](InputFFDevice& dev) {
+            WaveformSynth::Waveform waveform = mSynth.render(
+                    shapeParams(*shape, shape->durationMs,
+                                (float)strengthToMagnitude(es) / STRONG_MAGNITUDE,
+                                dev.getStreamRateHz(), dev.getResonantHz()));
+            return dev.streamWaveform(waveform->data(), waveform->size());
+        });
+    } else {
+        ret = mWorker.playEffect((static_cast<int>(effect)), es, &playLengthMs);
     }
+    if (ret != 0) {
+        mCompletion.cancel();
+        return trace.status(EX_SERVICE_SPECIFIC);
+    }
+
+    if (mSyncPrepared)
+        stageSynced(callback, playLengthMs);
+    else
+        mCompletion.schedule(callback, playLengthMs);
 
     *_aidl_return = playLengthMs;
     return ndk::ScopedAStatus::ok();
 }
 
 ndk::ScopedAStatus Vibrator::getSupportedEffects(std::vector<Effect>* _aidl_return) {
-    *_aidl_return = {Effect::CLICK, Effect::DOUBLE_CLICK, Effect::TICK, Effect::THUD,
-                     Effect::POP, Effect::HEAVY_CLICK};
+    _aidl_return->assign(std::begin(kDriverEffects), std::end(kDriverEffects));
+    if (ff.mSupportStreaming) {
+        for (const auto& entry : kSynthEffects)
+            _aidl_return->push_back(entry.effect);
+    }
 
     return ndk::ScopedAStatus::ok();
 }
@@ -395,68 +1395,399 @@ ndk::ScopedAStatus Vibrator::setAmplitude(float amplitude) {
     uint8_t tmp;
     int ret;
 
-    ALOGD("Vibrator set amplitude: %f", amplitude);
+    ScopedLatency latency(mAmplitudeLatency);
+    ScopedTrace trace(mTrace, TRACE_SET_AMPLITUDE, floatBits(amplitude));
+
+    DEBUG_LOGD("Vibrator set amplitude: %f", amplitude);
 
     if (amplitude <= 0.0f || amplitude > 1.0f)
-        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_ILLEGAL_ARGUMENT));
+        return trace.status(EX_ILLEGAL_ARGUMENT);
 
     if (ff.mInExternalControl)
-        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+        return trace.status(EX_UNSUPPORTED_OPERATION);
 
     tmp = (uint8_t)(amplitude * 0xff);
-    ret = ff.setAmplitude(tmp);
+    ret = mWorker.setAmplitude(tmp);
     if (ret != 0)
-        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_SERVICE_SPECIFIC));
+        return trace.status(EX_SERVICE_SPECIFIC);
 
     return ndk::ScopedAStatus::ok();
 }
 
 ndk::ScopedAStatus Vibrator::setExternalControl(bool enabled) {
-    ALOGD("Vibrator set external control: %d", enabled);
-    if (!ff.mSupportExternalControl)
-        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+    ScopedTrace trace(mTrace, TRACE_SET_EXTERNAL_CONTROL, enabled);
+
+    DEBUG_LOGD("Vibrator set external control: %d", enabled);
+    if (!ff.mSupportExternalControl || mId != 0)
+        return trace.status(EX_UNSUPPORTED_OPERATION);
+
+    if (enabled) {
+        mComposer.stop();
+        mCompletion.cancel();
+    }
 
     ff.mInExternalControl = enabled;
     return ndk::ScopedAStatus::ok();
 }
 
-ndk::ScopedAStatus Vibrator::getCompositionDelayMax(int32_t* maxDelayMs  __unused) {
+ndk::ScopedAStatus Vibrator::getCompositionDelayMax(int32_t* maxDelayMs) {
+    if (mPrimitives.empty())
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+
+    *maxDelayMs = COMPOSE_DELAY_MAX_MS;
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Vibrator::getCompositionSizeMax(int32_t* maxSize) {
+    if (mPrimitives.empty())
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+
+    *maxSize = COMPOSE_SIZE_MAX;
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Vibrator::getSupportedPrimitives(std::vector<CompositePrimitive>* supported) {
+    if (mPrimitives.empty())
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+
+    *supported = {CompositePrimitive::NOOP};
+    for (const auto& info : mPrimitives)
+        supported->push_back(info.primitive);
+
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Vibrator::getPrimitiveDuration(CompositePrimitive primitive,
+                                                  int32_t* durationMs) {
+    const PrimitiveInfo *info;
+
+    if (primitive == CompositePrimitive::NOOP) {
+        *durationMs = 0;
+        return ndk::ScopedAStatus::ok();
+    }
+
+    info = findPrimitive(primitive);
+    if (info == NULL)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+
+    *durationMs = info->durationMs;
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Vibrator::compose(const std::vector<CompositeEffect>& composite,
+                                     const std::shared_ptr<IVibratorCallback>& callback) {
+    std::vector<CompositionPlayer::Step> timeline;
+    std::vector<StreamBurst> bursts;
+    int64_t timeUs = 0;
+    int ret;
+
+    ScopedLatency latency(mComposeLatency);
+
+    DEBUG_LOGD("Vibrator compose %zu primitives", composite.size());
+
+    if (mPrimitives.empty())
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+
+    /* Compositions can't be part of a synced trigger */
+    if (mSyncPrepared)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_ILLEGAL_STATE));
+
+    if (composite.size() > COMPOSE_SIZE_MAX)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_ILLEGAL_ARGUMENT));
+
+    /* Precompute the start offset, strength and gain of every primitive */
+    for (const auto& e : composite) {
+        CompositionPlayer::Step step;
+        const PrimitiveInfo *info = NULL;
+
+        if (e.delayMs < 0 || e.delayMs > COMPOSE_DELAY_MAX_MS)
+            return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_ILLEGAL_ARGUMENT));
+        if (e.scale < 0.0f || e.scale > 1.0f)
+            return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_ILLEGAL_ARGUMENT));
+
+        if (e.primitive != CompositePrimitive::NOOP) {
+            info = findPrimitive(e.primitive);
+            if (info == NULL)
+                return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+        }
+
+        timeUs += e.delayMs * 1000LL;
+        step.startUs = timeUs;
+        step.effectId = info ? info->effectId : INVALID_VALUE;
+        if (ff.mSupportGain) {
+            /* Full strength effect scaled down through FF_GAIN */
+            step.strength = EffectStrength::STRONG;
+            step.gain = (int16_t)(e.scale * STRONG_MAGNITUDE);
+        } else {
+            step.strength = e.scale < 0.34f ? EffectStrength::LIGHT :
+                            e.scale < 0.67f ? EffectStrength::MEDIUM : EffectStrength::STRONG;
+            step.gain = STRONG_MAGNITUDE;
+        }
+        timeline.push_back(step);
+
+        if (info) {
+            bursts.push_back({timeUs, info->durationMs, e.scale,
+                              findPrimitiveShape(e.primitive)});
+            timeUs += info->durationMs * 1000LL;
+        }
+    }
+
+    /* Hold the timeline until the last primitive has finished */
+    timeline.push_back({timeUs, INVALID_VALUE, EffectStrength::STRONG, STRONG_MAGNITUDE});
+
+    mComposer.stop();
+
+    /* Long compositions go down as a single waveform instead of one play per step */
+    if (ff.mSupportStreaming && bursts.size() >= COMPOSE_STREAM_MIN_SIZE &&
+            timeUs <= COMPOSE_STREAM_MAX_MS * 1000LL) {
+        ret = mWorker.run([&](InputFFDevice& dev) {
+            int32_t rateHz = dev.getStreamRateHz();
+            std::vector<int8_t> samples(timeUs * rateHz / 1000000, 0);
+
+            /* Primitives never overlap, each one is copied into its place */
+            for (const auto& burst : bursts) {
+                size_t start = std::min<size_t>(burst.startUs * rateHz / 1000000,
+                                                samples.size());
+                WaveformSynth::Waveform waveform = mSynth.render(
+                        shapeParams(*burst.shape, burst.durationMs, burst.scale, rateHz,
+                                    dev.getResonantHz()));
+                size_t len = std::min(waveform->size(), samples.size() - start);
+
+                memcpy(samples.data() + start, waveform->data(), len);
+            }
+            return dev.streamWaveform(samples.data(), samples.size());
+        });
+        if (ret == 0) {
+            mCompletion.schedule(callback, timeUs / 1000);
+            return ndk::ScopedAStatus::ok();
+        }
+        ALOGW("failed to stream composition, playing it step by step");
+    }
+
+    ret = mWorker.off();
+    if (ret != 0) {
+        mCompletion.cancel();
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_SERVICE_SPECIFIC));
+    }
+
+    mComposer.play(std::move(timeline));
+    mCompletion.schedule(callback, timeUs / 1000);
+
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Vibrator::getSupportedAlwaysOnEffects(std::vector<Effect>* _aidl_return) {
+    if (mFodWatch == INVALID_VALUE)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+
+    _aidl_return->assign(std::begin(kDriverEffects), std::end(kDriverEffects));
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Vibrator::alwaysOnEnable(int32_t id, Effect effect, EffectStrength strength) {
+    int ret;
+
+    DEBUG_LOGD("Vibrator always-on %d enable effect %d strength %d", id,
+               static_cast<int>(effect), static_cast<int>(strength));
+
+    if (mFodWatch == INVALID_VALUE)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+
+    if (id != ALWAYS_ON_FOD_ID)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_ILLEGAL_ARGUMENT));
+
+    if (effect < Effect::CLICK || effect > Effect::HEAVY_CLICK)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+
+    if (strength != EffectStrength::LIGHT && strength != EffectStrength::MEDIUM &&
+            strength != EffectStrength::STRONG)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+
+    ret = mWorker.run([&](InputFFDevice& dev) {
+        return dev.alwaysOnEnable(id, static_cast<int>(effect), strength);
+    });
+    if (ret != 0)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_SERVICE_SPECIFIC));
+
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Vibrator::alwaysOnDisable(int32_t id) {
+    int ret;
+
+    DEBUG_LOGD("Vibrator always-on %d disable", id);
+
+    if (mFodWatch == INVALID_VALUE)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+
+    if (id != ALWAYS_ON_FOD_ID)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_ILLEGAL_ARGUMENT));
+
+    ret = mWorker.run([id](InputFFDevice& dev) {
+        return dev.alwaysOnDisable(id);
+    });
+    if (ret != 0)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_SERVICE_SPECIFIC));
+
+    return ndk::ScopedAStatus::ok();
+}
+
+/* The driver exposes no frequency control, so none of the PWLE API is supported */
+ndk::ScopedAStatus Vibrator::getResonantFrequency(float* resonantFreqHz __unused) {
+    return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
+}
+
+ndk::ScopedAStatus Vibrator::getQFactor(float* qFactor __unused) {
     return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
 }
 
-ndk::ScopedAStatus Vibrator::getCompositionSizeMax(int32_t* maxSize __unused) {
+ndk::ScopedAStatus Vibrator::getFrequencyResolution(float* freqResolutionHz __unused) {
     return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
 }
 
-ndk::ScopedAStatus Vibrator::getSupportedPrimitives(std::vector<CompositePrimitive>* supported __unused) {
+ndk::ScopedAStatus Vibrator::getFrequencyMinimum(float* freqMinimumHz __unused) {
     return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
 }
 
-ndk::ScopedAStatus Vibrator::getPrimitiveDuration(CompositePrimitive primitive __unused,
-                                                  int32_t* durationMs __unused) {
+ndk::ScopedAStatus Vibrator::getBandwidthAmplitudeMap(std::vector<float>* _aidl_return __unused) {
     return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
 }
 
-ndk::ScopedAStatus Vibrator::compose(const std::vector<CompositeEffect>& composite __unused,
-                                     const std::shared_ptr<IVibratorCallback>& callback __unused) {
+ndk::ScopedAStatus Vibrator::getPwlePrimitiveDurationMax(int32_t* durationMs __unused) {
     return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
 }
 
-ndk::ScopedAStatus Vibrator::getSupportedAlwaysOnEffects(std::vector<Effect>* _aidl_return __unused) {
+ndk::ScopedAStatus Vibrator::getPwleCompositionSizeMax(int32_t* maxSize __unused) {
     return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
 }
 
-ndk::ScopedAStatus Vibrator::alwaysOnEnable(int32_t id __unused, Effect effect __unused,
-                                            EffectStrength strength __unused) {
+ndk::ScopedAStatus Vibrator::getSupportedBraking(std::vector<Braking>* supported __unused) {
     return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
 }
 
-ndk::ScopedAStatus Vibrator::alwaysOnDisable(int32_t id __unused) {
+ndk::ScopedAStatus Vibrator::composePwle(
+        const std::vector<PrimitivePwle>& composite __unused,
+        const std::shared_ptr<IVibratorCallback>& callback __unused) {
     return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_UNSUPPORTED_OPERATION));
 }
 
+/** Play the effect enabled for an always-on ID
+ *
+ *  This is the HAL side trigger path, it doesn't go through the framework.
+ *  A vibration that is still running is superseded just like by perform().
+ *  Returns -ENOENT if no effect is enabled for @id.
+ */
+int Vibrator::triggerAlwaysOn(int32_t id) {
+    int ret;
+
+    mComposer.stop();
+    ret = mWorker.run([id](InputFFDevice& dev) {
+        return dev.alwaysOnTrigger(id, NULL);
+    });
+    mCompletion.cancel();
+
+    return ret;
+}
+
+/* Hold back on() and perform() until the manager triggers the synced plays */
+void Vibrator::prepareSynced() {
+    mComposer.stop();
+    mCompletion.cancel();
+    mWorker.run([](InputFFDevice& dev) {
+        dev.prepareSynced();
+        return 0;
+    });
+
+    std::lock_guard<std::mutex> lock(mSyncLock);
+    mSyncCallback = nullptr;
+    mSyncDurationMs = 0;
+    mSyncPrepared = true;
+}
+
+void Vibrator::stageSynced(const std::shared_ptr<IVibratorCallback>& callback,
+                           int32_t durationMs) {
+    std::lock_guard<std::mutex> lock(mSyncLock);
+
+    mSyncCallback = callback;
+    mSyncDurationMs = durationMs;
+}
+
+/* Called once the staged play was written, returns its duration */
+int32_t Vibrator::finishSynced() {
+    std::lock_guard<std::mutex> lock(mSyncLock);
+
+    mSyncPrepared = false;
+    mCompletion.schedule(mSyncCallback, mSyncDurationMs);
+    mSyncCallback = nullptr;
+    return mSyncDurationMs;
+}
+
+void Vibrator::cancelSynced() {
+    mWorker.run([](InputFFDevice& dev) {
+        dev.cancelSynced();
+        return 0;
+    });
+
+    std::lock_guard<std::mutex> lock(mSyncLock);
+    mSyncPrepared = false;
+    mSyncCallback = nullptr;
+    mSyncDurationMs = 0;
+}
+
+/** Dump HAL state and statistics
+ *
+ *  "debug 1" or "debug 0" as arguments toggle the per-call debug logging at
+ *  runtime, e.g. dumpsys android.hardware.vibrator.IVibrator/default debug 1
+ */
+binder_status_t Vibrator::dump(int fd, const char** args, uint32_t numArgs) {
+    xiaomi::Sysfs::Stats sysfs;
+    int32_t caps;
+
+    if (numArgs == 2 && !strcmp(args[0], "debug")) {
+        sDebugLogging = atoi(args[1]) != 0;
+        dprintf(fd, "debug logging %s\n", sDebugLogging ? "enabled" : "disabled");
+        return STATUS_OK;
+    }
+
+    getCapabilities(&caps);
+    dprintf(fd, "Vibrator HAL:\n");
+    dprintf(fd, "  capabilities: 0x%x debug logging: %d\n", caps, sDebugLogging.load());
+    dprintf(fd, "  preload: %" PRId64 "us\n", mPreloadUs);
+    dprintf(fd, "  always-on source: %s\n", mFodUiPath.empty() ? "none" : mFodUiPath.c_str());
+    dprintf(fd, "  trace: %s (%" PRIu64 " calls)\n", mTrace.enabled() ? TRACE_PATH : "off",
+            mTrace.count());
+    for (const auto& info : mPrimitives)
+        dprintf(fd, "  primitive %d: effect %d %dms\n", static_cast<int>(info.primitive),
+                info.effectId, info.durationMs);
+    dprintf(fd, "  worker executed=%" PRIu64 " coalesced=%" PRIu64 "\n",
+            mWorker.getExecutedCount(), mWorker.getCoalescedCount());
+    dprintf(fd, "API latency:\n");
+    mOnLatency.dump(fd, "on");
+    mOffLatency.dump(fd, "off");
+    mPerformLatency.dump(fd, "perform");
+    mAmplitudeLatency.dump(fd, "setAmplitude");
+    mComposeLatency.dump(fd, "compose");
+    mCompletion.dump(fd);
+    mSynth.dump(fd);
+
+    /* Shared by every user in the process, the backends included */
+    sysfs = xiaomi::Sysfs::getInstance().getStats();
+    dprintf(fd, "  sysfs reads: %" PRIu64 " (%" PRIu64 "us, max %" PRIu64 "us) writes: %"
+            PRIu64 " (%" PRIu64 "us, max %" PRIu64 "us) failed: %" PRIu64 " opens: %" PRIu64
+            " notifications: %" PRIu64 "\n", sysfs.reads, sysfs.readUs, sysfs.maxReadUs,
+            sysfs.writes, sysfs.writeUs, sysfs.maxWriteUs, sysfs.failed, sysfs.opens,
+            sysfs.notifications);
+
+    mWorker.run([fd](InputFFDevice& dev) {
+        dev.dump(fd);
+        return 0;
+    });
+
+    fsync(fd);
+    return STATUS_OK;
+}
+
 }  // namespace vibrator
 }  // namespace hardware
 }  // namespace android
 }  // namespace aidl
-
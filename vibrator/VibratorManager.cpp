@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "vendor.qti.vibrator"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <log/log.h>
+#include <stdio.h>
+
+#include "include/HapticsDiscovery.h"
+#include "include/Utils.h"
+#include "include/VibratorManager.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+VibratorManager::VibratorManager(std::shared_ptr<Vibrator> defaultVibrator) {
+    int32_t id = 1;
+
+    mVibrators.push_back(defaultVibrator);
+
+    /* Nodes claimed by the default vibrator fail to open and are skipped */
+    for (const auto& devicePath : HapticsDiscovery::findDevices()) {
+        if (devicePath == defaultVibrator->ff.getDevicePath())
+            continue;
+
+        auto vibrator = ndk::SharedRefBase::make<Vibrator>(id, devicePath);
+        if (vibrator->ff.getDevicePath() != devicePath) {
+            ALOGW("skipping haptics device %s", devicePath.c_str());
+            continue;
+        }
+
+        ALOGI("vibrator %d on %s", id, devicePath.c_str());
+        mVibrators.push_back(vibrator);
+        id++;
+    }
+}
+
+ndk::ScopedAStatus VibratorManager::getCapabilities(int32_t* _aidl_return) {
+    *_aidl_return = IVibratorManager::CAP_SYNC | IVibratorManager::CAP_PREPARE_ON |
+                    IVibratorManager::CAP_PREPARE_PERFORM |
+                    IVibratorManager::CAP_MIXED_TRIGGER_ON |
+                    IVibratorManager::CAP_MIXED_TRIGGER_PERFORM |
+                    IVibratorManager::CAP_TRIGGER_CALLBACK;
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus VibratorManager::getVibratorIds(std::vector<int32_t>* _aidl_return) {
+    _aidl_return->clear();
+    for (size_t i = 0; i < mVibrators.size(); i++)
+        _aidl_return->push_back(i);
+
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus VibratorManager::getVibrator(int32_t vibratorId,
+                                                std::shared_ptr<IVibrator>* _aidl_return) {
+    if (vibratorId < 0 || vibratorId >= static_cast<int32_t>(mVibrators.size()))
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_ILLEGAL_ARGUMENT));
+
+    *_aidl_return = mVibrators[vibratorId];
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus VibratorManager::prepareSynced(const std::vector<int32_t>& vibratorIds) {
+    std::lock_guard<std::mutex> lock(mLock);
+    std::vector<int32_t> ids = vibratorIds;
+
+    if (!mPrepared.empty())
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_ILLEGAL_STATE));
+
+    std::sort(ids.begin(), ids.end());
+    if (ids.empty() || std::adjacent_find(ids.begin(), ids.end()) != ids.end() ||
+            ids.front() < 0 || ids.back() >= static_cast<int32_t>(mVibrators.size()))
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_ILLEGAL_ARGUMENT));
+
+    for (auto id : ids) {
+        mVibrators[id]->prepareSynced();
+        mPrepared.push_back(mVibrators[id]);
+    }
+
+    return ndk::ScopedAStatus::ok();
+}
+
+/** Start the plays staged on the prepared vibrators
+ *
+ *  Pausing the workers up front keeps their wakeups out of the firing window,
+ *  which then only contains the writes themselves.
+ */
+ndk::ScopedAStatus VibratorManager::triggerSynced(
+        const std::shared_ptr<IVibratorCallback>& callback) {
+    std::lock_guard<std::mutex> lock(mLock);
+    int32_t durationMs = 0;
+    int64_t startNs;
+    int ret = 0;
+
+    if (mPrepared.empty())
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_ILLEGAL_STATE));
+
+    for (auto& vibrator : mPrepared)
+        vibrator->mWorker.pause();
+
+    startNs = nowNs();
+    for (auto& vibrator : mPrepared) {
+        if (vibrator->ff.triggerSynced() != 0)
+            ret = -1;
+    }
+    mSkew.record(nowNs() - startNs);
+
+    for (auto& vibrator : mPrepared)
+        vibrator->mWorker.resume();
+
+    for (auto& vibrator : mPrepared)
+        durationMs = std::max(durationMs, vibrator->finishSynced());
+    mPrepared.clear();
+
+    mCompletion.schedule(callback, durationMs);
+
+    if (ret != 0)
+        return ndk::ScopedAStatus(AStatus_fromExceptionCode(EX_SERVICE_SPECIFIC));
+
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus VibratorManager::cancelSynced() {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    for (auto& vibrator : mPrepared)
+        vibrator->cancelSynced();
+    mPrepared.clear();
+
+    return ndk::ScopedAStatus::ok();
+}
+
+binder_status_t VibratorManager::dump(int fd, const char** args __unused,
+                                      uint32_t numArgs __unused) {
+    dprintf(fd, "Vibrator manager:\n");
+    for (size_t i = 0; i < mVibrators.size(); i++)
+        dprintf(fd, "  vibrator %zu: %s\n", i, mVibrators[i]->ff.getDevicePath().c_str());
+    dprintf(fd, "Synced trigger spread:\n");
+    mSkew.dump(fd, "triggerSynced");
+    mCompletion.dump(fd);
+
+    fsync(fd);
+    return STATUS_OK;
+}
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "vendor.qti.vibrator"
+
+#include <algorithm>
+#include <inttypes.h>
+#include <log/log.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "include/WaveformSynth.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+#define SYNTH_CACHE_BYTES       (512 * 1024)
+#define SYNTH_DURATION_MAX_MS   10000
+#define SYNTH_PEAK              127.0f
+/* Ramp slope standing in for a zero length attack or decay */
+#define SYNTH_RAMP_INSTANT      1e30f
+
+static_assert(sizeof(WaveformParams) == 8 * sizeof(int32_t),
+              "WaveformParams is hashed and compared bytewise, it must not have padding");
+
+/* FNV-1a over the raw parameter bytes */
+static uint64_t hashParams(const WaveformParams& params) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&params);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < sizeof(params); i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+/*
+ * Per waveform constants of the render kernels. Sample n is at t = n * invRate,
+ * the sweep has run through t * (startHz + sweep * t) cycles by then, and the
+ * amplitude is (ampBase + ampSlope * n) * min(1, n * invAttack, (total - n) * invDecay).
+ */
+struct KernelParams {
+    float invRate;
+    float startHz;
+    float sweep;
+    float ampBase;
+    float ampSlope;
+    float invAttack;
+    float invDecay;
+    float total;
+};
+
+/* sin(2 * pi * frac) for frac in [0, 1), a refined parabola good to about 0.1% */
+static inline float sinCycle(float frac) {
+    float x = 2.0f * frac - 1.0f;
+    float y = 4.0f * x * (1.0f - fabsf(x));
+
+    /* sin(2 * pi * frac) == -sin(pi * x) */
+    return -(y + 0.225f * (y * fabsf(y) - y));
+}
+
+static inline int8_t renderSample(const KernelParams& k, size_t n) {
+    float nf = static_cast<float>(n);
+    float t = nf * k.invRate;
+    float cycles = t * (k.startHz + k.sweep * t);
+    float ramp = std::min({1.0f, nf * k.invAttack, (k.total - nf) * k.invDecay});
+    float value = (k.ampBase + k.ampSlope * nf) * ramp * sinCycle(cycles - floorf(cycles));
+
+    return static_cast<int8_t>(std::clamp(lrintf(value), -127L, 127L));
+}
+
+/* Render samples [begin, end), 8 lanes at a time where NEON is available */
+static void renderKernel(const KernelParams& k, int8_t *out, size_t begin, size_t end) {
+    size_t n = begin;
+
+#if defined(__aarch64__)
+    const float32x4_t lanes = {0.0f, 1.0f, 2.0f, 3.0f};
+    const float32x4_t one = vdupq_n_f32(1.0f);
+
+    auto render4 = [&](float32x4_t nf) {
+        float32x4_t t = vmulq_n_f32(nf, k.invRate);
+        float32x4_t cycles = vmulq_f32(t, vmlaq_n_f32(vdupq_n_f32(k.startHz), t, k.sweep));
+        float32x4_t x = vsubq_f32(vmulq_n_f32(vsubq_f32(cycles, vrndmq_f32(cycles)), 2.0f), one);
+        float32x4_t y = vmulq_f32(vmulq_n_f32(x, 4.0f), vsubq_f32(one, vabsq_f32(x)));
+        float32x4_t ramp = vminq_f32(vminq_f32(one, vmulq_n_f32(nf, k.invAttack)),
+                                     vmulq_n_f32(vsubq_f32(vdupq_n_f32(k.total), nf),
+                                                 k.invDecay));
+        float32x4_t amp = vmulq_f32(vmlaq_n_f32(vdupq_n_f32(k.ampBase), nf, k.ampSlope), ramp);
+
+        y = vmlaq_n_f32(y, vsubq_f32(vmulq_f32(y, vabsq_f32(y)), y), 0.225f);
+        return vcvtnq_s32_f32(vnegq_f32(vmulq_f32(amp, y)));
+    };
+
+    for (; n + 8 <= end; n += 8) {
+        float32x4_t nf = vaddq_f32(vdupq_n_f32(static_cast<float>(n)), lanes);
+        int16x8_t wide = vcombine_s16(vqmovn_s32(render4(nf)),
+                                      vqmovn_s32(render4(vaddq_f32(nf, vdupq_n_f32(4.0f)))));
+
+        vst1_s8(out + n, vqmovn_s16(wide));
+    }
+#endif
+
+    for (; n < end; n++)
+        out[n] = renderSample(k, n);
+}
+
+static std::vector<int8_t> renderWaveform(const WaveformParams& params) {
+    size_t count = static_cast<size_t>(params.durationMs) * params.rateHz / 1000;
+    size_t attack = static_cast<size_t>(params.attackMs) * params.rateHz / 1000;
+    size_t decay = static_cast<size_t>(params.decayMs) * params.rateHz / 1000;
+    std::vector<int8_t> samples(count);
+    float duration = params.durationMs / 1000.0f;
+    KernelParams k;
+
+    if (count == 0)
+        return samples;
+
+    k.invRate = 1.0f / params.rateHz;
+    k.startHz = params.startHz;
+    k.sweep = (params.endHz - params.startHz) / (2.0f * duration);
+    k.ampBase = SYNTH_PEAK * params.startAmp;
+    k.ampSlope = SYNTH_PEAK * (params.endAmp - params.startAmp) / count;
+    k.invAttack = attack > 0 ? 1.0f / attack : SYNTH_RAMP_INSTANT;
+    k.invDecay = decay > 0 ? 1.0f / decay : SYNTH_RAMP_INSTANT;
+    k.total = static_cast<float>(count);
+
+    renderKernel(k, samples.data(), 0, count);
+    return samples;
+}
+
+WaveformSynth::WaveformSynth() : mCachedBytes(0), mHits(0), mMisses(0), mEvictions(0) {}
+
+/** Waveform for @params, rendered on a cache miss
+ *
+ *  Returns an empty waveform for parameters that can't be rendered. Rendering
+ *  happens outside the lock, two callers missing on the same parameters at
+ *  once both render and the second result replaces the first in the cache.
+ */
+WaveformSynth::Waveform WaveformSynth::render(const WaveformParams& params) {
+    uint64_t hash = hashParams(params);
+    Waveform waveform;
+
+    if (params.rateHz <= 0 || params.durationMs < 0 ||
+            params.durationMs > SYNTH_DURATION_MAX_MS || params.attackMs < 0 ||
+            params.decayMs < 0) {
+        ALOGE("invalid waveform parameters");
+        return std::make_shared<const std::vector<int8_t>>();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = mIndex.find(hash);
+
+        if (it != mIndex.end() && !memcmp(&it->second->params, &params, sizeof(params))) {
+            mLru.splice(mLru.begin(), mLru, it->second);
+            mHits++;
+            return it->second->waveform;
+        }
+        mMisses++;
+    }
+
+    {
+        ScopedLatency latency(mRenderLatency);
+        waveform = std::make_shared<const std::vector<int8_t>>(renderWaveform(params));
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    auto it = mIndex.find(hash);
+
+    if (it != mIndex.end()) {
+        mCachedBytes -= it->second->waveform->size();
+        mLru.erase(it->second);
+        mIndex.erase(it);
+    }
+
+    mLru.push_front({hash, params, waveform});
+    mIndex[hash] = mLru.begin();
+    mCachedBytes += waveform->size();
+
+    /* The newest waveform stays even if it alone exceeds the budget */
+    while (mCachedBytes > SYNTH_CACHE_BYTES && mLru.size() > 1) {
+        mCachedBytes -= mLru.back().waveform->size();
+        mIndex.erase(mLru.back().hash);
+        mLru.pop_back();
+        mEvictions++;
+    }
+
+    return waveform;
+}
+
+void WaveformSynth::dump(int fd) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    dprintf(fd, "Waveform synth:\n");
+    dprintf(fd, "  cached: %zu waveforms, %zu/%d bytes\n", mLru.size(), mCachedBytes,
+            SYNTH_CACHE_BYTES);
+    dprintf(fd, "  hits=%" PRIu64 " misses=%" PRIu64 " evictions=%" PRIu64 "\n", mHits,
+            mMisses, mEvictions);
+    mRenderLatency.dump(fd, "render");
+}
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
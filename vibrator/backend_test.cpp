@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "HapticsBackend.h"
+
+using namespace aidl::android::hardware::vibrator;
+
+#define RTP_CHUNK_SIZE          4096
+
+/*
+ * Aw8697Backend against a temporary directory laid out like the attributes of
+ * the chip. The attributes are regular files here, so a write lands where the
+ * driver would have received it and can be read back.
+ */
+class Aw8697BackendTest : public ::testing::Test {
+protected:
+    std::string attr(const char *name) { return std::string(mDir.path) + "/" + name; }
+
+    void writeAttr(const char *name, const std::string& value) {
+        ASSERT_TRUE(android::base::WriteStringToFile(value, attr(name)));
+    }
+
+    std::string readAttr(const char *name) {
+        std::string value;
+
+        EXPECT_TRUE(android::base::ReadFileToString(attr(name), &value));
+        return value;
+    }
+
+    std::unique_ptr<HapticsBackend> create() {
+        return HapticsBackend::create("aw8697_haptic", mDir.path);
+    }
+
+    TemporaryDir mDir;
+};
+
+TEST_F(Aw8697BackendTest, StreamsInPageSizedChunks) {
+    std::vector<int8_t> samples(RTP_CHUNK_SIZE * 2 + RTP_CHUNK_SIZE / 2);
+    std::string wave;
+
+    for (size_t i = 0; i < samples.size(); i++)
+        samples[i] = static_cast<int8_t>(i * 7 + i / RTP_CHUNK_SIZE);
+
+    writeAttr("custom_wave", "");
+    auto backend = create();
+    ASSERT_TRUE(backend->canStream());
+    ASSERT_EQ(backend->stream(samples.data(), samples.size()), 0);
+
+    /*
+     * Every chunk goes to offset 0. A single oversized write would have grown
+     * the file past a page; instead the last chunk sits in front of the tail
+     * of the one before it.
+     */
+    wave = readAttr("custom_wave");
+    ASSERT_EQ(wave.size(), static_cast<size_t>(RTP_CHUNK_SIZE));
+    EXPECT_EQ(0, memcmp(wave.data(), &samples[RTP_CHUNK_SIZE * 2], RTP_CHUNK_SIZE / 2));
+    EXPECT_EQ(0, memcmp(wave.data() + RTP_CHUNK_SIZE / 2,
+                        &samples[RTP_CHUNK_SIZE + RTP_CHUNK_SIZE / 2], RTP_CHUNK_SIZE / 2));
+}
+
+TEST_F(Aw8697BackendTest, NoStreamWithoutCustomWave) {
+    int8_t sample = 0;
+
+    auto backend = create();
+    EXPECT_FALSE(backend->canStream());
+    EXPECT_EQ(backend->stream(&sample, 1), -1);
+}
+
+TEST_F(Aw8697BackendTest, ParsesF0InTenthsOfHz) {
+    writeAttr("f0_value", "1706\n");
+    EXPECT_EQ(create()->resonantHz(), 171);
+
+    writeAttr("f0_value", "2034");
+    EXPECT_EQ(create()->resonantHz(), 203);
+}
+
+TEST_F(Aw8697BackendTest, KeepsDefaultF0ForBadValues) {
+    EXPECT_EQ(create()->resonantHz(), 170);
+
+    writeAttr("f0_value", "0\n");
+    EXPECT_EQ(create()->resonantHz(), 170);
+
+    writeAttr("f0_value", "calibrating\n");
+    EXPECT_EQ(create()->resonantHz(), 170);
+}
+
+TEST_F(Aw8697BackendTest, StopWritesActivate) {
+    writeAttr("activate", "1");
+    auto backend = create();
+
+    ASSERT_EQ(backend->stopStream(), 0);
+    EXPECT_EQ(readAttr("activate"), "0");
+}
+
+TEST_F(Aw8697BackendTest, StopFailsWithoutActivate) {
+    EXPECT_EQ(create()->stopStream(), -1);
+}
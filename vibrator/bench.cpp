@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "FakeFFDevice.h"
+#include "Utils.h"
+#include "Vibrator.h"
+#include "VibratorManager.h"
+
+using namespace aidl::android::hardware::vibrator;
+
+#define DEFAULT_ITERATIONS      1000
+#define DEFAULT_CLIENTS         4
+#define SYNCED_PLAY_TIMEOUT_MS  1000
+
+static const Effect kEffects[] = {
+    Effect::CLICK, Effect::DOUBLE_CLICK, Effect::TICK, Effect::THUD, Effect::POP,
+    Effect::HEAVY_CLICK,
+};
+
+static const EffectStrength kStrengths[] = {
+    EffectStrength::LIGHT, EffectStrength::MEDIUM, EffectStrength::STRONG,
+};
+
+/* Exact per-call latencies of one benchmark, unlike the bucketed HAL histograms */
+struct Result {
+    std::vector<int64_t> latenciesNs;
+    int64_t wallNs;
+    uint64_t failures;
+};
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-n iterations] [-c clients] [-s slots] [-l latency_us] "
+            "[-p play_ms] [-d]\n"
+            "  -n  calls per benchmark (default %d)\n"
+            "  -c  threads of the concurrent clients benchmark (default %d)\n"
+            "  -s  FF slots of the fake device\n"
+            "  -l  simulated EVIOCSFF/EVIOCRMFF latency in us\n"
+            "  -p  play length the fake device reports for effects\n"
+            "  -d  dump the HAL state at the end\n", prog, DEFAULT_ITERATIONS,
+            DEFAULT_CLIENTS);
+}
+
+static int64_t percentileNs(const std::vector<int64_t>& sorted, int percent) {
+    if (sorted.empty())
+        return 0;
+
+    return sorted[std::min(sorted.size() - 1, (sorted.size() * percent + 99) / 100 - 1)];
+}
+
+static void report(const char *name, Result& result) {
+    std::vector<int64_t>& ns = result.latenciesNs;
+
+    std::sort(ns.begin(), ns.end());
+    printf("%-16s calls=%-6zu p50=%6.1fus p99=%7.1fus max=%7.1fus %9.0f calls/s failures=%"
+           PRIu64 "\n", name, ns.size(), percentileNs(ns, 50) / 1000.0,
+           percentileNs(ns, 99) / 1000.0, ns.empty() ? 0.0 : ns.back() / 1000.0,
+           result.wallNs > 0 ? ns.size() * 1e9 / result.wallNs : 0.0, result.failures);
+}
+
+/* Run @call @iterations times from one thread, timing every call */
+template <typename Call>
+static void runSerial(Result *result, int iterations, Call call) {
+    int64_t startNs = nowNs();
+
+    result->latenciesNs.reserve(result->latenciesNs.size() + iterations);
+    for (int i = 0; i < iterations; i++) {
+        int64_t callNs = nowNs();
+        bool ok = call(i);
+
+        result->latenciesNs.push_back(nowNs() - callNs);
+        if (!ok)
+            result->failures++;
+    }
+    result->wallNs += nowNs() - startNs;
+}
+
+static Result benchPerform(const std::shared_ptr<Vibrator>& vib, int iterations) {
+    Result result = {};
+    int32_t playLengthMs;
+
+    runSerial(&result, iterations, [&](int i) {
+        return vib->perform(kEffects[i % std::size(kEffects)],
+                            kStrengths[(i / std::size(kEffects)) % std::size(kStrengths)],
+                            nullptr, &playLengthMs).isOk();
+    });
+    vib->off();
+    return result;
+}
+
+static Result benchOnOff(const std::shared_ptr<Vibrator>& vib, int iterations) {
+    Result result = {};
+
+    runSerial(&result, iterations, [&](int i) {
+        return (i & 1 ? vib->off() : vib->on(1000, nullptr)).isOk();
+    });
+    vib->off();
+    return result;
+}
+
+/* A ramp like the one the framework sends while a waveform plays */
+static Result benchAmplitude(const std::shared_ptr<Vibrator>& vib, int iterations) {
+    Result result = {};
+
+    vib->on(60000, nullptr);
+    runSerial(&result, iterations, [&](int i) {
+        return vib->setAmplitude((i % 255 + 1) / 255.0f).isOk();
+    });
+    vib->off();
+    return result;
+}
+
+/* Clients hammering the HAL at once, the way binder threads do */
+static Result benchConcurrent(const std::shared_ptr<Vibrator>& vib, int iterations,
+                              int clients) {
+    std::vector<Result> results(clients);
+    std::vector<std::thread> threads;
+    Result result = {};
+    int64_t startNs = nowNs();
+
+    for (int c = 0; c < clients; c++) {
+        threads.emplace_back([&, c] {
+            int32_t playLengthMs;
+
+            runSerial(&results[c], iterations / clients, [&](int i) {
+                switch ((i + c) % 4) {
+                case 0:
+                    return vib->perform(kEffects[i % std::size(kEffects)],
+                                        EffectStrength::STRONG, nullptr, &playLengthMs).isOk();
+                case 1:
+                    return vib->on(100, nullptr).isOk();
+                case 2:
+                    return vib->setAmplitude(0.5f).isOk();
+                default:
+                    return vib->off().isOk();
+                }
+            });
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+    result.wallNs = nowNs() - startNs;
+
+    for (const auto& r : results) {
+        result.latenciesNs.insert(result.latenciesNs.end(), r.latenciesNs.begin(),
+                                  r.latenciesNs.end());
+        result.failures += r.failures;
+    }
+
+    vib->off();
+    return result;
+}
+
+/** Skew of synced triggers across @fakes
+ *
+ *  Each round starts a click on every fake actuator through one synced trigger.
+ *  The skew is the spread of the kernel timestamps of the play events, so it is
+ *  reported in place of the call latency.
+ */
+static Result benchSynced(const std::shared_ptr<Vibrator>& vib,
+                          const std::vector<FakeFFDevice *>& fakes, int iterations) {
+    std::shared_ptr<VibratorManager> manager = ndk::SharedRefBase::make<VibratorManager>(vib);
+    std::vector<std::shared_ptr<Vibrator>> vibrators;
+    std::vector<uint64_t> plays;
+    std::vector<int32_t> ids, synced;
+    Result result = {};
+    int32_t playLengthMs;
+    int64_t startNs;
+
+    manager->getVibratorIds(&ids);
+    for (auto fake : fakes) {
+        for (auto id : ids) {
+            std::shared_ptr<IVibrator> other;
+
+            if (!manager->getVibrator(id, &other).isOk())
+                continue;
+            auto impl = std::static_pointer_cast<Vibrator>(other);
+            if (impl->ff.getDevicePath() == fake->getDevicePath()) {
+                synced.push_back(id);
+                vibrators.push_back(impl);
+            }
+        }
+        plays.push_back(fake->getStats().plays);
+    }
+
+    if (synced.size() != fakes.size()) {
+        fprintf(stderr, "the manager didn't pick up every fake device\n");
+        result.failures++;
+        return result;
+    }
+
+    startNs = nowNs();
+    for (int i = 0; i < iterations; i++) {
+        int64_t first = INT64_MAX;
+        int64_t last = 0;
+        bool ok = manager->prepareSynced(synced).isOk();
+
+        for (auto& other : vibrators)
+            ok = other->perform(Effect::CLICK, EffectStrength::STRONG, nullptr,
+                                &playLengthMs).isOk() && ok;
+        ok = manager->triggerSynced(nullptr).isOk() && ok;
+
+        for (size_t f = 0; f < fakes.size(); f++) {
+            ok = fakes[f]->waitForPlays(plays[f] + i + 1, SYNCED_PLAY_TIMEOUT_MS) && ok;
+            int64_t playNs = fakes[f]->getStats().lastPlayNs;
+            first = std::min(first, playNs);
+            last = std::max(last, playNs);
+        }
+
+        for (auto& other : vibrators)
+            other->off();
+
+        if (ok)
+            result.latenciesNs.push_back(last - first);
+        else
+            result.failures++;
+    }
+    result.wallNs = nowNs() - startNs;
+
+    return result;
+}
+
+/** Benchmark the HAL against a fake haptics device
+ *
+ *  The fake is a uinput FF device, so the real Vibrator, DeviceWorker and
+ *  InputFFDevice run unchanged down to the ioctls and writes. Needs access
+ *  to /dev/uinput, but no haptics hardware.
+ */
+int main(int argc, char **argv) {
+    FakeFFDevice::Config config = FakeFFDevice::defaultConfig();
+    int iterations = DEFAULT_ITERATIONS;
+    int clients = DEFAULT_CLIENTS;
+    bool dump = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:c:s:l:p:d")) != -1) {
+        switch (opt) {
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        case 'c':
+            clients = atoi(optarg);
+            break;
+        case 's':
+            config.slots = atoi(optarg);
+            break;
+        case 'l':
+            config.ioctlLatencyUs = atoll(optarg);
+            break;
+        case 'p':
+            config.playLengthMs = atoi(optarg);
+            break;
+        case 'd':
+            dump = true;
+            break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (optind != argc || iterations <= 0 || clients <= 0 || config.slots <= 0 ||
+            config.ioctlLatencyUs < 0 || config.playLengthMs < 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FakeFFDevice fake(config);
+    if (fake.getDevicePath().empty()) {
+        fprintf(stderr, "failed to create the fake haptics device, is uinput available?\n");
+        return EXIT_FAILURE;
+    }
+
+    std::shared_ptr<Vibrator> vib = ndk::SharedRefBase::make<Vibrator>(0, fake.getDevicePath());
+    if (vib->ff.getDevicePath() != fake.getDevicePath()) {
+        fprintf(stderr, "the HAL didn't open %s\n", fake.getDevicePath().c_str());
+        return EXIT_FAILURE;
+    }
+
+    printf("fake device %s: %d slots, %" PRId64 "us ioctl latency, %dms effects\n",
+           fake.getDevicePath().c_str(), config.slots, config.ioctlLatencyUs,
+           config.playLengthMs);
+
+    Result perform = benchPerform(vib, iterations);
+    Result onOff = benchOnOff(vib, iterations);
+    Result amplitude = benchAmplitude(vib, iterations);
+    Result concurrent = benchConcurrent(vib, iterations, clients);
+
+    report("perform", perform);
+    report("on/off", onOff);
+    report("setAmplitude", amplitude);
+    report("concurrent", concurrent);
+
+    FakeFFDevice::Stats stats = fake.getStats();
+    printf("device: uploads=%" PRIu64 " erases=%" PRIu64 " plays=%" PRIu64 " stops=%" PRIu64
+           " gains=%" PRIu64 "\n", stats.uploads, stats.erases, stats.plays, stats.stops,
+           stats.gains);
+
+    /* A second actuator for the synced triggers, picked up by the manager */
+    FakeFFDevice second(config);
+    Result synced = {};
+    if (second.getDevicePath().empty()) {
+        fprintf(stderr, "failed to create the second fake haptics device\n");
+        synced.failures++;
+    } else {
+        synced = benchSynced(vib, {&fake, &second}, iterations);
+    }
+    report("synced skew", synced);
+
+    if (dump) {
+        fflush(stdout);
+        vib->dump(STDOUT_FILENO, NULL, 0);
+    }
+
+    return perform.failures + onOff.failures + amplitude.failures + concurrent.failures +
+            synced.failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/vibrator/BnVibrator.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Stats.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+/*
+ * Delivers IVibratorCallback::onComplete() from a single thread driven by a
+ * timerfd. Only one completion is pending at a time: scheduling a new one or
+ * cancelling completes the pending callback right away, so every callback
+ * fires exactly once and in request order.
+ */
+class CompletionDispatcher {
+public:
+    struct Stats {
+        uint64_t scheduled;
+        uint64_t fired;
+        uint64_t superseded;
+        uint64_t late;
+        uint64_t maxLatenessUs;
+    };
+
+    CompletionDispatcher();
+    ~CompletionDispatcher();
+
+    void schedule(const std::shared_ptr<IVibratorCallback>& callback, long delayMs);
+    void cancel();
+    Stats getStats() const;
+    void dump(int fd) const;
+
+private:
+    struct Completion {
+        std::shared_ptr<IVibratorCallback> callback;
+        int64_t deadlineNs;
+    };
+
+    void supersedeLocked();
+    void armTimerLocked(int64_t deadlineNs);
+    void wake();
+    void threadLoop();
+
+    int mEpollFd;
+    int mTimerFd;
+    int mEventFd;
+    std::thread mThread;
+    std::mutex mLock;
+    bool mStopping;
+    bool mHasPending;
+    Completion mPending;
+    std::vector<std::shared_ptr<IVibratorCallback>> mReady;
+    std::atomic<uint64_t> mScheduled;
+    std::atomic<uint64_t> mFired;
+    std::atomic<uint64_t> mSuperseded;
+    std::atomic<uint64_t> mLate;
+    std::atomic<uint64_t> mMaxLatenessUs;
+    LatencyHistogram mLateness;
+};
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
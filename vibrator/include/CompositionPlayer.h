@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/vibrator/BnVibrator.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+class DeviceWorker;
+
+/*
+ * Plays a precomputed composition timeline on a realtime thread. Each step is
+ * started at an absolute offset from the beginning of the composition, so
+ * scheduling error does not accumulate across steps. Steps with a negative
+ * effectId play nothing and only hold the timeline, e.g. until the last
+ * primitive has finished.
+ */
+class CompositionPlayer {
+public:
+    struct Step {
+        int64_t startUs;
+        int effectId;
+        EffectStrength strength;
+        int16_t gain;
+    };
+
+    explicit CompositionPlayer(DeviceWorker& worker);
+    ~CompositionPlayer();
+
+    void play(std::vector<Step> timeline);
+    void stop();
+
+private:
+    void threadLoop();
+
+    DeviceWorker& mWorker;
+    /* Set when a step changed FF_GAIN, cleared once the gain is restored */
+    std::atomic<bool> mGainDirty;
+    std::atomic<bool> mActive;
+
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::vector<Step> mTimeline;
+    bool mPending;
+    bool mStopping;
+    std::atomic<uint64_t> mGeneration;
+    std::thread mThread;
+};
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/vibrator/BnVibrator.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+class InputFFDevice;
+
+/*
+ * Owns the InputFFDevice: every access to the device is queued as a command
+ * on a lock-free MPSC queue and executed by a single owner thread, which lets
+ * binder threads call in concurrently. Back-to-back setAmplitude() commands
+ * and back-to-back on()/off() commands are coalesced so only the last one of
+ * a run touches the fd.
+ */
+class DeviceWorker {
+public:
+    using Function = std::function<int(InputFFDevice&)>;
+
+    explicit DeviceWorker(InputFFDevice& ff);
+    ~DeviceWorker();
+
+    int on(int32_t timeoutMs);
+    int off();
+    int playEffect(int effectId, EffectStrength es, long *playLengthMs);
+    int setAmplitude(uint8_t amplitude);
+    int run(const Function& fn);
+    void pause();
+    void resume();
+
+    /* Device syscall time of the commands this thread submitted since the last call */
+    static int64_t takeDeviceNs();
+
+    uint64_t getExecutedCount() const { return mExecuted.load(std::memory_order_relaxed); }
+    uint64_t getCoalescedCount() const { return mCoalesced.load(std::memory_order_relaxed); }
+
+private:
+    struct Command {
+        enum Type {
+            STUB,
+            ON,
+            OFF,
+            PERFORM,
+            SET_AMPLITUDE,
+            CALL,
+            PAUSE,
+        };
+
+        explicit Command(Type t);
+
+        Type type;
+        int32_t timeoutMs;
+        int effectId;
+        EffectStrength strength;
+        uint8_t amplitude;
+        long playLengthMs;
+        int64_t deviceNs;
+        const Function *fn;
+        int result;
+        std::atomic<Command*> next;
+
+        std::mutex lock;
+        std::condition_variable cond;
+        bool done;
+    };
+
+    int submit(Command *cmd);
+    void push(Command *cmd);
+    Command *pop();
+    bool empty() const;
+    void complete(Command *cmd, int result);
+    void execute(Command *cmd);
+    void processBatch(std::vector<Command*>& batch);
+    void threadLoop();
+
+    InputFFDevice& mFF;
+
+    /* Vyukov intrusive MPSC queue: producers push at mHead, the owner pops at mTail */
+    std::atomic<Command*> mHead;
+    Command *mTail;
+    Command mStub;
+
+    /* Set between pause() and resume(), the owner thread is parked meanwhile */
+    std::mutex mPauseLock;
+    std::condition_variable mPauseCond;
+    bool mPaused;
+
+    std::atomic<bool> mSleeping;
+    std::atomic<bool> mStopping;
+    int mEventFd;
+    std::thread mThread;
+
+    std::atomic<uint64_t> mExecuted;
+    std::atomic<uint64_t> mCoalesced;
+};
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+/*
+ * A force feedback input device created through /dev/uinput, standing in for
+ * the haptics driver so the HAL can run on a machine without one. It carries
+ * a haptics name, so HapticsDiscovery picks it up like the real device.
+ *
+ * A thread of its own answers EVIOCSFF and EVIOCRMFF after the configured
+ * latency and counts the EV_FF events the HAL writes. Custom effects report
+ * their play length through custom_data like the QTI driver does, which only
+ * works for a HAL running in the same process as the fake device.
+ */
+class FakeFFDevice {
+public:
+    struct Config {
+        std::string name;
+        /* Driver slots, returned by EVIOCGEFFECTS */
+        int slots;
+        /* Time until an upload or erase is answered */
+        int64_t ioctlLatencyUs;
+        /* Play length reported for custom effects */
+        int32_t playLengthMs;
+        bool gain;
+    };
+
+    struct Stats {
+        uint64_t uploads;
+        uint64_t erases;
+        uint64_t plays;
+        uint64_t stops;
+        uint64_t gains;
+        /* Kernel timestamp of the last play event, CLOCK_MONOTONIC */
+        int64_t lastPlayNs;
+    };
+
+    static Config defaultConfig();
+
+    explicit FakeFFDevice(const Config& config);
+    ~FakeFFDevice();
+
+    /* The event node of the device, empty if it couldn't be created */
+    const std::string& getDevicePath() const { return mDevicePath; }
+    Stats getStats();
+    /* Wait until @plays play events arrived in total, false on timeout */
+    bool waitForPlays(uint64_t plays, int timeoutMs);
+
+private:
+    bool create();
+    std::string findEventNode();
+    void answerUpload(int32_t requestId);
+    void answerErase(int32_t requestId);
+    void threadLoop();
+
+    Config mConfig;
+    int mFd;
+    int mEventFd;
+    std::string mDevicePath;
+    std::thread mThread;
+
+    std::mutex mLock;
+    std::condition_variable mCond;
+    Stats mStats;
+};
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <linux/input.h>
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+#include "Stats.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+/*
+ * Driver specific side of a haptics device, picked once when its input node is
+ * opened. Effects always go through the generic FF interface; a backend adds
+ * what a particular chip offers beyond it, such as streaming raw waveforms.
+ */
+class HapticsBackend {
+public:
+    explicit HapticsBackend(const char *name);
+    virtual ~HapticsBackend() {}
+
+    /* Backend for the driver behind the input node @devicePath */
+    static std::unique_ptr<HapticsBackend> probe(const std::string& devicePath);
+    /* Backend for the driver @name with its attributes in @sysfsDir */
+    static std::unique_ptr<HapticsBackend> create(const std::string& name,
+                                                  const std::string& sysfsDir);
+
+    const char *name() const { return mName; }
+
+    /* Whether stream() can play signed 8 bit PCM at streamRateHz() */
+    virtual bool canStream() const { return false; }
+    virtual int32_t streamRateHz() const { return 0; }
+    /* Resonant frequency of the actuator, 0 if the driver doesn't report it */
+    virtual int32_t resonantHz() const { return 0; }
+    virtual int stream(const int8_t *, size_t) { return -1; }
+    virtual int stopStream() { return 0; }
+    /* Rate of the waveforms customEffect() takes, 0 if the driver takes none */
+    virtual int32_t customRateHz() const { return 0; }
+    /* Point @effect at a raw waveform, valid until the next call */
+    virtual void customEffect(struct ff_effect *, const int8_t *, size_t) {}
+    virtual void dump(int fd);
+
+private:
+    const char *mName;
+};
+
+/*
+ * Qualcomm PMIC haptics. Effects uploaded with a custom_data payload that is
+ * larger than the predefined effect header are played from the FIFO of the
+ * haptics module, at a fixed play rate.
+ */
+class QcomHvBackend : public HapticsBackend {
+public:
+    QcomHvBackend();
+
+    int32_t customRateHz() const override;
+    void customEffect(struct ff_effect *effect, const int8_t *samples, size_t count) override;
+
+private:
+    /* Layout the driver expects behind custom_data for FIFO effects */
+    struct CustomFifoData {
+        uint32_t idx;
+        uint32_t length;
+        uint32_t playRateHz;
+        const int8_t *data;
+    };
+
+    CustomFifoData mFifo;
+};
+
+/*
+ * Awinic AW8697. Besides the FF effects in its RAM, the chip has a real-time
+ * playback FIFO that the driver fills from the custom_wave attribute. A whole
+ * waveform is pushed down in page sized writes and played back by the chip.
+ */
+class Aw8697Backend : public HapticsBackend {
+public:
+    explicit Aw8697Backend(const std::string& sysfsDir);
+    ~Aw8697Backend();
+
+    bool canStream() const override { return mWaveFd >= 0; }
+    int32_t streamRateHz() const override;
+    int32_t resonantHz() const override { return mResonantHz; }
+    int stream(const int8_t *samples, size_t count) override;
+    int stopStream() override;
+    void dump(int fd) override;
+
+private:
+    std::string mSysfsDir;
+    int mWaveFd;
+    int32_t mResonantHz;
+    uint64_t mStreams;
+    uint64_t mStreamBytes;
+    LatencyHistogram mStreamLatency;
+    ErrorCounter mErrors;
+};
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
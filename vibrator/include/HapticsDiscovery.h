@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+/*
+ * Locates the haptics input devices without opening every node under
+ * /dev/input, and watches /dev/input so a device can be re-acquired after
+ * its driver is reloaded. Each node is claimed by at most one InputFFDevice.
+ */
+class HapticsDiscovery {
+public:
+    using Callback = std::function<void(const std::string& devicePath, bool added)>;
+
+    HapticsDiscovery();
+    ~HapticsDiscovery();
+
+    static std::string findDevice();
+    static std::vector<std::string> findDevices();
+    static bool claim(const std::string& devicePath);
+    static void release(const std::string& devicePath);
+    static bool isHapticsNode(const std::string& devicePath);
+    static std::string sysfsDir(const std::string& devicePath);
+    static void rememberDevice(const std::string& devicePath);
+    static int readSysfs(const char *path, char *buf, size_t len);
+
+    void startWatching(Callback callback);
+
+private:
+    void threadLoop();
+
+    int mInotifyFd;
+    int mEventFd;
+    Callback mCallback;
+    std::thread mThread;
+};
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
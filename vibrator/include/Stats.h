@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+#include "Utils.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+/*
+ * Lock-free latency histogram with power-of-two microsecond buckets. Bucket 0
+ * holds samples below 1us, bucket i samples in [2^(i-1), 2^i) us.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int kBuckets = 24;
+
+    LatencyHistogram();
+    void record(int64_t ns);
+    void dump(int fd, const char *name) const;
+
+private:
+    int64_t percentileUs(uint64_t count, int percent) const;
+
+    std::atomic<uint64_t> mBuckets[kBuckets];
+    std::atomic<uint64_t> mCount;
+    std::atomic<uint64_t> mSumUs;
+    std::atomic<uint64_t> mMaxUs;
+};
+
+/* Counts failures by errno */
+class ErrorCounter {
+public:
+    static constexpr int kMaxErrno = 134;
+
+    ErrorCounter();
+    void record(int err);
+    void dump(int fd) const;
+
+private:
+    std::atomic<uint32_t> mCounts[kMaxErrno + 1];
+};
+
+/*
+ * Records the time spent in the enclosing scope into a histogram, and adds it
+ * to @totalNs as well if one is given
+ */
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyHistogram& histogram, int64_t *totalNs = NULL)
+        : mHistogram(histogram), mTotalNs(totalNs), mStartNs(nowNs()) {}
+    ~ScopedLatency() {
+        int64_t ns = nowNs() - mStartNs;
+
+        mHistogram.record(ns);
+        if (mTotalNs != NULL)
+            *mTotalNs += ns;
+    }
+
+private:
+    LatencyHistogram& mHistogram;
+    int64_t *mTotalNs;
+    int64_t mStartNs;
+};
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
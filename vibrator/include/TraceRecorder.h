@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android/binder_auto_utils.h>
+#include <atomic>
+#include <stdint.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+#define TRACE_MAGIC             0x56545243  /* "VTRC" */
+#define TRACE_VERSION           1
+#define TRACE_CAPACITY          16384       /* records */
+
+enum TraceCall : uint16_t {
+    TRACE_ON = 1,
+    TRACE_OFF,
+    TRACE_PERFORM,
+    TRACE_SET_AMPLITUDE,
+    TRACE_SET_EXTERNAL_CONTROL,
+};
+
+/*
+ * One HAL call. Arguments are, by call: on: timeoutMs; perform: effect and
+ * strength; setAmplitude: the float amplitude bits; setExternalControl: the
+ * enabled flag. seq is stored last, a record with seq 0 was never completed.
+ */
+struct TraceRecord {
+    uint64_t seq;
+    int64_t startNs;        /* CLOCK_MONOTONIC */
+    uint32_t durationUs;    /* time spent in the HAL call */
+    uint32_t deviceUs;      /* time spent in device syscalls for the call */
+    uint16_t call;
+    int16_t result;         /* binder exception code */
+    int32_t args[2];
+};
+
+/* Part of the file format, a layout change needs a new TRACE_VERSION */
+static_assert(sizeof(TraceRecord) == 40, "unexpected trace record layout");
+
+/*
+ * Trace file layout: the header, followed by TRACE_CAPACITY records used as a
+ * ring. Record n (1-based seq) lives at index (n - 1) % capacity.
+ */
+struct TraceHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t recordSize;
+    std::atomic<uint64_t> next;
+    uint64_t reserved[5];
+};
+
+/* Records are not padded, only the first one starts on a cache line */
+static_assert(sizeof(TraceHeader) == 64, "the first record must start on a cache line");
+
+/*
+ * Appends HAL calls to an mmap'd ring file. Recording is lock-free, a call
+ * costs a fetch_add and a few stores, and is a no-op until open() succeeded.
+ */
+class TraceRecorder {
+public:
+    TraceRecorder();
+    ~TraceRecorder();
+
+    bool open(const char *path);
+    bool enabled() const { return mRecords != NULL; }
+    void record(TraceCall call, int64_t startNs, int64_t durationNs, int64_t deviceNs,
+                int32_t result, int32_t arg0, int32_t arg1);
+    uint64_t count() const;
+
+private:
+    TraceHeader *mHeader;
+    TraceRecord *mRecords;
+    size_t mSize;
+};
+
+/** Records the enclosing HAL call on destruction
+ *
+ *  Error paths return through status() so the exception code is recorded
+ *  together with the call.
+ */
+class ScopedTrace {
+public:
+    ScopedTrace(TraceRecorder& recorder, TraceCall call, int32_t arg0 = 0, int32_t arg1 = 0);
+    ~ScopedTrace();
+
+    ndk::ScopedAStatus status(int32_t exception);
+
+private:
+    TraceRecorder& mRecorder;
+    TraceCall mCall;
+    int32_t mArgs[2];
+    int32_t mResult;
+    int64_t mStartNs;
+};
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -30,6 +30,21 @@
 #pragma once
 
 #include <aidl/android/hardware/vibrator/BnVibrator.h>
+#include <atomic>
+#include <linux/input.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "CompletionDispatcher.h"
+#include "CompositionPlayer.h"
+#include "DeviceWorker.h"
+#include "HapticsBackend.h"
+#include "HapticsDiscovery.h"
+#include "Stats.h"
+#include "TraceRecorder.h"
+#include "WaveformSynth.h"
 
 namespace aidl {
 namespace android {
@@ -38,24 +53,120 @@ namespace vibrator {
 
 class InputFFDevice {
 public:
-    InputFFDevice();
+    struct GainStats {
+        uint64_t calls;
+        uint64_t deduplicated;
+        uint64_t deferred;
+        uint64_t writes;
+        uint64_t batched;
+    };
+
+    explicit InputFFDevice(const std::string& devicePath);
+    ~InputFFDevice();
+    void loadEffects(const std::vector<Effect>& effects);
+    void onHotplug(const std::string& devicePath, bool added);
     int playEffect(int effectId, EffectStrength es, long *playLengthMs);
+    int playPrimitive(int effectId, EffectStrength es, int16_t gain);
+    int restoreGain();
+    int streamWaveform(const int8_t *samples, size_t count);
+    int32_t getStreamRateHz();
+    int32_t getResonantHz();
+    int alwaysOnEnable(int32_t id, int effectId, EffectStrength es);
+    int alwaysOnDisable(int32_t id);
+    int alwaysOnTrigger(int32_t id, long *playLengthMs);
+    void prepareSynced();
+    int triggerSynced();
+    void cancelSynced();
+    long getPlayLengthMs(int effectId, EffectStrength es);
     int on(int32_t timeoutMs);
     int off();
     int setAmplitude(uint8_t amplitude);
-    bool mSupportGain;
-    bool mSupportEffects;
-    bool mSupportExternalControl;
-    bool mInExternalControl;
+    int64_t gainDeadlineNs();
+    void flushPendingGain();
+    GainStats getGainStats();
+    /* Total time spent in device syscalls, only read on the worker thread */
+    int64_t getSyscallNs() const { return mSyscallNs; }
+    /* A copy, binder threads call it while a hotplug may reassign the path */
+    std::string getDevicePath() const;
+    void dump(int fd);
+    std::atomic<bool> mSupportGain;
+    std::atomic<bool> mSupportEffects;
+    std::atomic<bool> mSupportExternalControl;
+    std::atomic<bool> mSupportStreaming;
+    std::atomic<bool> mInExternalControl;
+    int64_t mDiscoveryUs;
 private:
+    /* A predefined effect kept resident in one of the driver's FF slots */
+    struct EffectSlot {
+        int effectId;
+        EffectStrength strength;
+        int16_t id;
+        long playLengthMs;
+        uint64_t lastUsed;
+    };
+
+    /* An effect pinned to an always-on ID, never evicted */
+    struct AlwaysOnSlot {
+        int32_t id;
+        EffectSlot slot;
+    };
+
+    bool openDevice(const std::string& devicePath);
+    void closeDevice();
+    void uploadEffects();
     int play(int effectId, uint32_t timeoutMs, long *playLengthMs);
+    int playSlot(EffectSlot *slot, int32_t gain, long *playLengthMs);
+    int fireStaged();
+    int uploadSlot(EffectSlot *slot, bool evict);
+    int stopCurrent();
+    int stopStream();
+    int uploadEffect(struct ff_effect *effect);
+    int eraseEffect(int16_t id);
+    int writeEvents(const struct input_event *events, int count);
+    int queueGain(int32_t gain);
+    bool evictLruSlot();
+    int releaseSlot(EffectSlot *slot);
+    int residentSlots();
+    EffectSlot *findSlot(int effectId, EffectStrength es);
+    AlwaysOnSlot *findAlwaysOn(int32_t id);
     int mVibraFd;
+    /* Only written on the worker thread, under mPathLock for readers on other threads */
+    mutable std::mutex mPathLock;
+    std::string mDevicePath;
+    /* Chip specific features of the driver, probed on open */
+    std::unique_ptr<HapticsBackend> mBackend;
+    bool mStreaming;
     int16_t mCurrAppId;
+    bool mCurrAppIdResident;
     int16_t mCurrMagnitude;
+    int32_t mCurrGain;
+    int32_t mWrittenGain;
+    int32_t mPendingGain;
+    int64_t mLastGainNs;
+    int64_t mGainIntervalNs;
+    GainStats mGainStats;
+    LatencyHistogram mUploadLatency;
+    LatencyHistogram mEraseLatency;
+    LatencyHistogram mWriteLatency;
+    int64_t mSyscallNs;
+    ErrorCounter mErrors;
+    uint64_t mLruClock;
+    int mMaxResident;
+    std::vector<EffectSlot> mEffectSlots;
+    std::vector<AlwaysOnSlot> mAlwaysOnSlots;
+    /* Events of the last play, written right away unless a synced trigger holds them */
+    struct input_event mStaged[2];
+    int mStagedCount;
+    bool mSyncHold;
 };
 
+class VibratorManager;
+
 class Vibrator : public BnVibrator {
 public:
+    Vibrator();
+    Vibrator(int32_t id, const std::string& devicePath);
+    ~Vibrator();
     class InputFFDevice ff;
     ndk::ScopedAStatus getCapabilities(int32_t* _aidl_return) override;
     ndk::ScopedAStatus off() override;
@@ -77,6 +188,58 @@ public:
     ndk::ScopedAStatus getSupportedAlwaysOnEffects(std::vector<Effect>* _aidl_return) override;
     ndk::ScopedAStatus alwaysOnEnable(int32_t id, Effect effect, EffectStrength strength) override;
     ndk::ScopedAStatus alwaysOnDisable(int32_t id) override;
+    ndk::ScopedAStatus getResonantFrequency(float* resonantFreqHz) override;
+    ndk::ScopedAStatus getQFactor(float* qFactor) override;
+    ndk::ScopedAStatus getFrequencyResolution(float* freqResolutionHz) override;
+    ndk::ScopedAStatus getFrequencyMinimum(float* freqMinimumHz) override;
+    ndk::ScopedAStatus getBandwidthAmplitudeMap(std::vector<float>* _aidl_return) override;
+    ndk::ScopedAStatus getPwlePrimitiveDurationMax(int32_t* durationMs) override;
+    ndk::ScopedAStatus getPwleCompositionSizeMax(int32_t* maxSize) override;
+    ndk::ScopedAStatus getSupportedBraking(std::vector<Braking>* supported) override;
+    ndk::ScopedAStatus composePwle(const std::vector<PrimitivePwle>& composite,
+                                   const std::shared_ptr<IVibratorCallback>& callback) override;
+    binder_status_t dump(int fd, const char** args, uint32_t numArgs) override;
+private:
+    friend class VibratorManager;
+
+    struct PrimitiveInfo {
+        CompositePrimitive primitive;
+        int effectId;
+        int32_t durationMs;
+    };
+
+    const PrimitiveInfo *findPrimitive(CompositePrimitive primitive);
+    void watchFodUi();
+    int triggerAlwaysOn(int32_t id);
+    void prepareSynced();
+    void stageSynced(const std::shared_ptr<IVibratorCallback>& callback, int32_t durationMs);
+    int32_t finishSynced();
+    void cancelSynced();
+    int32_t mId;
+    std::vector<PrimitiveInfo> mPrimitives;
+    int64_t mPreloadUs;
+    LatencyHistogram mOnLatency;
+    LatencyHistogram mOffLatency;
+    LatencyHistogram mPerformLatency;
+    LatencyHistogram mAmplitudeLatency;
+    LatencyHistogram mComposeLatency;
+    TraceRecorder mTrace;
+    DeviceWorker mWorker;
+    CompletionDispatcher mCompletion;
+    CompositionPlayer mComposer;
+    WaveformSynth mSynth;
+    HapticsDiscovery mDiscovery;
+
+    /* fod_ui watch that triggers always-on ID 0, mFodDown is owned by the watch thread */
+    int mFodWatch;
+    std::string mFodUiPath;
+    bool mFodDown;
+
+    /* Completion of the play staged for the next synced trigger */
+    std::mutex mSyncLock;
+    std::atomic<bool> mSyncPrepared;
+    std::shared_ptr<IVibratorCallback> mSyncCallback;
+    int32_t mSyncDurationMs;
 };
 
 }  // namespace vibrator
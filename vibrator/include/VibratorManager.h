@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/vibrator/BnVibratorManager.h>
+#include <mutex>
+#include <vector>
+
+#include "CompletionDispatcher.h"
+#include "Stats.h"
+#include "Vibrator.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+/*
+ * Exposes every haptics input device as its own vibrator. The default vibrator
+ * keeps ID 0, the other actuators follow in event node order.
+ *
+ * Synced plays are staged on each actuator first, up to the final write. On
+ * trigger the device workers of the prepared actuators are paused and the
+ * staged events are written back to back from the calling thread, one writev()
+ * per device, so the skew between actuators is the cost of a single write.
+ */
+class VibratorManager : public BnVibratorManager {
+public:
+    explicit VibratorManager(std::shared_ptr<Vibrator> defaultVibrator);
+
+    ndk::ScopedAStatus getCapabilities(int32_t* _aidl_return) override;
+    ndk::ScopedAStatus getVibratorIds(std::vector<int32_t>* _aidl_return) override;
+    ndk::ScopedAStatus getVibrator(int32_t vibratorId,
+                                   std::shared_ptr<IVibrator>* _aidl_return) override;
+    ndk::ScopedAStatus prepareSynced(const std::vector<int32_t>& vibratorIds) override;
+    ndk::ScopedAStatus triggerSynced(const std::shared_ptr<IVibratorCallback>& callback) override;
+    ndk::ScopedAStatus cancelSynced() override;
+    binder_status_t dump(int fd, const char** args, uint32_t numArgs) override;
+
+private:
+    std::vector<std::shared_ptr<Vibrator>> mVibrators;
+
+    std::mutex mLock;
+    std::vector<std::shared_ptr<Vibrator>> mPrepared;
+    CompletionDispatcher mCompletion;
+    LatencyHistogram mSkew;
+};
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "Stats.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace vibrator {
+
+/*
+ * Shape of a synthesized waveform: a tone sweeping linearly from startHz to
+ * endHz, whose amplitude follows a linear curve from startAmp to endAmp and
+ * is shaped by a linear attack and decay. Amplitudes are in [0, 1].
+ */
+struct WaveformParams {
+    int32_t rateHz;
+    int32_t durationMs;
+    int32_t attackMs;
+    int32_t decayMs;
+    float startHz;
+    float endHz;
+    float startAmp;
+    float endAmp;
+};
+
+/*
+ * Renders WaveformParams into signed 8 bit PCM for the drivers that take raw
+ * waveforms. Rendered waveforms are kept in an LRU cache keyed by a hash of
+ * their parameters, so a repeated effect costs a lookup instead of a render.
+ */
+class WaveformSynth {
+public:
+    using Waveform = std::shared_ptr<const std::vector<int8_t>>;
+
+    WaveformSynth();
+
+    Waveform render(const WaveformParams& params);
+    void dump(int fd);
+
+private:
+    struct Entry {
+        uint64_t hash;
+        WaveformParams params;
+        Waveform waveform;
+    };
+
+    std::mutex mLock;
+    std::list<Entry> mLru;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> mIndex;
+    size_t mCachedBytes;
+    uint64_t mHits;
+    uint64_t mMisses;
+    uint64_t mEvictions;
+    LatencyHistogram mRenderLatency;
+};
+
+}  // namespace vibrator
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
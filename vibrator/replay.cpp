@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <android/binder_manager.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "FakeFFDevice.h"
+#include "Stats.h"
+#include "TraceRecorder.h"
+#include "Utils.h"
+#include "Vibrator.h"
+
+using namespace aidl::android::hardware::vibrator;
+
+static const char *kCallNames[] = {
+    "", "on", "off", "perform", "setAmplitude", "setExternalControl",
+};
+
+#define CALL_COUNT      (sizeof(kCallNames) / sizeof(kCallNames[0]))
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-l | -f] [-s speed] <trace>\n"
+            "  -l        replay against the running HAL service\n"
+            "            (default: an in-process HAL on the local haptics device)\n"
+            "  -f        replay against an in-process HAL on a uinput fake device,\n"
+            "            for a machine without haptics hardware\n"
+            "  -s speed  time scale, 2 replays twice as fast, 0 back to back\n", prog);
+}
+
+/* Valid records of a trace file, oldest first */
+static bool loadTrace(const char *path, std::vector<TraceRecord> *records) {
+    TraceHeader header;
+    TraceRecord rec;
+    int fd;
+
+    fd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_CLOEXEC));
+    if (fd < 0) {
+        fprintf(stderr, "open %s failed: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    if (TEMP_FAILURE_RETRY(read(fd, &header, sizeof(header))) != sizeof(header) ||
+            header.magic != TRACE_MAGIC || header.version != TRACE_VERSION ||
+            header.recordSize != sizeof(TraceRecord)) {
+        fprintf(stderr, "%s is not a vibrator trace\n", path);
+        close(fd);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.capacity; i++) {
+        if (TEMP_FAILURE_RETRY(read(fd, &rec, sizeof(rec))) != sizeof(rec))
+            break;
+        if (rec.seq != 0 && rec.call > 0 && rec.call < CALL_COUNT)
+            records->push_back(rec);
+    }
+    close(fd);
+
+    std::sort(records->begin(), records->end(),
+              [](const TraceRecord& a, const TraceRecord& b) { return a.seq < b.seq; });
+    return true;
+}
+
+static int32_t issue(const std::shared_ptr<IVibrator>& vib, const TraceRecord& rec) {
+    ndk::ScopedAStatus status;
+    int32_t playLengthMs;
+    float amplitude;
+
+    switch (rec.call) {
+    case TRACE_ON:
+        status = vib->on(rec.args[0], nullptr);
+        break;
+    case TRACE_OFF:
+        status = vib->off();
+        break;
+    case TRACE_PERFORM:
+        status = vib->perform(static_cast<Effect>(rec.args[0]),
+                              static_cast<EffectStrength>(rec.args[1]), nullptr,
+                              &playLengthMs);
+        break;
+    case TRACE_SET_AMPLITUDE:
+        memcpy(&amplitude, &rec.args[0], sizeof(amplitude));
+        status = vib->setAmplitude(amplitude);
+        break;
+    case TRACE_SET_EXTERNAL_CONTROL:
+        status = vib->setExternalControl(rec.args[0] != 0);
+        break;
+    }
+
+    return status.getExceptionCode();
+}
+
+/** Re-issue a recorded trace with its original timing
+ *
+ *  Calls are replayed from a single thread, so calls that overlapped in the
+ *  capture are serialized. Recorded and replayed latencies are printed per
+ *  call together with the number of calls whose result changed.
+ */
+int main(int argc, char **argv) {
+    std::unique_ptr<FakeFFDevice> fake;
+    std::shared_ptr<IVibrator> vib;
+    std::vector<TraceRecord> records;
+    LatencyHistogram recorded[CALL_COUNT];
+    LatencyHistogram replayed[CALL_COUNT];
+    double speed = 1.0;
+    bool live = false;
+    bool useFake = false;
+    uint64_t mismatches = 0;
+    int64_t baseNs;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "lfs:")) != -1) {
+        switch (opt) {
+        case 'l':
+            live = true;
+            break;
+        case 'f':
+            useFake = true;
+            break;
+        case 's':
+            speed = atof(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (optind != argc - 1 || speed < 0 || (live && useFake)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!loadTrace(argv[optind], &records))
+        return EXIT_FAILURE;
+    if (records.empty()) {
+        fprintf(stderr, "trace is empty\n");
+        return EXIT_FAILURE;
+    }
+
+    if (live) {
+        const std::string instance = std::string() + IVibrator::descriptor + "/default";
+        vib = IVibrator::fromBinder(ndk::SpAIBinder(
+                AServiceManager_waitForService(instance.c_str())));
+    } else if (useFake) {
+        fake = std::make_unique<FakeFFDevice>(FakeFFDevice::defaultConfig());
+        if (fake->getDevicePath().empty()) {
+            fprintf(stderr, "failed to create the fake haptics device, is uinput available?\n");
+            return EXIT_FAILURE;
+        }
+        vib = ndk::SharedRefBase::make<Vibrator>(0, fake->getDevicePath());
+    } else {
+        vib = ndk::SharedRefBase::make<Vibrator>();
+    }
+    if (vib == nullptr) {
+        fprintf(stderr, "no vibrator HAL\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("replaying %zu calls (%s)\n", records.size(),
+           live ? "live" : useFake ? fake->getDevicePath().c_str() : "in-process");
+
+    baseNs = nowNs();
+    for (const auto& rec : records) {
+        if (speed > 0) {
+            int64_t targetNs = baseNs + (rec.startNs - records[0].startNs) / speed;
+            struct timespec ts = {
+                .tv_sec = static_cast<time_t>(targetNs / 1000000000LL),
+                .tv_nsec = static_cast<long>(targetNs % 1000000000LL),
+            };
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+        }
+
+        int64_t startNs = nowNs();
+        int32_t result = issue(vib, rec);
+        replayed[rec.call].record(nowNs() - startNs);
+        recorded[rec.call].record(rec.durationUs * 1000LL);
+        if (result != rec.result)
+            mismatches++;
+    }
+
+    printf("recorded:\n");
+    fflush(stdout);
+    for (size_t i = 1; i < CALL_COUNT; i++)
+        recorded[i].dump(STDOUT_FILENO, kCallNames[i]);
+    printf("replayed:\n");
+    fflush(stdout);
+    for (size_t i = 1; i < CALL_COUNT; i++)
+        replayed[i].dump(STDOUT_FILENO, kCallNames[i]);
+    printf("result mismatches: %" PRIu64 "\n", mismatches);
+    if (fake != nullptr) {
+        FakeFFDevice::Stats stats = fake->getStats();
+        printf("device: uploads=%" PRIu64 " erases=%" PRIu64 " plays=%" PRIu64 " stops=%"
+               PRIu64 " gains=%" PRIu64 "\n", stats.uploads, stats.erases, stats.plays,
+               stats.stops, stats.gains);
+    }
+
+    vib->off();
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -34,17 +34,26 @@
 #include <android/binder_process.h>
 
 #include "Vibrator.h"
+#include "VibratorManager.h"
 
 using aidl::android::hardware::vibrator::Vibrator;
+using aidl::android::hardware::vibrator::VibratorManager;
 
 int main() {
-    ABinderProcess_setThreadPoolMaxThreadCount(0);
+    // Let concurrent clients in, device access is serialized by the HAL itself
+    ABinderProcess_setThreadPoolMaxThreadCount(4);
     std::shared_ptr<Vibrator> vib = ndk::SharedRefBase::make<Vibrator>();
 
     const std::string instance = std::string() + Vibrator::descriptor + "/default";
     binder_status_t status = AServiceManager_addService(vib->asBinder().get(), instance.c_str());
     CHECK(status == STATUS_OK);
 
+    std::shared_ptr<VibratorManager> manager = ndk::SharedRefBase::make<VibratorManager>(vib);
+    const std::string managerInstance = std::string() + VibratorManager::descriptor + "/default";
+    status = AServiceManager_addService(manager->asBinder().get(), managerInstance.c_str());
+    CHECK(status == STATUS_OK);
+
+    ABinderProcess_startThreadPool();
     ABinderProcess_joinThreadPool();
     return EXIT_FAILURE;  // should not reach
 }
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "FakeFFDevice.h"
+#include "Utils.h"
+#include "Vibrator.h"
+#include "VibratorManager.h"
+
+using namespace aidl::android::hardware::vibrator;
+
+#define ACTUATORS               2
+#define ROUNDS                  200
+#define PLAY_TIMEOUT_MS         1000
+
+/*
+ * Synced triggers against uinput fake actuators. The fake devices record the
+ * kernel timestamp of every play event, so the tests check what the drivers
+ * would see. The skew between the actuators depends on the scheduler and is
+ * reported by the benchmark rather than checked here.
+ */
+class SyncedTriggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (int i = 0; i < ACTUATORS; i++) {
+            mFakes.push_back(std::make_unique<FakeFFDevice>(FakeFFDevice::defaultConfig()));
+            if (mFakes.back()->getDevicePath().empty())
+                GTEST_SKIP() << "no /dev/uinput";
+        }
+
+        mManager = ndk::SharedRefBase::make<VibratorManager>(
+                ndk::SharedRefBase::make<Vibrator>(0, mFakes[0]->getDevicePath()));
+
+        /* The manager picks up the other fake devices through discovery */
+        std::vector<int32_t> ids;
+        ASSERT_TRUE(mManager->getVibratorIds(&ids).isOk());
+        for (const auto& fake : mFakes) {
+            for (auto id : ids) {
+                std::shared_ptr<IVibrator> vib;
+
+                ASSERT_TRUE(mManager->getVibrator(id, &vib).isOk());
+                auto impl = std::static_pointer_cast<Vibrator>(vib);
+                if (impl->ff.getDevicePath() == fake->getDevicePath()) {
+                    mIds.push_back(id);
+                    mVibrators.push_back(impl);
+                }
+            }
+        }
+        ASSERT_EQ(mIds.size(), mFakes.size());
+    }
+
+    /* Play @start on every actuator through one synced trigger */
+    template <typename Start>
+    void triggerRound(uint64_t round, Start start) {
+        int64_t triggerNs;
+
+        ASSERT_TRUE(mManager->prepareSynced(mIds).isOk());
+        for (auto& vib : mVibrators)
+            ASSERT_TRUE(start(vib).isOk());
+
+        /* Event timestamps only have microseconds */
+        triggerNs = nowNs() / 1000 * 1000;
+        ASSERT_TRUE(mManager->triggerSynced(nullptr).isOk());
+
+        for (auto& fake : mFakes) {
+            ASSERT_TRUE(fake->waitForPlays(round + 1, PLAY_TIMEOUT_MS));
+            EXPECT_GE(fake->getStats().lastPlayNs, triggerNs);
+        }
+
+        for (auto& vib : mVibrators)
+            vib->off();
+    }
+
+    std::vector<std::unique_ptr<FakeFFDevice>> mFakes;
+    std::shared_ptr<VibratorManager> mManager;
+    std::vector<int32_t> mIds;
+    std::vector<std::shared_ptr<Vibrator>> mVibrators;
+};
+
+TEST_F(SyncedTriggerTest, PerformPlaysAfterTrigger) {
+    int32_t playLengthMs;
+
+    for (uint64_t round = 0; round < ROUNDS && !HasFatalFailure(); round++) {
+        triggerRound(round, [&](std::shared_ptr<Vibrator>& vib) {
+            return vib->perform(Effect::CLICK, EffectStrength::STRONG, nullptr, &playLengthMs);
+        });
+    }
+}
+
+TEST_F(SyncedTriggerTest, OnPlaysAfterTrigger) {
+    for (uint64_t round = 0; round < ROUNDS && !HasFatalFailure(); round++) {
+        triggerRound(round, [](std::shared_ptr<Vibrator>& vib) {
+            return vib->on(100, nullptr);
+        });
+    }
+}
+
+TEST_F(SyncedTriggerTest, NothingPlaysBeforeTrigger) {
+    int32_t playLengthMs;
+
+    ASSERT_TRUE(mManager->prepareSynced(mIds).isOk());
+    for (auto& vib : mVibrators)
+        ASSERT_TRUE(vib->perform(Effect::CLICK, EffectStrength::STRONG, nullptr,
+                                 &playLengthMs).isOk());
+
+    for (auto& fake : mFakes)
+        EXPECT_EQ(fake->getStats().plays, 0u);
+
+    ASSERT_TRUE(mManager->cancelSynced().isOk());
+}